@@ -0,0 +1,216 @@
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+extern "C" {
+#include <getopt.h>
+}
+
+#include "bench.h"
+
+static const void * volatile sink = NULL;
+
+void doNotOptimize (const void *p) {
+    sink = p;
+}
+
+const char * dist2str (Distribution d) {
+    switch (d) {
+        case DIST_UNIFORM: return "uniform";
+        case DIST_NORMAL: return "normal";
+        case DIST_MULTI_MODE: return "multi_mode";
+        default: return "MISSING DISTRIBUTION CASE";
+    }
+    return "DISTRIBUTION SWITCH FAIL";
+}
+
+void synthetic (Distribution d, std::size_t n, std::vector< Point >& pts) {
+    /* fixed seed so every run sees the same data */
+    std::mt19937_64 gen (42);
+    std::uniform_real_distribution< FloatType > uniform (0.0, 100.0);
+    std::normal_distribution< FloatType > normal (50.0, 15.0);
+    std::uniform_int_distribution< int > mode (0, 5);
+
+    /* clusters roughly like those in data/multi_mode.csv */
+    std::normal_distribution< FloatType > modes[3][2] = {
+        { std::normal_distribution< FloatType >(30.0, 10.0),
+          std::normal_distribution< FloatType >(20.0, 5.0) },
+        { std::normal_distribution< FloatType >(60.0, 20.0),
+          std::normal_distribution< FloatType >(50.0, 10.0) },
+        { std::normal_distribution< FloatType >(90.0, 8.0),
+          std::normal_distribution< FloatType >(80.0, 8.0) }
+    };
+
+    pts.clear ();
+    pts.reserve (n);
+    for (std::size_t i = 0; i < n; ++i) {
+        switch (d) {
+            case DIST_UNIFORM:
+                pts.push_back (Point (uniform (gen), uniform (gen)));
+                break;
+            case DIST_NORMAL:
+                pts.push_back (Point (normal (gen), normal (gen)));
+                break;
+            case DIST_MULTI_MODE: {
+                /* 1/6 in the first mode, 4/6 in the second, 1/6 third */
+                int m = mode (gen);
+                int k = (0 == m) ? 0 : ((5 == m) ? 2 : 1);
+                FloatType x = modes[k][0] (gen);
+                FloatType y = modes[k][1] (gen);
+                pts.push_back (Point (x, y));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+BenchRunner::BenchRunner (const BenchOptions& opts, FILE *out) : 
+    opts_(opts), out_(out), first_(true) {
+    char date[64] = {0};
+    time_t now = time (NULL);
+    strftime (date, 64, "%Y-%m-%dT%H:%M:%S", localtime (&now));
+    fprintf (out_, "{\n\"context\":{\"date\":\"%s\",\"float_bytes\":%zu,"
+            "\"min_time\":%0.3f,\"max_reps\":%d},\n\"benchmarks\":[\n",
+            date, sizeof (FloatType), opts_.min_time, opts_.max_reps);
+}
+
+BenchRunner::~BenchRunner () {
+    fprintf (out_, "\n]\n}\n");
+    fflush (out_);
+}
+
+bool BenchRunner::Selected (const std::string& name) const {
+    return opts_.filter.empty () || std::string::npos != name.find (opts_.filter);
+}
+
+void BenchRunner::Run (const std::string& name, Distribution dist, 
+        std::size_t items, const std::function< void () >& fn,
+        const std::function< void () >& setup) {
+
+    typedef std::chrono::steady_clock Clock;
+
+    if (! Selected (name)) { return; }
+
+    std::vector< double > times;
+    double total = 0.0;
+    while (static_cast< int >(times.size ()) < opts_.max_reps && 
+            (times.empty () || total < opts_.min_time)) {
+        if (setup) { setup (); }
+        Clock::time_point start = Clock::now ();
+        fn ();
+        std::chrono::duration< double > d = Clock::now () - start;
+        times.push_back (d.count ());
+        total += d.count ();
+    }
+
+    std::sort (times.begin (), times.end ());
+    double median = times[times.size () / 2];
+
+    fprintf (out_, "%s{\"name\":\"%s\",\"dist\":\"%s\",\"n\":%zu,"
+            "\"reps\":%zu,\"min_ns\":%0.0f,\"median_ns\":%0.0f,"
+            "\"max_ns\":%0.0f,\"items_per_sec\":%0.1f}",
+            first_ ? "" : ",\n", name.c_str (), dist2str (dist), items,
+            times.size (), times.front () * 1e9, median * 1e9, 
+            times.back () * 1e9, 
+            median > 0.0 ? static_cast< double >(items) / median : 0.0);
+    fflush (out_);
+    first_ = false;
+
+    fprintf (stderr, "%-16s %-10s n=%-10zu median %12.3f ms\n", 
+            name.c_str (), dist2str (dist), items, median * 1e3);
+}
+
+static void usage (const char *prog) {
+    fprintf (stderr, "USAGE: %s [options]\n", prog);
+    fprintf (stderr, "-------------------\n");
+    fprintf (stderr, " -n, --min <n>       Smallest dataset size (default 1e3)\n");
+    fprintf (stderr, " -N, --max <n>       Largest dataset size (default 1e6, up to 1e8)\n");
+    fprintf (stderr, " -r, --reps <n>      Max repetitions per case (default 50)\n");
+    fprintf (stderr, " -T, --time <sec>    Min time per case (default 0.25)\n");
+    fprintf (stderr, " -f, --filter <str>  Only run cases whose name contains <str>\n");
+    fprintf (stderr, " -R, --no-render     Skip headless rendering cases\n");
+    fprintf (stderr, " -o, --out <json>    Write results to <json> (default stdout)\n");
+    fprintf (stderr, "\n");
+    exit (42);
+}
+
+int main (int argc, char **argv) {
+
+    static struct option long_opts[] = {
+        { "min", required_argument, NULL, 'n' },
+        { "max", required_argument, NULL, 'N' },
+        { "reps", required_argument, NULL, 'r' },
+        { "time", required_argument, NULL, 'T' },
+        { "filter", required_argument, NULL, 'f' },
+        { "no-render", no_argument, NULL, 'R' },
+        { "out", required_argument, NULL, 'o' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    BenchOptions opts;
+    FILE *out = stdout;
+    int opt = 0;
+
+    while (-1 != (opt = getopt_long (argc, argv, "n:N:r:T:f:Ro:h", 
+                    long_opts, NULL))) {
+        switch (opt) {
+            case 'n':
+                opts.min_size = static_cast< std::size_t >(atof (optarg));
+                break;
+            case 'N':
+                opts.max_size = static_cast< std::size_t >(atof (optarg));
+                break;
+            case 'r':
+                opts.max_reps = std::max (1, atoi (optarg));
+                break;
+            case 'T':
+                opts.min_time = atof (optarg);
+                break;
+            case 'f':
+                opts.filter = optarg;
+                break;
+            case 'R':
+                opts.render = false;
+                break;
+            case 'o':
+                out = fopen (optarg, "w");
+                if (NULL == out) {
+                    perror (optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage (argv[0]);
+        }
+    }
+
+    if (0 == opts.min_size || opts.min_size > opts.max_size) {
+        usage (argv[0]);
+    }
+
+    {
+        BenchRunner runner (opts, out);
+        std::vector< Point > pts;
+        for (std::size_t n = opts.min_size; n <= opts.max_size; n *= 10) {
+            for (int d = 0; d < NUM_DISTS; ++d) {
+                Distribution dist = static_cast< Distribution >(d);
+                synthetic (dist, n, pts);
+                microBenchmarks (runner, dist, n, pts);
+                if (opts.render) {
+                    renderBenchmarks (runner, dist, n, pts);
+                }
+            }
+        }
+    }
+
+    if (stdout != out) { fclose (out); }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef BENCH_H__
+#define BENCH_H__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <graph/primitives.h>
+
+/*
+ * Minimal benchmark harness. Each case is repeated until it has run
+ * for a minimum amount of time (or a maximum number of repetitions)
+ * and the per-repetition timings are reported as JSON so that runs
+ * can be diffed.
+ */
+
+enum Distribution {
+    DIST_UNIFORM = 0,
+    DIST_NORMAL,
+    DIST_MULTI_MODE,
+    NUM_DISTS
+};
+
+const char * dist2str (Distribution d);
+
+/* Deterministic synthetic x/y data */
+void synthetic (Distribution d, std::size_t n, std::vector< Point >& pts);
+
+struct BenchOptions {
+    std::size_t min_size;       /* smallest dataset size */
+    std::size_t max_size;       /* largest dataset size (powers of 10) */
+    int max_reps;               /* cap on repetitions per case */
+    double min_time;            /* seconds each case should run for */
+    std::string filter;         /* only run cases containing this */
+    bool render;                /* include headless rendering cases */
+
+    BenchOptions () : min_size(1000), max_size(1000000), max_reps(50), 
+        min_time(0.25), render(true) {}
+};
+
+class BenchRunner {
+
+    BenchOptions opts_;
+    FILE *out_;
+    bool first_;
+
+    BenchRunner ();
+    BenchRunner (const BenchRunner&);
+
+public:
+
+    BenchRunner (const BenchOptions& opts, FILE *out);
+    ~BenchRunner ();
+
+    const BenchOptions& Options () const { return opts_; }
+
+    bool Selected (const std::string& name) const;
+
+    /*
+     * Time [fn] which processes [items] elements of [dist] data. [setup]
+     * (if any) runs before every repetition and is not timed.
+     */
+    void Run (const std::string& name, Distribution dist, std::size_t items,
+            const std::function< void () >& fn,
+            const std::function< void () >& setup = std::function< void () >());
+
+};
+
+/* Suites; each registers its cases on [runner] for data of size [n] */
+void microBenchmarks (BenchRunner& runner, Distribution dist, std::size_t n,
+        const std::vector< Point >& pts);
+void renderBenchmarks (BenchRunner& runner, Distribution dist, std::size_t n,
+        const std::vector< Point >& pts);
+
+/* Defeat dead code elimination of benchmark results */
+void doNotOptimize (const void *p);
+
+#endif /* BENCH_H__ */
@@ -0,0 +1,286 @@
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <graph/dataset.h>
+#include <graph/range.h>
+#include <graph/util.h>
+#include <graph/colormap.h>
+#include <dataset/csv.h>
+#include <dataset/summary.h>
+#include <dataset/binning.h>
+#include <dataset/aggregates.h>
+#include <dataset/radix.h>
+#include <dataset/summed.h>
+#include <dataset/moments.h>
+#include <dataset/contour.h>
+#include <dataset/kde.h>
+#include <dataset/regression.h>
+#include <dataset/splom.h>
+
+#include "bench.h"
+
+/* viewport used wherever a pixel space is needed */
+static const Range XPIXELS (40.0, 760.0);
+static const Range YPIXELS (560.0, 40.0);
+
+static std::string writeCSV (const std::vector< Point >& pts) {
+    char path[] = "/tmp/tandem-bench-XXXXXX";
+    int fd = mkstemp (path);
+    if (-1 == fd) { return ""; }
+    FILE *fout = fdopen (fd, "w");
+    std::vector< Point >::const_iterator PIT = pts.begin (), 
+        PEND = pts.end ();
+    for (; PIT != PEND; ++PIT) {
+        fprintf (fout, "%0.4f,%0.4f\n", PIT->X (), PIT->Y ());
+    }
+    fclose (fout);
+    return path;
+}
+
+void microBenchmarks (BenchRunner& runner, Distribution dist, std::size_t n,
+        const std::vector< Point >& pts) {
+
+    if (runner.Selected ("load")) {
+        std::string csv = writeCSV (pts);
+        std::vector< Point > loaded;
+        runner.Run ("load", dist, n, 
+                [&] () { load (csv.c_str (), loaded); },
+                [&] () { loaded.clear (); });
+        unlink (csv.c_str ());
+    }
+
+    runner.Run ("dataset", dist, n, [&] () {
+        Dataset data (pts);
+        doNotOptimize (&data);
+    });
+
+    Dataset data (pts);
+    std::vector< FloatType > xs;
+
+    runner.Run ("moments", dist, n, [&] () {
+        PointMoments m = pointMoments (data);
+        doNotOptimize (&m);
+    });
+
+    /* a cubic from scratch, then after each append of a batch */
+    runner.Run ("regression_sums", dist, n, [&] () {
+        Polynomial fit = powerSums (data).Fit (3);
+        doNotOptimize (&fit);
+    });
+    if (n > 0) {
+        const std::size_t batch = 1000;
+        Dataset stream;
+        stream.Window (n);
+        for (std::size_t i = 0; i < n; ++i) { stream.Add (pts[i]); }
+        RegressionCache regression;
+        regression.Update (stream);
+        std::size_t next = 0;
+        runner.Run ("regression_append", dist, batch, [&] () {
+            for (std::size_t i = 0; i < batch; ++i, ++next) {
+                stream.Add (pts[next % n]);
+            }
+            Polynomial fit = regression.Update (stream).Fit (3);
+            doNotOptimize (&fit);
+        });
+    }
+
+    runner.Run ("boxplot_summary", dist, n, 
+            [&] () {
+                BoxPlotSummary bp (xs);
+                doNotOptimize (&bp);
+            },
+            [&] () { data.XData (xs); });
+
+    /* the x column as SortedCache sorts it */
+    runner.Run ("sort_std", dist, n,
+            [&] () {
+                std::sort (xs.begin (), xs.end ());
+                doNotOptimize (xs.data ());
+            },
+            [&] () { data.XData (xs); });
+    runner.Run ("sort_radix", dist, n,
+            [&] () {
+                radixSort (xs);
+                doNotOptimize (xs.data ());
+            },
+            [&] () { data.XData (xs); });
+    std::vector< std::size_t > rows;
+    runner.Run ("sort_radix_rows", dist, n,
+            [&] () {
+                radixSort (xs, rows);
+                doNotOptimize (rows.data ());
+            },
+            [&] () {
+                data.XData (xs);
+                rows.resize (xs.size ());
+                for (std::size_t i = 0; i < rows.size (); ++i) { rows[i] = i; }
+            });
+
+    std::vector< long > bins;
+    runner.Run ("hist_binning", dist, n, [&] () {
+        binCounts (data, AXIS_X, data.XDomain (), 20, bins);
+        doNotOptimize (bins.data ());
+    });
+
+    /* a density estimate from scratch, to compare with one binning pass */
+    runner.Run ("kde_estimate", dist, n, [&] () {
+        KernelDensity kde;
+        doNotOptimize (kde.Update (data, AXIS_X, KDE_SILVERMAN).data ());
+    });
+
+    /* a bin count slider over a column sorted once ahead of time */
+    SortedCache sorted;
+    const std::vector< FloatType >& column = sorted.Update (data, AXIS_X);
+    int step = 0;
+    runner.Run ("hist_rebin", dist, n, [&] () {
+        sortedBinCounts (column, data.XDomain (), 10 + (step++ % 90), bins);
+        doNotOptimize (bins.data ());
+    });
+
+    /* summed-area table: counting the base grid, then bins from it */
+    SummedAreaTable table;
+    runner.Run ("heatmap_table", dist, n, [&] () {
+        SummedAreaTable fresh;
+        fresh.Update (data);
+        doNotOptimize (&fresh);
+    });
+    table.Update (data);
+    std::vector< FloatType > cells;
+    runner.Run ("heatmap_bins", dist, n, [&] () {
+        table.Bins (data.XDomain (), data.YDomain (), 80, 60, cells);
+        doNotOptimize (cells.data ());
+    });
+
+    /* contours over a pan: bins from the table, blurred and traced */
+    DensityContours contours;
+    std::vector< FloatType > shares = { 0.5, 0.9 };
+    int pan = 0;
+    runner.Run ("contour_pan", dist, n, [&] () {
+        FloatType shift = data.XDomain ().Distance () * (pan++ % 10) / 100.0;
+        Range xlim (data.XDomain ().Low () + shift,
+                data.XDomain ().High () + shift);
+        doNotOptimize (contours.Update (table, xlim, data.YDomain (), 200,
+                    150, xlim.Distance () / 40.0,
+                    data.YDomain ().Distance () / 40.0, shares).data ());
+    });
+
+    /* coloring a bin per pixel: interpolated per cell against the LUT */
+    FloatType most = table.Bins (data.XDomain (), data.YDomain (),
+            XPIXELS.Distance (), YPIXELS.Distance (), cells);
+    std::vector< ColorType > colors (cells.size ());
+    runner.Run ("colormap_gradient", dist, n, [&] () {
+        ColorType cool = mkcol (255, 255, 255, 8);
+        ColorType hot = mkcol (255, 255, 255, 255);
+        for (std::size_t c = 0; c < cells.size (); ++c) {
+            colors[c] = gradient (cool, hot, cells[c] / most);
+        }
+        doNotOptimize (colors.data ());
+    });
+    runner.Run ("colormap_lut", dist, n, [&] () {
+        Colormap::Get (CMAP_VIRIDIS).Map (cells, most, SCALE_LINEAR, colors);
+        doNotOptimize (colors.data ());
+    });
+    runner.Run ("colormap_equalized", dist, n, [&] () {
+        Colormap::Get (CMAP_VIRIDIS).Map (cells, most, SCALE_EQUALIZED, colors);
+        doNotOptimize (colors.data ());
+    });
+
+    std::vector< std::vector< int > > grid;
+    runner.Run ("hexbin_binning", dist, n, [&] () {
+        /* same geometry as HexBinPlot with 30 bins */
+        FloatType hex = YPIXELS.Distance () / 30.0;
+        FloatType b = sin (60.0 * M_PI / 180.0) * hex;
+        hexCounts (data, data.XDomain (), data.YDomain (), 
+                XPIXELS, YPIXELS, 2 * b, 1.5 * hex, b, grid);
+        doNotOptimize (grid.data ());
+    });
+
+    /* 10 x 10 matrix of mixes of x and y as laid out in XPIXELS */
+    std::vector< std::vector< FloatType > > mixes (10, std::vector< FloatType >(n));
+    std::vector< SplomColumn > columns;
+    for (std::size_t c = 0; c < mixes.size (); ++c) {
+        for (std::size_t i = 0; i < n; ++i) {
+            mixes[c][i] = pts[i].X () * cos (c) + pts[i].Y () * sin (c);
+        }
+        FloatType low = 0.0, high = 0.0;
+        if (n > 0) {
+            low = *std::min_element (mixes[c].begin (), mixes[c].end ());
+            high = *std::max_element (mixes[c].begin (), mixes[c].end ());
+        }
+        columns.push_back (SplomColumn (mixes[c].data (), n, Range (low, high)));
+    }
+    SplomCache splom;
+    runner.Run ("splom_binning", dist, n, [&] () {
+        splom.Invalidate ();
+        splom.Update (columns, XPIXELS.Distance () / 10 - 4, 20);
+        doNotOptimize (&splom);
+    });
+
+    /* the same 10 columns correlated, by value and by rank */
+    std::vector< const std::vector< FloatType > * > mixed;
+    for (std::size_t c = 0; c < mixes.size (); ++c) {
+        mixed.push_back (&mixes[c]);
+    }
+    CorrelationMatrix matrix;
+    runner.Run ("correlation_pearson", dist, n, [&] () {
+        matrix.Invalidate ();
+        matrix.Update (mixed, CORR_PEARSON);
+        doNotOptimize (&matrix);
+    });
+    runner.Run ("correlation_spearman", dist, n, [&] () {
+        matrix.Invalidate ();
+        matrix.Update (mixed, CORR_SPEARMAN);
+        doNotOptimize (&matrix);
+    });
+
+    /* x against y by rank, ranking both columns each time */
+    runner.Run ("spearman", dist, n, [&] () {
+        FloatType rho = spearman (data);
+        doNotOptimize (&rho);
+    });
+
+    std::vector< FloatType > tx (n), ty (n);
+    runner.Run ("transform", dist, n, [&] () {
+        for (std::size_t i = 0; i < n; ++i) {
+            tx[i] = transform (pts[i].X (), data.XDomain (), XPIXELS);
+            ty[i] = transform (pts[i].Y (), data.YDomain (), YPIXELS);
+        }
+        doNotOptimize (tx.data ());
+        doNotOptimize (ty.data ());
+    });
+
+    if (n > 1) {
+        /* clip against the middle half of the data */
+        Range xclip (data.XDomain ().Low () + data.XDomain ().Distance () / 4,
+                data.XDomain ().High () - data.XDomain ().Distance () / 4);
+        Range yclip (data.YDomain ().Low () + data.YDomain ().Distance () / 4,
+                data.YDomain ().High () - data.YDomain ().Distance () / 4);
+        runner.Run ("lineclip", dist, n - 1, [&] () {
+            FloatType acc = 0.0;
+            for (std::size_t i = 1; i < n; ++i) {
+                Line l (pts[i - 1], pts[i]);
+                if (lineclip (xclip, yclip, l)) { acc += l.Start ().X (); }
+            }
+            doNotOptimize (&acc);
+        });
+    }
+
+    /* ranges from the leading points; independent of n past 10k */
+    std::size_t nticks = std::min (n, static_cast< std::size_t >(10000));
+    runner.Run ("pretty_ticks", dist, nticks, [&] () {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < nticks; ++i) {
+            FloatType a = pts[i].X (), b = pts[i].Y ();
+            if (a == b) { b += 1.0; }
+            total += prettyTicks (Range (a, b), 7).size ();
+        }
+        doNotOptimize (&total);
+    });
+}
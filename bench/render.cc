@@ -0,0 +1,130 @@
+
+#include <cmath>
+#include <cstdio>
+#include <allegro5/allegro.h>
+#include <allegro5/allegro_primitives.h>
+#include <allegro5/allegro_ttf.h>
+
+#include <graph/dataset.h>
+#include <graph/views.h>
+#include <graph/facets.h>
+
+#include "bench.h"
+
+#define RENDER_WIDTH  800
+#define RENDER_HEIGHT 600
+
+/*
+ * End-to-end rendering of every plot type into an offscreen memory
+ * bitmap so no display (or X server) is required
+ */
+static ALLEGRO_BITMAP * target () {
+    static ALLEGRO_BITMAP *bmp = NULL;
+    if (NULL == bmp) {
+        if (! al_init ()) {
+            fprintf (stderr, "Failed to init allegro\n");
+            return NULL;
+        }
+        al_init_primitives_addon ();
+        al_init_font_addon ();
+        al_init_ttf_addon ();
+        al_set_new_bitmap_flags (ALLEGRO_MEMORY_BITMAP);
+        bmp = al_create_bitmap (RENDER_WIDTH, RENDER_HEIGHT);
+    }
+    return bmp;
+}
+
+void renderBenchmarks (BenchRunner& runner, Distribution dist, std::size_t n,
+        const std::vector< Point >& pts) {
+
+    ALLEGRO_BITMAP *bmp = target ();
+    if (NULL == bmp || n < 2) { return; }
+
+    Dataset data (pts);
+    FloatType minx = data.XDomain ().Low () - data.XDomain ().Distance () * 0.05;
+    FloatType maxx = data.XDomain ().High () + data.XDomain ().Distance () * 0.05;
+    FloatType miny = data.YDomain ().Low () - data.YDomain ().Distance () * 0.05;
+    FloatType maxy = data.YDomain ().High () + data.YDomain ().Distance () * 0.05;
+
+    for (int type = 0; type < MAX_PLOT; ++type) {
+        std::string name = std::string ("render_") + plottype2str (type);
+        if (! runner.Selected (name)) { continue; }
+        BasicPlot *plot = new_plot (type, bmp);
+        runner.Run (name, dist, n, [&] () {
+            draw_plot (plot, type, data, minx, maxx, miny, maxy, false);
+        });
+        delete plot;
+    }
+
+    /*
+     * a window edge being dragged: every draw lays the plot out at
+     * another size, which should reuse the aggregates it has
+     */
+    int resized[] = { PLOT_HEXBIN, PLOT_HIST_B, PLOT_ECDF_H, PLOT_BOX_H };
+    for (std::size_t r = 0; r < sizeof (resized) / sizeof (*resized); ++r) {
+        std::string name = std::string ("render_resize_") + 
+            plottype2str (resized[r]);
+        if (! runner.Selected (name)) { continue; }
+        BasicPlot *plot = new_plot (resized[r], bmp);
+        int step = 0;
+        runner.Run (name, dist, n, [&] () {
+            FloatType shrink = (step++ % 16) * 4.0;
+            plot->Region (0.0, 0.0, RENDER_WIDTH - shrink, 
+                    RENDER_HEIGHT - 0.75 * shrink);
+            draw_plot (plot, resized[r], data, minx, maxx, miny, maxy, false);
+        });
+        delete plot;
+    }
+
+    /* zoomed in on a tenth of each axis, so most points are culled */
+    if (runner.Selected ("render_zoom_scatter")) {
+        BasicPlot *plot = new_plot (PLOT_SCATTER, bmp);
+        FloatType cx = (minx + maxx) / 2.0, cy = (miny + maxy) / 2.0;
+        FloatType dx = (maxx - minx) / 20.0, dy = (maxy - miny) / 20.0;
+        runner.Run ("render_zoom_scatter", dist, n, [&] () {
+            draw_plot (plot, PLOT_SCATTER, data, cx - dx, cx + dx, 
+                    cy - dy, cy + dy, false);
+        });
+        delete plot;
+    }
+
+    /*
+     * zooming in by halves from the full view: the level of detail
+     * drawn should keep the cost of each frame about the same
+     */
+    if (runner.Selected ("render_lod_scatter")) {
+        BasicPlot *plot = new_plot (PLOT_SCATTER, bmp);
+        FloatType cx = (minx + maxx) / 2.0, cy = (miny + maxy) / 2.0;
+        int step = 0;
+        runner.Run ("render_lod_scatter", dist, n, [&] () {
+            FloatType scale = ldexp (0.5, -(step++ % 8));
+            FloatType dx = (maxx - minx) * scale, dy = (maxy - miny) * scale;
+            draw_plot (plot, PLOT_SCATTER, data, cx - dx, cx + dx,
+                    cy - dy, cy + dy, false);
+        });
+        delete plot;
+    }
+
+    /* the same points dealt round-robin into 36 hexbin facets */
+    if (runner.Selected ("render_facets_hexbin")) {
+        std::vector< std::vector< Point > > groups (36);
+        for (std::size_t i = 0; i < n; ++i) {
+            groups[i % groups.size ()].push_back (pts[i]);
+        }
+        std::vector< Dataset * > sets;
+        std::vector< const Dataset * > facets;
+        std::vector< std::string > labels;
+        for (std::size_t g = 0; g < groups.size (); ++g) {
+            sets.push_back (new Dataset (groups[g]));
+            facets.push_back (sets.back ());
+            labels.push_back ("");
+        }
+        FacetPlot *plot = new FacetPlot (bmp);
+        plot->Facets (PLOT_HEXBIN, facets, labels);
+        runner.Run ("render_facets_hexbin", dist, n, [&] () {
+            draw_plot (plot, PLOT_FACETS, data, minx, maxx, miny, maxy, false);
+        });
+        delete plot;
+        for (std::size_t g = 0; g < sets.size (); ++g) { delete sets[g]; }
+    }
+}
@@ -0,0 +1,204 @@
+#ifndef AGGREGATES_H__
+#define AGGREGATES_H__
+
+#include <map>
+#include <vector>
+#include <graph/types.h>
+#include <graph/range.h>
+#include <graph/dataset.h>
+
+class SortedCache;
+
+/* How much coarser or finer than asked bins may be and still be reused */
+#define BIN_SLACK 2.0
+
+/*
+ * Bin counts kept in step with a Dataset. Once counted the cache
+ * observes the dataset and applies each insert and eviction as a
+ * delta. Bins counted over a domain holding all of the data go on
+ * holding it: a point beyond them slides them along over empty bins
+ * or doubles their width (merging pairs), in time in the bins, so a
+ * growing or moving range never recounts the points. Such bins are
+ * reused for any domain that still shows all of the data with bins at
+ * most BIN_SLACK times wider or narrower than asked for, and Domain ()
+ * is what they span. Otherwise the counts are redone when the binning
+ * (dataset, axis, domain, bins) changes or the dataset is reset.
+ */
+class BinCache : public DatasetObserver {
+
+    const Dataset *data_;
+    Axis axis_;
+    Range asked_, domain_;
+    /*
+     * Bins as counted are [unit_] wide from [origin_]; each doubling
+     * since halves the index into bins [scale_] times that, of which
+     * those from [first_] are held. Values a bin past the counted
+     * domain were put in its last bin, now bin [fold_].
+     */
+    FloatType origin_, unit_, scale_, first_, fold_;
+    std::vector< long > bins_;
+    long max_;
+    bool stale_max_, covers_, stale_;
+
+    BinCache (const BinCache&);
+
+    /* Index of the bin of [v] from [first_], any distance out; NaN for NaN */
+    FloatType Index (FloatType v) const;
+    int Bin (const Point& p) const;
+
+    /* Slide or widen the bins until they hold [v] */
+    void Grow (FloatType v);
+
+public:
+
+    BinCache () : data_(NULL), axis_(AXIS_X), origin_(0.0), unit_(0.0),
+        scale_(1.0), first_(0.0), fold_(0.0), max_(0), stale_max_(false),
+        covers_(false), stale_(false) {}
+    ~BinCache ();
+
+    /*
+     * Bring the counts up to date, recounting them from [sorted] if it
+     * has the column settled; returns the largest bin count
+     */
+    long Update (const Dataset& data, Axis axis, const Range& domain,
+            int nbins, SortedCache *sorted = NULL);
+
+    const std::vector< long >& Bins () const { return bins_; }
+
+    /* What the bins span, [domain] unless they have grown to hold more */
+    const Range& Domain () const { return domain_; }
+
+    void Inserted (const Point& p);
+    void Evicted (const Point& p);
+    void Detached () { data_ = NULL; }
+
+};
+
+/*
+ * BinCaches handed out by axis and bin count, so the plots of a
+ * dataset that show the same marginal (e.g. histograms on the left and
+ * right in two windows) count it once between them
+ */
+class BinCachePool {
+
+    std::map< std::pair< int, int >, BinCache * > caches_;
+
+    BinCachePool (const BinCachePool&);
+
+public:
+
+    BinCachePool () {}
+    ~BinCachePool ();
+
+    BinCache& Get (Axis axis, int nbins);
+
+};
+
+/* How far the on-screen cell size may drift before hex cells are recounted */
+#define HEX_STRETCH 1.25
+
+/* Share of the limits counted beyond them on each side */
+#define HEX_PAD 0.25
+
+/*
+ * As BinCache for hexCounts (). The cells are kept in data space over
+ * the limits and HEX_PAD beyond them, and once counted are only
+ * scaled and moved with the view (e.g. as a window is resized or the
+ * view panned) until their size on screen drifts by more than
+ * HEX_STRETCH either way. Cells counted over all of the data are
+ * reused for any limits that show all of it, so a growing or moving
+ * range only recounts once a point lands beyond the cells; other
+ * limits must stay inside them.
+ */
+class HexCache : public DatasetObserver {
+
+    const Dataset *data_;
+    Range xregion_, yregion_, xunit_, yunit_;
+    FloatType width_, height_, offset_;
+    std::vector< std::vector< int > > grid_;
+    int max_;
+    bool stale_max_, covers_, stale_;
+
+    HexCache (const HexCache&);
+
+    int *Cell (const Point& p);
+
+public:
+
+    HexCache () : data_(NULL), width_(0.0), height_(0.0), offset_(0.0),
+        max_(0), stale_max_(false), covers_(false), stale_(false) {}
+    ~HexCache ();
+
+    /*
+     * Bring the counts up to date for cells of [width] x [height] px in
+     * the viewport [xrange] x [yrange] at limits [xdomain] x
+     * [ydomain]; returns the largest cell count
+     */
+    int Update (const Dataset& data, 
+            const Range& xdomain, const Range& ydomain,
+            const Range& xrange, const Range& yrange,
+            FloatType width, FloatType height, FloatType offset);
+
+    const std::vector< std::vector< int > >& Grid () const { return grid_; }
+
+    /* Cell size and row offset as fractions of the counted region */
+    FloatType Width () const { return width_; }
+    FloatType Height () const { return height_; }
+    FloatType Offset () const { return offset_; }
+
+    /*
+     * Where the first cell of the grid lies in the viewport [xrange] x
+     * [yrange] at limits [xdomain] x [ydomain] ([x0], [y0]) and the
+     * pixels the whole region spans ([xspan], [yspan])
+     */
+    void Place (const Range& xdomain, const Range& ydomain,
+            const Range& xrange, const Range& yrange, FloatType& x0,
+            FloatType& y0, FloatType& xspan, FloatType& yspan) const;
+
+    void Inserted (const Point& p);
+    void Evicted (const Point& p);
+    void Detached () { data_ = NULL; }
+
+};
+
+/*
+ * The finite values of each column of a Dataset in ascending order,
+ * sorted once and shared by the plots that need them: ECDF and box
+ * plots read them directly and histograms count their bins from them
+ * by binary search (see sortedBinCounts ()). Inserts and evictions
+ * only mark the order stale; a column is sorted again on the next
+ * Update ().
+ */
+class SortedCache : public DatasetObserver {
+
+    const Dataset *data_;
+    std::vector< FloatType > values_[2];    /* by Axis */
+    bool stale_[2], moving_[2];
+
+    SortedCache (const SortedCache&);
+
+public:
+
+    SortedCache () : data_(NULL) {
+        stale_[AXIS_X] = stale_[AXIS_Y] = true;
+        moving_[AXIS_X] = moving_[AXIS_Y] = false;
+    }
+    ~SortedCache ();
+
+    const std::vector< FloatType >& Update (const Dataset& data, Axis axis);
+
+    /*
+     * The sorted [axis] values if they are current or [data] has not
+     * changed since the last call (sorting them then), NULL while it
+     * keeps changing; for callers that can do without, such as bin
+     * counts kept up to date point by point
+     */
+    const std::vector< FloatType > * Settled (const Dataset& data, Axis axis);
+
+    void Inserted (const Point&);
+    void Evicted (const Point&);
+    void Detached () { data_ = NULL; }
+
+};
+
+#endif /* AGGREGATES_H__ */
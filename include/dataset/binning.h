@@ -0,0 +1,85 @@
+#ifndef BINNING_H__
+#define BINNING_H__
+
+#include <cmath>
+#include <vector>
+#include <graph/types.h>
+#include <graph/range.h>
+#include <graph/dataset.h>
+
+/*
+ * Count the [axis] values of [data] into [nbins] equal width bins
+ * spanning [domain]. Values on the upper border are placed in the final
+ * bin and values outside of [domain] are ignored.
+ * Returns the largest bin count.
+ */
+long binCounts (const Dataset& data, Axis axis, const Range& domain, 
+        int nbins, std::vector< long >& bins);
+
+/*
+ * As binCounts () from values already in ascending order (e.g. from a
+ * SortedCache): each bin border is found by binary search, so counting
+ * costs O([nbins] log n) rather than a pass over the data
+ */
+long sortedBinCounts (const std::vector< FloatType >& sorted, 
+        const Range& domain, int nbins, std::vector< long >& bins);
+
+/*
+ * Hexagonal binning in viewport space. Points are mapped from
+ * [xdomain]/[ydomain] onto [xrange]/[yrange] and dropped into rows
+ * [height] px tall of cells [width] px wide, with every even row
+ * shifted by [offset] px. [grid] is indexed [row][column].
+ * Returns the largest cell count.
+ */
+int hexCounts (const Dataset& data, 
+        const Range& xdomain, const Range& ydomain,
+        const Range& xrange, const Range& yrange,
+        FloatType width, FloatType height, FloatType offset,
+        std::vector< std::vector< int > >& grid);
+
+/*
+ * The bin of a single value as binCounts () assigns it, -1 if the
+ * value is not counted
+ */
+inline int binIndex (FloatType v, const Range& domain, int nbins) {
+    FloatType bin_width = domain.Distance () / nbins;
+    int bin = 0;
+    if (nbins <= 0 || v != v) { return -1; }
+    /* single valued data collapses into the first bin */
+    if (bin_width > 0.0) {
+        bin = static_cast< int >(floor ((v - domain.Low ()) / bin_width));
+    }
+    /* anything on the border gets placed in the final bin */
+    if (bin == nbins) { --bin; }
+    if (bin < 0 || bin >= nbins) { return -1; }
+    return bin;
+}
+
+/*
+ * The cell of a single point as hexCounts () assigns it in a grid of
+ * [nrows] x [ncols]; false if the point is not counted
+ */
+inline bool hexIndex (const Point& p, 
+        const Range& xdomain, const Range& ydomain,
+        const Range& xrange, const Range& yrange,
+        FloatType width, FloatType height, FloatType offset,
+        int nrows, int ncols, int& row, int& col) {
+
+    /* Adjust for border offset surrounding viewport */
+    FloatType tx = transform (p.X (), xdomain, xrange) - xrange.Low ();
+    FloatType ty = transform (p.Y (), ydomain, yrange) - yrange.Low ();
+
+    /* also drops NaN from a zero width domain (single point) */
+    if (! (tx >= 0.0 && ty >= 0.0)) { return false; }
+
+    row = static_cast< int >(ty / height);
+    if (0 == row % 2) {
+        col = (tx > offset) ? static_cast< int >((tx - offset) / width) : 0;
+    } else {
+        col = static_cast< int >(tx / width);
+    }
+
+    return row < nrows && col < ncols;
+}
+
+#endif /* BINNING_H__ */
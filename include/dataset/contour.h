@@ -0,0 +1,73 @@
+#ifndef CONTOUR_H__
+#define CONTOUR_H__
+
+#include <vector>
+#include <graph/types.h>
+#include <graph/range.h>
+#include <graph/primitives.h>
+#include <dataset/summed.h>
+
+/*
+ * Blur the [ncols] x [nrows] row major [grid] with a Gaussian of
+ * [xsigma] and [ysigma] cells, approximated by three running box
+ * sums along each axis (so in time in the number of cells whatever
+ * the widths). Values beyond the edges count as zero. Rows, then
+ * columns, are blurred in parallel bands.
+ */
+void blurGrid (std::vector< FloatType >& grid, int ncols, int nrows,
+        FloatType xsigma, FloatType ysigma);
+
+/*
+ * The values of [grid] above which the cells hold each of [shares]
+ * (fractions between 0 and 1) of its total, i.e. the levels whose
+ * contours enclose those shares of the mass, densest first
+ */
+std::vector< FloatType > massLevels (const std::vector< FloatType >& grid,
+        const std::vector< FloatType >& shares);
+
+/*
+ * Marching squares: append to [lines] the segments of the contour of
+ * [grid] at [level], with the grid's cells spanning [xlim] x [ylim]
+ * and each value taken at its cell's center. Saddles are resolved by
+ * the mean of the four corners. Bands of rows are traced in parallel.
+ */
+void isolines (const std::vector< FloatType >& grid, int ncols, int nrows,
+        FloatType level, const Range& xlim, const Range& ylim,
+        std::vector< Line >& lines);
+
+/*
+ * Density contours of the points of a SummedAreaTable over a view:
+ * the points are counted into a grid over the view from the table
+ * (so panning and zooming never revisit them), blurred, and traced at
+ * the levels holding given shares of the points in view. The grid
+ * takes in a margin of three blurring widths beyond the view, so
+ * points just off it blur in as they would with the view larger; only
+ * the part over the view is traced. The grids are reused between
+ * updates.
+ */
+class DensityContours {
+
+    std::vector< FloatType > grid_, wide_;  /* the view, and with margin */
+    std::vector< Line > lines_;
+
+    DensityContours (const DensityContours&);
+
+public:
+
+    DensityContours () {}
+
+    /*
+     * Contours of the points in [table] over [xlim] x [ylim] on a
+     * [ncols] x [nrows] grid, blurred by [xsigma] and [ysigma] data
+     * units, enclosing [shares] of the points in view
+     */
+    const std::vector< Line >& Update (const SummedAreaTable& table,
+            const Range& xlim, const Range& ylim, int ncols, int nrows,
+            FloatType xsigma, FloatType ysigma,
+            const std::vector< FloatType >& shares);
+
+    const std::vector< Line >& Lines () const { return lines_; }
+
+};
+
+#endif /* CONTOUR_H__ */
@@ -0,0 +1,21 @@
+#ifndef CSV_H__
+#define CSV_H__
+
+#include <vector>
+#include <graph/primitives.h>
+
+/*
+ * Append the "x,y" pairs (one per line) from [csv] onto [pts]
+ * Reading stops at the first malformed line.
+ */
+void load (const char *csv, std::vector< Point > &pts);
+
+/*
+ * Append the "x,y" pairs of the complete lines in [buf] onto [pts],
+ * skipping lines that do not parse. Returns the number of bytes used,
+ * i.e. up to and including the last newline; the rest is a partial
+ * line to be passed in again once completed. [buf][len] must be '\0'.
+ */
+std::size_t parse (const char *buf, std::size_t len, std::vector< Point > &pts);
+
+#endif /* CSV_H__ */
@@ -0,0 +1,66 @@
+#ifndef FOLLOW_H__
+#define FOLLOW_H__
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <allegro5/allegro.h>
+#include <graph/primitives.h>
+#include <graph/dataset.h>
+
+/*
+ * Tail a CSV file that is being appended to (tail -f).
+ *
+ * Read () parses everything from the current offset to the end of
+ * the file; after Start () a thread waits on inotify for the file to
+ * change, parses only the newly appended bytes and wakes the main
+ * thread with a FOLLOW_EVENT so it can Drain () them into the Dataset.
+ * A file that shrinks is assumed truncated and read from the start, a
+ * file that is moved or deleted is reopened once it reappears.
+ */
+
+#define FOLLOW_EVENT ALLEGRO_GET_EVENT_TYPE ('T', 'N', 'D', 'F')
+
+class Follow {
+
+    std::string path_;
+    int fd_, inotify_, watch_;
+    long long offset_;
+    std::string partial_;
+    std::thread thread_;
+    std::atomic< bool > running_, signalled_;
+    std::mutex lock_;
+    std::vector< Point > pending_;
+    ALLEGRO_EVENT_SOURCE source_;
+    std::atomic< unsigned long > rows_;
+
+    Follow (const Follow&);
+
+    bool Open ();
+    void Close ();
+    void Watch ();
+
+public:
+
+    Follow (const char *path);
+    ~Follow ();
+
+    /* Append the rows after the current offset onto [pts] */
+    bool Read (std::vector< Point >& pts);
+
+    /* Watch for appended rows on a new thread */
+    bool Start ();
+    void Stop ();
+
+    ALLEGRO_EVENT_SOURCE * EventSource () { return &source_; }
+
+    /* Append rows read since the last call to [data]; main thread only */
+    std::size_t Drain (Dataset& data);
+
+    unsigned long Rows () const { return rows_; }
+
+};
+
+#endif /* FOLLOW_H__ */
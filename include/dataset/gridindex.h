@@ -0,0 +1,146 @@
+#ifndef GRIDINDEX_H__
+#define GRIDINDEX_H__
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <graph/types.h>
+#include <graph/range.h>
+#include <graph/dataset.h>
+
+/* Points per cell the grid is sized for, and its most cells per side */
+#define GRID_LOAD 16
+#define GRID_MAX_SIDE 1024
+
+/*
+ * Spatial index over the points of a Dataset for drawing only those
+ * inside the current limits. Points are bucketed into a uniform grid
+ * over the data domains and copied out cell by cell (a counting sort),
+ * so the cells overlapping a query are contiguous runs of x/y values;
+ * only the cells on the border of the query test their points. A
+ * query costs time in the number of points it finds rather than the
+ * size of the dataset.
+ *
+ * Inserts are added to a bucket for their cell, and points beyond the
+ * grid go to its border cells, which queries always test. Evictions
+ * are struck out (set to NaN) where they lie. A streaming dataset
+ * therefore costs time per point, not per pass. The index is rebuilt
+ * on the next Update () once the points added outnumber those it was
+ * built with, or half of those have been struck out.
+ */
+class GridIndex : public DatasetObserver {
+
+    const Dataset *data_;
+    Range xdomain_, ydomain_;
+    /* extent of the points indexed, which inserts may grow */
+    Range xbounds_, ybounds_;
+    int cols_, rows_;
+    std::vector< std::size_t > start_;
+    std::vector< FloatType > xs_, ys_;
+    /* points inserted since the last build, by cell */
+    std::vector< std::vector< Point > > added_;
+    std::size_t built_, inserted_, struck_;
+    bool stale_;
+
+    GridIndex (const GridIndex&);
+
+    inline int Cell (FloatType v, const Range& domain, int n) const {
+        FloatType width = domain.Distance () / n;
+        if (! (width > 0.0)) { return 0; }
+        /* clamped before the cast, as v may lie far outside */
+        FloatType cell = std::min (floor ((v - domain.Low ()) / width),
+                static_cast< FloatType >(n - 1));
+        return (cell > 0.0) ? static_cast< int >(cell) : 0;
+    }
+
+    template < typename Iterator >
+    void Build (Iterator begin, Iterator end, std::size_t n,
+            const Range& xdomain, const Range& ydomain);
+
+public:
+
+    GridIndex () : data_(NULL), cols_(0), rows_(0), built_(0),
+        inserted_(0), struck_(0), stale_(false) {}
+    ~GridIndex ();
+
+    /* Index [data] unless it already is */
+    void Update (const Dataset& data);
+
+    /* Index [points] over [xdomain] x [ydomain] once, untied to a Dataset */
+    void Assign (const std::vector< Point >& points, const Range& xdomain,
+            const Range& ydomain);
+
+    /* Points indexed */
+    std::size_t Size () const { return built_ - struck_ + inserted_; }
+
+    /*
+     * Call [visit] (x, y) for every indexed point inside [xlim] and
+     * [ylim] (borders included); returns how many there were
+     */
+    template < typename Visitor >
+    std::size_t Visible (const Range& xlim, const Range& ylim,
+            Visitor visit) const {
+        if (0 == cols_ || xlim.High () < xbounds_.Low () ||
+                xlim.Low () > xbounds_.High () ||
+                ylim.High () < ybounds_.Low () ||
+                ylim.Low () > ybounds_.High ()) {
+            return 0;
+        }
+        int c0 = Cell (xlim.Low (), xdomain_, cols_),
+            c1 = Cell (xlim.High (), xdomain_, cols_),
+            r0 = Cell (ylim.Low (), ydomain_, rows_),
+            r1 = Cell (ylim.High (), ydomain_, rows_);
+        std::size_t found = 0;
+        for (int r = r0; r <= r1; ++r) {
+            /* a run of cells along a row is contiguous */
+            const std::size_t *row = &start_[r * cols_];
+            std::size_t begin = row[c0], end = row[c1 + 1];
+            std::size_t inner = end, outer = end;
+            if (r0 < r && r < r1 && c0 < c1) {
+                /* only the first and last cells of the run need a test */
+                inner = row[c0 + 1];
+                outer = row[c1];
+                for (std::size_t i = inner; i < outer; ++i) {
+                    if (0 == struck_ || xs_[i] == xs_[i]) {
+                        visit (xs_[i], ys_[i]);
+                        ++found;
+                    }
+                }
+            }
+            for (std::size_t i = begin; i < end; ++i) {
+                if (i == inner) { i = outer; }
+                if (i == end) { break; }
+                /* written so struck out points fail too */
+                FloatType x = xs_[i], y = ys_[i];
+                if (! (x >= xlim.Low () && x <= xlim.High () &&
+                            y >= ylim.Low () && y <= ylim.High ())) {
+                    continue;
+                }
+                visit (x, y);
+                ++found;
+            }
+            for (int c = c0; 0 < inserted_ && c <= c1; ++c) {
+                const std::vector< Point >& cell = added_[r * cols_ + c];
+                std::vector< Point >::const_iterator PIT = cell.begin (),
+                    PEND = cell.end ();
+                for (; PIT != PEND; ++PIT) {
+                    FloatType x = PIT->X (), y = PIT->Y ();
+                    if (x < xlim.Low () || x > xlim.High () ||
+                            y < ylim.Low () || y > ylim.High ()) {
+                        continue;
+                    }
+                    visit (x, y);
+                    ++found;
+                }
+            }
+        }
+        return found;
+    }
+
+    void Inserted (const Point& p);
+    void Evicted (const Point& p);
+    void Detached () { data_ = NULL; }
+
+};
+
+#endif /* GRIDINDEX_H__ */
@@ -0,0 +1,55 @@
+#ifndef GROUPS_H__
+#define GROUPS_H__
+
+#include <vector>
+#include <string>
+#include <graph/types.h>
+#include <graph/dataset.h>
+#include <dataset/table.h>
+
+/*
+ * The rows of two Table columns split up by the value of a third
+ * (category) column, e.g. to plot one facet per group. Each group is
+ * gathered into columns of its own in a single pass over the table and
+ * handed out as a read-only Dataset view of them. Rows whose category
+ * is NaN (or empty) are left out; groups are ordered by category value,
+ * or by name for a category column, whose codes are taken as the
+ * groups as they are.
+ */
+class Groups {
+
+    std::vector< FloatType > keys_;
+    std::vector< std::string > labels_;
+    std::vector< std::vector< FloatType > > xs_, ys_;
+    std::vector< Dataset * > views_;
+
+    Groups (const Groups&);
+    Groups& operator= (const Groups&);
+
+    void Clear ();
+
+public:
+
+    typedef std::size_t size_type;
+
+    Groups () {}
+    ~Groups ();
+
+    /*
+     * Split columns [x] and [y] of [table] by column [by] (all three
+     * loaded). Returns false, leaving the groups as they were, if there
+     * would be more than [max].
+     */
+    bool Split (const Table& table, int by, int x, int y, size_type max);
+
+    size_type Size () const { return views_.size (); }
+    /* The category of group [i], its code for a category column */
+    FloatType Key (size_type i) const { return keys_[i]; }
+    const Dataset& Data (size_type i) const { return *views_[i]; }
+
+    /* The category of group [i] as text */
+    const std::string& Label (size_type i) const { return labels_[i]; }
+
+};
+
+#endif /* GROUPS_H__ */
@@ -0,0 +1,100 @@
+#ifndef KDE_H__
+#define KDE_H__
+
+#include <vector>
+#include <graph/types.h>
+#include <graph/range.h>
+#include <graph/dataset.h>
+
+/* Points of the grid the values are binned onto */
+#define KDE_GRID 2048
+/*
+ * Most times the grid doubles its step for a value beyond it, and how
+ * many times wider than the data it may grow, before it is binned again
+ */
+#define KDE_GROWTH 8
+#define KDE_LOOSE 4.0
+
+/* Bandwidth rules; KDE_NONE estimates nothing */
+#define KDE_NONE        0
+#define KDE_SILVERMAN   1   /* 0.9 min (sd, IQR / 1.34) n^-1/5 */
+#define KDE_SCOTT       2   /* 1.06 sd n^-1/5 */
+#define MAX_KDE         3
+
+const char * bandwidth2str (int rule);
+
+/* Inverse of bandwidth2str (); -1 if [name] is not a rule */
+int str2bandwidth (const char *name);
+
+/*
+ * Gaussian kernel density estimate of one column of a Dataset, by
+ * binning: each value is split linearly between the two nearest of
+ * KDE_GRID points spanning the column's domain, and the grid is then
+ * convolved with the kernel (truncated at 4 bandwidths), so the cost
+ * is one pass over the data plus work in the size of the grid rather
+ * than the number of values times the points evaluated. The binning
+ * pass runs in parallel shares. The bandwidth follows the rule from
+ * the spread of the binned values (linear binning keeps their mean
+ * and changes their variance by well under a grid step squared).
+ *
+ * The estimate extends 4 bandwidths past either end of the domain.
+ * Inserts and evictions add or take back their weights and only the
+ * convolution is redone on the next Update (). A value beyond the grid
+ * doubles its step towards the value, merging the weights in pairs,
+ * which is exactly what binning onto the coarser grid would give.
+ * Everything is binned again only for a value more than KDE_GROWTH
+ * doublings away, or once the grid is over KDE_LOOSE times as wide as
+ * the data (a window's range may shrink).
+ */
+class KernelDensity : public DatasetObserver {
+
+    const Dataset *data_;
+    Axis axis_;
+    int rule_;
+    FloatType low_, step_;              /* grid point i is at low_ + i step_ */
+    std::vector< double > weights_;     /* KDE_GRID binned values */
+    std::vector< FloatType > density_;
+    FloatType first_, bandwidth_;       /* density_[0] is at first_ */
+    bool stale_, dirty_;
+
+    KernelDensity (const KernelDensity&);
+
+    /* Grid position of [v], negative if it is off the grid or NaN */
+    FloatType Offset (FloatType v) const;
+
+    /* Spread [w] of [v] onto the two grid points about it */
+    void Spread (FloatType v, double w);
+
+    /* Double the step until [v] is on the grid; false if it cannot be */
+    bool Grow (FloatType v);
+
+    void Bin (const Dataset& data);
+    void Convolve ();
+
+public:
+
+    KernelDensity () : data_(NULL), axis_(AXIS_X), rule_(KDE_NONE),
+        low_(0.0), step_(0.0), first_(0.0), bandwidth_(0.0), stale_(true),
+        dirty_(false) {}
+    ~KernelDensity ();
+
+    /*
+     * Bring the estimate of the [axis] values of [data] up to date with
+     * a bandwidth by [rule]; returns the densities, evenly spaced Step ()
+     * apart from First (), and none if there is too little spread
+     */
+    const std::vector< FloatType >& Update (const Dataset& data, Axis axis,
+            int rule);
+
+    const std::vector< FloatType >& Density () const { return density_; }
+    FloatType First () const { return first_; }
+    FloatType Step () const { return step_; }
+    FloatType Bandwidth () const { return bandwidth_; }
+
+    void Inserted (const Point& p);
+    void Evicted (const Point& p);
+    void Detached () { data_ = NULL; }
+
+};
+
+#endif /* KDE_H__ */
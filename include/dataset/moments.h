@@ -0,0 +1,139 @@
+#ifndef MOMENTS_H__
+#define MOMENTS_H__
+
+#include <vector>
+#include <graph/types.h>
+#include <graph/dataset.h>
+
+/*
+ * Count, mean and the sums of 2nd to 4th powers of deviations from the
+ * mean (M2..M4) of a stream of values, updated one value at a time
+ * (Welford, extended to higher moments by Terriberry) and merged with
+ * the moments of another stream (Chan, Pebay), so partial moments of
+ * chunks summed on different threads, or of a batch of new values,
+ * combine into those of the whole without revisiting any value.
+ * Working from deviations keeps the precision the naive sums of powers
+ * lose when the mean is large next to the spread. Accumulated in
+ * double whatever FloatType is.
+ */
+class Moments {
+
+    long n_;
+    double mean_, m2_, m3_, m4_;
+
+public:
+
+    Moments () : n_(0), mean_(0.0), m2_(0.0), m3_(0.0), m4_(0.0) {}
+
+    void Add (FloatType x);
+
+    /*
+     * Take back an [x] added before (e.g. evicted from a window); the
+     * inverse of Add () and as exact, but errors build up over many
+     * removals so a long running total should be recomputed now and then
+     */
+    void Remove (FloatType x);
+
+    void Merge (const Moments& other);
+
+    long Count () const { return n_; }
+    FloatType Mean () const { return mean_; }
+
+    /* Sample variance (n - 1 denominator), 0 below two values */
+    FloatType Variance () const;
+    FloatType StdDev () const;
+
+    /* Sample skewness and excess kurtosis, 0 while undefined */
+    FloatType Skewness () const;
+    FloatType Kurtosis () const;
+
+    /* Sum of squared deviations from the mean */
+    double M2 () const { return m2_; }
+
+};
+
+/*
+ * Moments of pairs of values, with their co-moment (the sum of the
+ * products of the deviations), merged the same way; the covariance
+ * and correlation follow
+ */
+class Comoments {
+
+    Moments x_, y_;
+    double cxy_;
+
+public:
+
+    Comoments () : cxy_(0.0) {}
+
+    void Add (FloatType x, FloatType y);
+    void Remove (FloatType x, FloatType y);
+    void Merge (const Comoments& other);
+
+    long Count () const { return x_.Count (); }
+    const Moments& X () const { return x_; }
+    const Moments& Y () const { return y_; }
+
+    /* Sample covariance, and Pearson's r (0 if either is constant) */
+    FloatType Covariance () const;
+    FloatType Correlation () const;
+
+};
+
+/*
+ * Moments of the points of a Dataset: of each column over its finite
+ * values, and of the pairs over the points finite in both
+ */
+class PointMoments {
+
+    Moments x_, y_;
+    Comoments xy_;
+
+public:
+
+    void Add (const Point& p);
+    void Remove (const Point& p);
+    void Merge (const PointMoments& other);
+
+    const Moments& X () const { return x_; }
+    const Moments& Y () const { return y_; }
+    const Comoments& XY () const { return xy_; }
+
+};
+
+/* Moments of [data], summed in parallel chunks and merged */
+PointMoments pointMoments (const Dataset& data);
+
+/* Moments of the points of [data] whose bit in [selected] is set */
+PointMoments pointMoments (const Dataset& data,
+        const std::vector< bool >& selected);
+
+/*
+ * PointMoments kept in step with a Dataset, summed once and then
+ * updated with each insert (added) and eviction (removed). Once more
+ * points have been removed than are left they are summed afresh on the
+ * next Update (), which bounds the error removals build up.
+ */
+class MomentsCache : public DatasetObserver {
+
+    const Dataset *data_;
+    PointMoments moments_;
+    long removed_;
+    bool stale_;
+
+    MomentsCache (const MomentsCache&);
+
+public:
+
+    MomentsCache () : data_(NULL), removed_(0), stale_(true) {}
+    ~MomentsCache ();
+
+    const PointMoments& Update (const Dataset& data);
+
+    void Inserted (const Point& p);
+    void Evicted (const Point& p);
+    void Detached () { data_ = NULL; }
+
+};
+
+#endif /* MOMENTS_H__ */
@@ -0,0 +1,20 @@
+#ifndef PARALLEL_H__
+#define PARALLEL_H__
+
+#include <cstddef>
+#include <functional>
+
+/*
+ * Run [task] (0) .. [task] ([n] - 1) on the process-wide worker pool
+ * and return once all of them have finished. Tasks are handed out one
+ * index at a time so uneven tasks balance; the calling thread works
+ * through them as well. A task that calls parallelFor () itself runs
+ * that batch inline, as the pool is already busy with its own. The
+ * pool has one thread per core and is started on first use.
+ */
+void parallelFor (std::size_t n, const std::function< void (std::size_t) >& task);
+
+/* Threads available to parallelFor (), counting the caller */
+std::size_t parallelWorkers ();
+
+#endif /* PARALLEL_H__ */
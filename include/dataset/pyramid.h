@@ -0,0 +1,178 @@
+#ifndef PYRAMID_H__
+#define PYRAMID_H__
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <graph/types.h>
+#include <graph/range.h>
+#include <graph/dataset.h>
+
+/* Fewest points worth thinning, and the sides of the coarsest and finest levels */
+#define PYRAMID_MIN_POINTS 65536
+#define PYRAMID_MIN_SIDE 128
+#define PYRAMID_MAX_SIDE 8192
+/* Cells per side of the tiles a level is culled by */
+#define PYRAMID_TILE 16
+/* Share of the domain padded on each side once the data grew past it */
+#define PYRAMID_SLACK 0.5
+/* Slot of a cell no point landed in */
+#define PYRAMID_EMPTY UINT32_MAX
+
+/*
+ * Level-of-detail pyramid over the points of a Dataset. Each level
+ * lays a square grid of twice the side of the one before over the
+ * data domains and keeps, for every occupied cell, how many points
+ * landed in it and the box spanned by their extremes. A cell is drawn
+ * as one point in the middle of its box, shaded by its count.
+ * Thinning by cell rather than by sampling keeps isolated points and
+ * the outline of dense regions, which is what survives rasterization
+ * anyway: once a cell is no bigger than a pixel, its box is too, and
+ * the count stands in for the overdraw of all its points. Levels with
+ * more than half as many cells as there are points save too little to
+ * draw from.
+ *
+ * The level with about a cell per point is counted in one parallel
+ * pass over the data, each share into a level of its own merged after,
+ * and each coarser one by merging the cells of the one below in fours. Finer levels are counted in turn while the last has no
+ * more than a quarter as many cells as points. After that, inserts and
+ * evictions update the count and box of their cell on every level, so
+ * a streaming dataset keeps its levels. An eviction does not shrink a
+ * box, but a box never leaves its cell. The levels are built again on
+ * the next Update () once a point lands outside the grid, over domains
+ * padded by PYRAMID_SLACK, or once the data has doubled (finer levels
+ * may then pay).
+ */
+class PointPyramid : public DatasetObserver {
+
+public:
+
+    /* An occupied cell of a level */
+    struct Cell {
+        FloatType xlow, xhigh, ylow, yhigh; /* box of its points */
+        std::size_t id;                     /* row * side + column */
+        long count;
+    };
+
+    struct Level {
+        std::size_t side, tiles;    /* cells and tiles per side */
+        FloatType xcell, ycell;     /* cell size in data units */
+        std::vector< Cell > cells;
+        /* index in [cells] by cell id, PYRAMID_EMPTY if never used */
+        std::vector< std::uint32_t > slots;
+        /* indices in [cells] by tile, for culling */
+        std::vector< std::vector< std::size_t > > tiled;
+        std::size_t occupied;       /* cells with a count */
+        long max;                   /* most points in a cell */
+    };
+
+private:
+
+    const Dataset *data_;
+    Range xdomain_, ydomain_;
+    std::vector< Level * > levels_;     /* coarsest first */
+    std::size_t built_;                 /* points when last built */
+    bool stale_, grown_;
+
+    PointPyramid (const PointPyramid&);
+
+    void Clear ();
+
+    /*
+     * Cell of [v] among PYRAMID_MAX_SIDE across [domain]; a level of
+     * [side] cells takes its cell over PYRAMID_MAX_SIDE / side, so a
+     * point lands in the cells its counts were merged into
+     */
+    static inline std::size_t CellOf (FloatType v, const Range& domain) {
+        std::size_t n = PYRAMID_MAX_SIDE;
+        FloatType width = domain.Distance () / n;
+        if (! (width > 0.0)) { return 0; }
+        FloatType c = floor ((v - domain.Low ()) / width);
+        if (c < 0.0) { return 0; }
+        return (c < n - 1) ? static_cast< std::size_t >(c) : n - 1;
+    }
+
+    bool Inside (const Point& p) const {
+        return xdomain_.Low () <= p.X () && p.X () <= xdomain_.High () &&
+            ydomain_.Low () <= p.Y () && p.Y () <= ydomain_.High ();
+    }
+
+    /* Slot in [level] of cell [cx], [cy], made if it is new */
+    static Cell& Slot (Level& level, std::size_t cx, std::size_t cy);
+
+    /* Count [p] in its cell of [level] */
+    void Add (Level& level, const Point& p) const;
+
+    /* Fold the points of [from] into cell [cx], [cy] of [level] */
+    static void Merge (Level& level, std::size_t cx, std::size_t cy,
+            const Cell& from);
+
+    /* A level of [side] cells counted from [data] in parallel shares */
+    Level * Fill (std::size_t side, const Dataset& data) const;
+
+public:
+
+    PointPyramid () : data_(NULL), built_(0), stale_(false),
+        grown_(false) {}
+    ~PointPyramid ();
+
+    /* Build the levels for [data] unless they already are */
+    void Update (const Dataset& data);
+
+    /*
+     * The coarsest level whose cells are no bigger than [xres] x [yres]
+     * data units (e.g. those of a pixel), NULL if even the finest is
+     * too coarse and every point must be drawn
+     */
+    const Level * Select (FloatType xres, FloatType yres) const;
+
+    std::size_t Levels () const { return levels_.size (); }
+
+    /*
+     * Call [visit] (x, y, count) for the middle of every occupied cell
+     * of [level] inside [xlim] and [ylim]; returns how many there were
+     */
+    template < typename Visitor >
+    std::size_t Visible (const Level& level, const Range& xlim,
+            const Range& ylim, Visitor visit) const {
+        if (xlim.High () < xdomain_.Low () || xlim.Low () > xdomain_.High () ||
+                ylim.High () < ydomain_.Low () ||
+                ylim.Low () > ydomain_.High ()) {
+            return 0;
+        }
+        std::size_t span = (PYRAMID_MAX_SIDE / level.side) * PYRAMID_TILE;
+        std::size_t t0 = CellOf (xlim.Low (), xdomain_) / span,
+                    t1 = CellOf (xlim.High (), xdomain_) / span,
+                    r0 = CellOf (ylim.Low (), ydomain_) / span,
+                    r1 = CellOf (ylim.High (), ydomain_) / span;
+        std::size_t found = 0;
+        for (std::size_t r = r0; r <= r1; ++r) {
+            for (std::size_t t = t0; t <= t1; ++t) {
+                const std::vector< std::size_t >& tile =
+                    level.tiled[r * level.tiles + t];
+                std::vector< std::size_t >::const_iterator SIT = tile.begin (),
+                    SEND = tile.end ();
+                for (; SIT != SEND; ++SIT) {
+                    const Cell& cell = level.cells[*SIT];
+                    if (0 == cell.count) { continue; }
+                    FloatType x = (cell.xlow + cell.xhigh) / 2.0,
+                              y = (cell.ylow + cell.yhigh) / 2.0;
+                    if (x < xlim.Low () || x > xlim.High () ||
+                            y < ylim.Low () || y > ylim.High ()) {
+                        continue;
+                    }
+                    visit (x, y, cell.count);
+                    ++found;
+                }
+            }
+        }
+        return found;
+    }
+
+    void Inserted (const Point& p);
+    void Evicted (const Point& p);
+    void Detached () { data_ = NULL; Clear (); }
+
+};
+
+#endif /* PYRAMID_H__ */
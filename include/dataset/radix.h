@@ -0,0 +1,29 @@
+#ifndef RADIX_H__
+#define RADIX_H__
+
+#include <vector>
+#include <graph/types.h>
+
+/* Fewer values than this are sorted by comparison instead */
+#define RADIX_MIN 4096
+
+/*
+ * LSD radix sort of FloatType values (float or double, see USE_FLOAT)
+ * on the worker pool. Values are mapped onto unsigned integers of the
+ * same width whose order is the numeric one (sign bit flipped for
+ * positives, every bit for negatives), so -0.0 sorts before 0.0, and
+ * every NaN is made the one quiet NaN and sorted last. Each pass
+ * counts a digit per chunk of the input in parallel and then moves the
+ * chunks to their places in parallel; passes over a digit all values
+ * share are skipped. The sort is stable.
+ */
+void radixSort (std::vector< FloatType >& values);
+
+/*
+ * As radixSort () for [keys], applying the same permutation to [rows]
+ * (which must be the same size), e.g. so that sorted values can be
+ * traced back to the rows they came from. Equal keys keep their order.
+ */
+void radixSort (std::vector< FloatType >& keys, std::vector< std::size_t >& rows);
+
+#endif /* RADIX_H__ */
@@ -0,0 +1,213 @@
+#ifndef REGRESSION_H__
+#define REGRESSION_H__
+
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <graph/types.h>
+#include <graph/range.h>
+#include <graph/dataset.h>
+
+/* Highest degree of polynomial fits */
+#define FIT_MAX_DEGREE 3
+
+/* Correlation coefficients */
+#define CORR_PEARSON    0   /* of the values */
+#define CORR_SPEARMAN   1   /* of their ranks */
+#define MAX_CORR        2
+
+const char * correlation2str (int method);
+
+/* Inverse of correlation2str (); -1 if [name] is not a method */
+int str2correlation (const char *name);
+
+/*
+ * A least squares polynomial, kept in the shifted and scaled variable
+ * it was solved in, t = (x - origin) / scale
+ */
+class Polynomial {
+
+    FloatType origin_, scale_, offset_;
+    std::vector< double > coefs_;   /* of t^0 .. t^degree */
+    double r2_;
+
+public:
+
+    Polynomial () : origin_(0.0), scale_(1.0), offset_(0.0), r2_(0.0) {}
+    Polynomial (FloatType origin, FloatType scale, FloatType offset,
+            const std::vector< double >& coefs, double r2) :
+        origin_(origin), scale_(scale), offset_(offset), coefs_(coefs),
+        r2_(r2) {}
+
+    /* No fit, e.g. too few points or no spread in x */
+    bool Empty () const { return coefs_.empty (); }
+    int Degree () const { return static_cast< int >(coefs_.size ()) - 1; }
+
+    FloatType At (FloatType x) const;
+
+    /* Share of the variance of y the fit explains */
+    FloatType R2 () const { return r2_; }
+
+};
+
+/*
+ * Sufficient statistics for least squares polynomials of y on x up to
+ * FIT_MAX_DEGREE: the count and the sums of t^k (k up to twice the
+ * degree), of t^k u and of u^2, where t and u are x and y shifted to an
+ * origin near the data (and t scaled to about -1..1) so the sums keep
+ * their precision. Points are added and removed one at a time and the
+ * sums of chunks merged, so the fit of a stream or of data summed on
+ * several threads is one solve of a small linear system away.
+ */
+class PowerSums {
+
+    FloatType xorigin_, xscale_, yorigin_;
+    long n_;
+    double t_[2 * FIT_MAX_DEGREE + 1];
+    double tu_[FIT_MAX_DEGREE + 1];
+    double uu_;
+
+    void Accumulate (FloatType x, FloatType y, double w);
+
+public:
+
+    PowerSums (FloatType xorigin = 0.0, FloatType xscale = 1.0,
+            FloatType yorigin = 0.0);
+
+    void Add (FloatType x, FloatType y) { Accumulate (x, y, 1.0); }
+    void Remove (FloatType x, FloatType y) { Accumulate (x, y, -1.0); }
+
+    /* [other] must have the same origins and scale */
+    void Merge (const PowerSums& other);
+
+    long Count () const { return n_; }
+
+    /* Pearson's r of x and y, 0 if either is constant */
+    FloatType Correlation () const;
+
+    /*
+     * Least squares polynomial of [degree] (1 to FIT_MAX_DEGREE); empty
+     * if there are too few distinct x for it
+     */
+    Polynomial Fit (int degree) const;
+
+};
+
+/*
+ * Sums of the points of [data] finite in both x and y, about origins
+ * taken from its domains, summed in parallel chunks and merged
+ */
+PowerSums powerSums (const Dataset& data);
+
+/*
+ * PowerSums kept in step with a Dataset, summed once and then updated
+ * with each insert and eviction, so a fit after a batch of appends
+ * costs time in the batch. Summed afresh on the next Update () once
+ * more points have been removed than are left, or the data has
+ * strayed so far from the origins that the sums lose precision.
+ */
+class RegressionCache : public DatasetObserver {
+
+    const Dataset *data_;
+    PowerSums sums_;
+    FloatType low_, high_;  /* x the sums keep their precision over */
+    long removed_;
+    bool stale_;
+
+    RegressionCache (const RegressionCache&);
+
+public:
+
+    RegressionCache () : data_(NULL), low_(0.0), high_(0.0), removed_(0),
+        stale_(true) {}
+    ~RegressionCache ();
+
+    const PowerSums& Update (const Dataset& data);
+
+    void Inserted (const Point& p);
+    void Evicted (const Point& p);
+    void Detached () { data_ = NULL; }
+
+};
+
+/*
+ * Spearman's rank correlation of the points of [data] finite in both
+ * x and y: each value is replaced by its rank (the mean rank of its
+ * ties) among the values of its column in those points, read off an
+ * index of the rows in column order (a radix sort of the column
+ * carrying the row numbers along), and Pearson's r taken of the ranks.
+ * NaN below two such points.
+ */
+FloatType spearman (const Dataset& data);
+
+/* Share of the points changed, or seconds passed, before a stream is ranked again */
+#define RANK_BATCH 0.01
+#define RANK_SECONDS 0.5
+
+/*
+ * spearman () of a Dataset, taken again once inserts or evictions have
+ * made it stale and then either the data stops changing for one
+ * Update (), or RANK_BATCH of its points have changed, or RANK_SECONDS
+ * have passed since it was last taken. A stream is then neither ranked
+ * afresh on every frame nor left with a value that never moves;
+ * meanwhile the last value stands (NaN before the first).
+ */
+class RankCorrelation : public DatasetObserver {
+
+    const Dataset *data_;
+    FloatType rho_;
+    double ranked_;         /* steady clock seconds when last taken */
+    std::size_t changed_;   /* inserts and evictions since */
+    bool moving_;           /* changed since the last Update () */
+
+    RankCorrelation (const RankCorrelation&);
+
+public:
+
+    RankCorrelation () : data_(NULL), rho_(NAN), ranked_(0.0), changed_(0),
+        moving_(false) {}
+    ~RankCorrelation ();
+
+    FloatType Update (const Dataset& data);
+
+    void Inserted (const Point&) { ++changed_; moving_ = true; }
+    void Evicted (const Point&) { ++changed_; moving_ = true; }
+    void Detached () { data_ = NULL; }
+
+};
+
+/*
+ * Correlations between every pair of a set of columns, each over the
+ * rows finite in both. All pairs are summed in parallel over chunks of
+ * rows and the chunks merged, pairs of columns with nothing missing
+ * without a check per row. For Spearman each column is ranked once,
+ * as spearman () does, which serves the pairs of columns with nothing
+ * missing; a pair with values missing is ranked again over the rows
+ * finite in both. Update () only sums again when the columns or the
+ * method change; Invalidate () is for data that changed in place.
+ */
+class CorrelationMatrix {
+
+    std::vector< const std::vector< FloatType > * > columns_;
+    std::vector< std::size_t > sizes_;
+    std::vector< FloatType > r_;
+    int method_;
+
+    CorrelationMatrix (const CorrelationMatrix&);
+
+public:
+
+    CorrelationMatrix () : method_(-1) {}
+
+    void Update (const std::vector< const std::vector< FloatType > * >& columns,
+            int method);
+    void Invalidate () { method_ = -1; }
+
+    int Columns () const { return static_cast< int >(columns_.size ()); }
+
+    /* The coefficient of columns [a] and [b], NaN if undefined */
+    FloatType At (int a, int b) const { return r_[a * Columns () + b]; }
+
+};
+
+#endif /* REGRESSION_H__ */
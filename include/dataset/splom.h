@@ -0,0 +1,88 @@
+#ifndef SPLOM_H__
+#define SPLOM_H__
+
+#include <vector>
+#include <cstddef>
+#include <graph/types.h>
+#include <graph/range.h>
+
+/* Largest panel resolution; codes must fit a byte next to SPLOM_MISSING */
+#define SPLOM_MAX_CELLS 255
+#define SPLOM_MISSING 255
+
+/* One variable of a scatterplot matrix; [data] is not copied */
+struct SplomColumn {
+    const FloatType *data;
+    std::size_t size;
+    Range domain;
+
+    SplomColumn (const FloatType *d, std::size_t n, const Range& dom) :
+        data(d), size(n), domain(dom) {}
+};
+
+/*
+ * Aggregates for a scatterplot matrix of k columns.
+ *
+ * Every column is reduced once to a byte per row, the cell of the
+ * value along a panel [cells] wide (SPLOM_MISSING for NaN or values
+ * outside the domain), and to the histogram for its diagonal panel.
+ * Each off-diagonal panel is then a single pass over two of those code
+ * arrays into a [cells] x [cells] count grid, and only the k (k - 1) / 2
+ * panels above the diagonal are counted since the panel below is the
+ * same grid transposed. Columns are coded, and panels counted, in
+ * parallel.
+ *
+ * Update () only recodes the columns whose data, size or domain
+ * changed (or all of them if the resolution did) and only recounts
+ * the panels involving those columns. Invalidate () is for data that
+ * changed in place.
+ */
+class SplomCache {
+
+    struct Coded {
+        const FloatType *data;
+        std::size_t size;
+        Range domain;
+        std::vector< unsigned char > codes;
+        std::vector< long > hist;
+        long hist_max;
+    };
+
+    std::vector< Coded > columns_;
+    std::vector< std::vector< unsigned int > > panels_;
+    std::vector< unsigned int > panel_max_;
+    int cells_, nbins_;
+    std::size_t rows_;
+
+    SplomCache (const SplomCache&);
+
+    std::size_t Pair (int a, int b) const;
+
+public:
+
+    SplomCache () : cells_(0), nbins_(0), rows_(0) {}
+
+    void Update (const std::vector< SplomColumn >& columns, int cells,
+            int nbins);
+    void Invalidate ();
+
+    int Columns () const { return static_cast< int >(columns_.size ()); }
+    int Cells () const { return cells_; }
+    std::size_t Rows () const { return rows_; }
+
+    const std::vector< long >& Histogram (int c) const { return columns_[c].hist; }
+    long HistogramMax (int c) const { return columns_[c].hist_max; }
+
+    /*
+     * Counts of the panel with column [a] across and [b] up, a < b,
+     * indexed [xcell * Cells () + ycell]; the panel with [b] across
+     * and [a] up is the same grid read the other way round
+     */
+    const std::vector< unsigned int >& Panel (int a, int b) const {
+        return panels_[Pair (a, b)];
+    }
+    unsigned int PanelMax (int a, int b) const { return panel_max_[Pair (a, b)]; }
+
+};
+
+#endif /* SPLOM_H__ */
@@ -12,9 +12,14 @@ class BoxPlotSummary {
     BoxPlotSummary ();
     BoxPlotSummary (const BoxPlotSummary&);
 
+    void Summarize (const std::vector< FloatType >& xs);
+
 public:
 
+    /* Sorts [xs] unless it is in order already */
     BoxPlotSummary (std::vector< FloatType >& xs);
+    /* [xs] known to be in ascending order (e.g. from a SortedCache) */
+    BoxPlotSummary (const std::vector< FloatType >& xs, bool sorted);
 
     FloatType Median () const { return median_; }
     FloatType UpperQ () const { return uq_; }
@@ -0,0 +1,95 @@
+#ifndef SUMMED_H__
+#define SUMMED_H__
+
+#include <vector>
+#include <graph/types.h>
+#include <graph/range.h>
+#include <graph/dataset.h>
+
+/* Cells per side of the base grid */
+#define SAT_SIDE 1024
+/*
+ * Most times the grid doubles its extent for a point beyond it, and how
+ * many times wider than the data it may grow, before it is counted again
+ */
+#define SAT_GROWTH 8
+#define SAT_LOOSE 4.0
+
+/*
+ * Point counts of a Dataset over a fine base grid spanning its domains,
+ * with their summed-area table (2D prefix sums), so the count inside
+ * any rectangle of cells is four lookups whatever the number of points.
+ * Coarser bins, sub-rectangles (e.g. a selection) and zoomed views are
+ * all answered from the table without touching the points. Rectangles
+ * whose edges cut through base cells take the cut cells pro rata, i.e.
+ * the table is interpolated bilinearly between cell corners; counts
+ * are exact on the cell borders.
+ *
+ * The base grid is counted by a parallel pass over the points. Once
+ * built, inserts and evictions are applied to the base counts and only
+ * the prefix sums are redone (in time in the number of cells) on the
+ * next Update (). A point beyond the grid doubles its extent along
+ * that axis towards the point, merging the cells in pairs, which is
+ * what counting onto the coarser grid would give, so a stream that
+ * keeps growing (e.g. a time series) is never recounted. Everything is
+ * counted again only for a point more than SAT_GROWTH doublings away,
+ * once the grid is over SAT_LOOSE times as wide as the data (a window's
+ * range may shrink), or for an eviction from an empty cell (a point on
+ * the top edge of a grid that grew since).
+ */
+class SummedAreaTable : public DatasetObserver {
+
+    const Dataset *data_;
+    Range xdomain_, ydomain_;
+    std::vector< long > counts_;    /* SAT_SIDE x SAT_SIDE, row major */
+    std::vector< long > sums_;      /* (SAT_SIDE + 1)^2, zero first row/column */
+    bool stale_, dirty_;
+
+    SummedAreaTable (const SummedAreaTable&);
+
+    /* Base cell of [p], -1 if it is outside the domains or NaN */
+    long Cell (const Point& p) const;
+
+    /* Position of [v] in base cells along [domain], clamped to it */
+    FloatType Offset (FloatType v, const Range& domain) const;
+
+    /* Double the extent until [p] is inside; false if it cannot be */
+    bool Grow (const Point& p);
+
+    /* Count below and left of base cell position ([u], [v]) */
+    FloatType Sum (FloatType u, FloatType v) const;
+
+    void Count (const Dataset& data);
+    void Accumulate ();
+
+public:
+
+    SummedAreaTable () : data_(NULL), stale_(false), dirty_(false) {}
+    ~SummedAreaTable ();
+
+    /* Bring the table up to date with [data] */
+    const SummedAreaTable& Update (const Dataset& data);
+
+    /* Points in base cells [col0, col1) x [row0, row1) */
+    long Count (int col0, int row0, int col1, int row1) const;
+
+    /* Points inside [xlim] x [ylim] */
+    FloatType Count (const Range& xlim, const Range& ylim) const;
+
+    /*
+     * Counts of [ncols] x [nrows] equal bins spanning [xlim] x [ylim]
+     * into [bins], row major from the low corner; returns the largest
+     */
+    FloatType Bins (const Range& xlim, const Range& ylim, int ncols,
+            int nrows, std::vector< FloatType >& bins) const;
+
+    const Range& XDomain () const { return xdomain_; }
+    const Range& YDomain () const { return ydomain_; }
+
+    void Inserted (const Point& p);
+    void Evicted (const Point& p);
+    void Detached () { data_ = NULL; }
+
+};
+
+#endif /* SUMMED_H__ */
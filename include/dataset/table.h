@@ -0,0 +1,117 @@
+#ifndef TABLE_H__
+#define TABLE_H__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <graph/types.h>
+#include <graph/range.h>
+
+/* Kinds of column */
+#define COLUMN_NUMBER   0
+#define COLUMN_CATEGORY 1   /* text, stored as codes of its names */
+
+/* Code of an empty field of a category column */
+#define TABLE_NO_CODE UINT32_MAX
+
+/*
+ * CSV data stored by column.
+ *
+ * Open () reads the first line: if any field of it is not a number it
+ * names the columns, otherwise the columns are named V1, V2, ... and
+ * the line is data. Load () then parses only the columns asked for;
+ * the fields of every other column are stepped over without being
+ * converted and the rest of a line is not looked at once the last
+ * wanted field is read. Loading more columns later rereads the file
+ * but leaves those already loaded alone, so the arrays handed out by
+ * Column () stay valid for the life of the table.
+ *
+ * A column whose first value is text rather than a number holds
+ * categories: each row keeps a 32 bit code into the column's names,
+ * which are sorted once it is loaded, so grouping by it (--facet)
+ * works on the codes without converting or comparing text. Column ()
+ * of a category column is its codes as numbers, made the first time
+ * it is asked for.
+ *
+ * Empty and malformed fields of number columns are NaN, and empty
+ * fields of category columns TABLE_NO_CODE. Domains are computed the
+ * first time they are asked for and skip NaN and infinities.
+ */
+class Table {
+
+public:
+
+    typedef std::size_t size_type;
+
+private:
+
+    /* Codes of the category names met while loading a column */
+    typedef std::unordered_map< std::string, std::uint32_t > Dictionary;
+
+    std::string path_;
+    bool header_;
+    std::vector< std::string > names_;
+    std::vector< int > kinds_;
+    /* numbers, or the codes of a category column once asked for */
+    mutable std::vector< std::vector< FloatType > > columns_;
+    std::vector< std::vector< std::uint32_t > > codes_;
+    std::vector< std::vector< std::string > > categories_;
+    std::vector< bool > loaded_;
+    mutable std::vector< Range > domains_;
+    mutable std::vector< bool > have_domain_;
+    size_type rows_;
+
+    Table (const Table&);
+    Table& operator= (const Table&);
+
+    /* Append the field [p, end) to column [c] */
+    void Append (int c, const char *p, const char *end, Dictionary& dict);
+
+    /* Rows column [c] holds so far */
+    size_type Filled (int c) const;
+
+    /* Number the categories of column [c] (met as [dict]) by name */
+    void Sort (int c, const Dictionary& dict);
+
+    void ParseLine (const char *line, const char *eol,
+            const std::vector< int >& slots, int last,
+            const std::vector< int >& dest, std::vector< Dictionary >& dicts);
+
+public:
+
+    Table (const char *path);
+
+    /* Read the column names; false if the file cannot be read */
+    bool Open ();
+
+    /* Parse the columns (by index) not yet loaded */
+    bool Load (const std::vector< int >& columns);
+
+    /*
+     * Index of the column called [name], else of the column numbered
+     * [name] counting from 1; -1 if there is neither
+     */
+    int Find (const std::string& name) const;
+
+    size_type Rows () const { return rows_; }
+    size_type Columns () const { return names_.size (); }
+    bool Header () const { return header_; }
+
+    const std::string& Name (int c) const { return names_[c]; }
+    int Kind (int c) const { return kinds_[c]; }
+    bool Loaded (int c) const { return loaded_[c]; }
+    const std::vector< FloatType >& Column (int c) const;
+    const Range& Domain (int c) const;
+
+    /* Codes of category column [c], and its names by code */
+    const std::vector< std::uint32_t >& Codes (int c) const {
+        return codes_[c];
+    }
+    const std::vector< std::string >& Categories (int c) const {
+        return categories_[c];
+    }
+
+};
+
+#endif /* TABLE_H__ */
@@ -0,0 +1,70 @@
+#ifndef COLORMAP_H__
+#define COLORMAP_H__
+
+#include <vector>
+#include <graph/types.h>
+
+/* Entries in every lookup table */
+#define CMAP_SIZE 256
+
+/* Largest integer count mapped through a per-count table */
+#define CMAP_DIRECT 65536
+
+#define CMAP_WHITE      0   /* translucent to opaque white (the default) */
+#define CMAP_VIRIDIS    1
+#define CMAP_MAGMA      2
+#define CMAP_GRAY       3
+#define CMAP_DIVERGING  4   /* blue through white to red */
+#define MAX_CMAP        5
+
+#define SCALE_LINEAR    0   /* count / largest */
+#define SCALE_LOG       1   /* log (1 + count) / log (1 + largest) */
+#define SCALE_EQUALIZED 2   /* share of the nonzero counts at or below */
+#define MAX_SCALE       3
+
+const char * colormap2str (int name);
+const char * colorscale2str (int scale);
+
+/* Inverses of the above; -1 if [name] is not a colormap / scale */
+int str2colormap (const char *name);
+int str2colorscale (const char *name);
+
+/*
+ * A color ramp precomputed into CMAP_SIZE colors (premultiplied, as
+ * mkcol () makes them), so coloring a bin is a table lookup rather
+ * than interpolating between colors. Map () colors a whole grid of
+ * counts at once: the normalization is worked out once per grid, and
+ * for integer counts once per distinct count, leaving one or two
+ * lookups per cell. Maps are built on first use and never change.
+ */
+class Colormap {
+
+    ColorType lut_[CMAP_SIZE];
+
+    Colormap (int name);
+    Colormap (const Colormap&);
+
+public:
+
+    /* The map called [name], CMAP_WHITE if there is no such map */
+    static const Colormap& Get (int name);
+
+    /* The color [t] of the way along the map, clamped to [0, 1] */
+    ColorType At (FloatType t) const {
+        if (! (t > 0.0)) { return lut_[0]; }
+        if (t >= 1.0) { return lut_[CMAP_SIZE - 1]; }
+        return lut_[static_cast< int >(t * (CMAP_SIZE - 1) + 0.5)];
+    }
+
+    /*
+     * Colors of [counts] (none negative or above [most]) into [colors],
+     * normalized by [scale]; a count of zero gets the first color
+     */
+    void Map (const std::vector< FloatType >& counts, FloatType most,
+            int scale, std::vector< ColorType >& colors) const;
+    void Map (const std::vector< unsigned int >& counts, unsigned int most,
+            int scale, std::vector< ColorType >& colors) const;
+
+};
+
+#endif /* COLORMAP_H__ */
@@ -2,62 +2,228 @@
 #define DATASET_H__
 
 #include <vector>
+#include <deque>
+#include <cstddef>
+#include <iterator>
 #include <algorithm>
 
 #include <graph/primitives.h>
 #include <graph/range.h>
 
+/*
+ * Aggregates kept in step with a Dataset by delta rather than by
+ * rescanning it. Detached () means the dataset was reset or destroyed
+ * and anything derived from it must be rebuilt.
+ */
+class DatasetObserver {
+
+public:
+
+    virtual ~DatasetObserver () {}
+
+    virtual void Inserted (const Point& p) = 0;
+    virtual void Evicted (const Point& p) = 0;
+    virtual void Detached () = 0;
+
+};
+
 /*
  * General container for manipulating data
  * For now, this will deal exclusively with X/Y values; eventually
  * this can become more generic in what it supports
+ *
+ * Points are kept in a ring buffer. By default it only grows, but
+ * with Window () it keeps just the most recent [capacity] points
+ * and/or those added in the last [seconds], evicting the oldest in
+ * O(1) as new points arrive. The domains of a window are tracked with
+ * monotonic min/max deques so evictions never need a rescan.
  */
 class Dataset {
 
+public:
+
+    typedef std::size_t size_type;
+
+private:
+
+    /* value of a window extreme and the sequence number of its point */
+    struct Extreme {
+        unsigned long long seq;
+        FloatType value;
+        Extreme (unsigned long long s, FloatType v) : seq(s), value(v) {}
+    };
+
+    /* 
+     * The oldest point is at [head_] and the following [size_] wrap at
+     * the end of [points_]; [times_] parallels it for time windows
+     */
     std::vector< Point > points_;
+    std::vector< double > times_;
+    /* the columns of a view, NULL when the points are held */
+    const FloatType *xview_, *yview_;
+    std::size_t head_, size_, capacity_;
+    double seconds_;
+    unsigned long long seq_;
     Range xdomain_, ydomain_;
+    std::deque< Extreme > xmin_, xmax_, ymin_, ymax_;
+    mutable std::vector< DatasetObserver * > observers_;
+
+    Dataset (const Dataset&);
+    Dataset& operator= (const Dataset&);
+
+    bool Windowed () const { return capacity_ > 0 || seconds_ > 0.0; }
+    bool View () const { return NULL != xview_; }
+    void Insert (const Point& p, double t);
+    /* Take the window domains from the fronts of the extreme deques */
+    void Extremes ();
+    void EvictOldest ();
+    size_type ExpireBefore (double t);
+    void Reset ();
 
 public:
 
-    typedef std::vector< Point >::iterator iterator;
-    typedef std::vector< Point >::const_iterator const_iterator;
-    typedef std::vector< Point >::size_type size_type;
-
-    Dataset () {}
-    Dataset (const std::vector< Point >& pts) : points_(pts) {
-        std::vector< Point >::const_iterator PIT = pts.begin (),
-            PEND = pts.end ();
-        if (pts.empty ()) { return; }
-        FloatType xmin, xmax, ymin, ymax;
-        xmin = xmax = PIT->X ();
-        ymin = ymax = PIT->Y ();
-        for (; PIT != PEND; ++PIT) {
-            xmin = std::min (xmin, PIT->X ());
-            xmax = std::max (xmax, PIT->X ());
-            ymin = std::min (ymin, PIT->Y ());
-            ymax = std::max (ymax, PIT->Y ());
+    /* 
+     * Random access over the ring from oldest to newest. Points are
+     * read from separate x and y arrays [stride] values apart so the
+     * same iterator walks the ring and column views; they are returned
+     * by value as a view has no Point to refer to.
+     */
+    class const_iterator {
+
+        const FloatType *xbase_, *ybase_, *xlimit_, *px_, *py_;
+        std::ptrdiff_t stride_, pos_;
+
+    public:
+
+        /* what operator-> points into */
+        class Proxy {
+            Point p_;
+        public:
+            Proxy (const Point& p) : p_(p) {}
+            const Point * operator-> () const { return &p_; }
+        };
+
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef Point value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Proxy pointer;
+        typedef Point reference;
+
+        const_iterator () : xbase_(NULL), ybase_(NULL), xlimit_(NULL),
+            px_(NULL), py_(NULL), stride_(1), pos_(0) {}
+        const_iterator (const FloatType *xs, const FloatType *ys, 
+                std::ptrdiff_t stride, std::size_t n, std::size_t head,
+                std::ptrdiff_t pos) : xbase_(xs), ybase_(ys), 
+            xlimit_(xs + n * stride), px_(xs), py_(ys), stride_(stride), 
+            pos_(pos) {
+            if (n > 0) { 
+                std::size_t i = (head + pos) % n;
+                px_ = xs + i * stride;
+                py_ = ys + i * stride;
+            }
+        }
+
+        reference operator* () const { return Point (*px_, *py_); }
+        pointer operator-> () const { return Proxy (**this); }
+        reference operator[] (difference_type k) const { return *(*this + k); }
+
+        const_iterator& operator++ () {
+            ++pos_;
+            px_ += stride_;
+            py_ += stride_;
+            if (px_ == xlimit_) { px_ = xbase_; py_ = ybase_; }
+            return *this;
+        }
+        const_iterator& operator-- () {
+            --pos_;
+            if (px_ == xbase_) { px_ = xlimit_; py_ = ybase_ + (xlimit_ - xbase_); }
+            px_ -= stride_;
+            py_ -= stride_;
+            return *this;
         }
-        xdomain_.Reset (xmin, xmax);
-        ydomain_.Reset (ymin, ymax);
-    }
+        const_iterator operator++ (int) { const_iterator t(*this); ++*this; return t; }
+        const_iterator operator-- (int) { const_iterator t(*this); --*this; return t; }
+
+        const_iterator& operator+= (difference_type k) {
+            difference_type n = (xlimit_ - xbase_) / stride_;
+            pos_ += k;
+            if (n > 0) {
+                difference_type i = ((px_ - xbase_) / stride_ + k % n + n) % n;
+                px_ = xbase_ + i * stride_;
+                py_ = ybase_ + i * stride_;
+            }
+            return *this;
+        }
+        const_iterator& operator-= (difference_type k) { return *this += -k; }
+        const_iterator operator+ (difference_type k) const { 
+            const_iterator t(*this); 
+            return t += k; 
+        }
+        const_iterator operator- (difference_type k) const { 
+            const_iterator t(*this); 
+            return t += -k; 
+        }
+        difference_type operator- (const const_iterator& that) const { 
+            return pos_ - that.pos_; 
+        }
+
+        bool operator== (const const_iterator& that) const { return pos_ == that.pos_; }
+        bool operator!= (const const_iterator& that) const { return pos_ != that.pos_; }
+        bool operator< (const const_iterator& that) const { return pos_ < that.pos_; }
+        bool operator> (const const_iterator& that) const { return pos_ > that.pos_; }
+        bool operator<= (const const_iterator& that) const { return pos_ <= that.pos_; }
+        bool operator>= (const const_iterator& that) const { return pos_ >= that.pos_; }
+
+    };
+
+    Dataset () : xview_(NULL), yview_(NULL), head_(0), size_(0), 
+        capacity_(0), seconds_(0.0), seq_(0) {}
+    Dataset (const std::vector< Point >& pts);
+
+    /*
+     * A read-only view pairing two equally long columns (e.g. of a
+     * Table) as x and y. Nothing is copied, so the columns must not
+     * change or go away while the view exists. Add () and Window ()
+     * throw on a view.
+     */
+    Dataset (const std::vector< FloatType >& xs, 
+            const std::vector< FloatType >& ys,
+            const Range& xdomain, const Range& ydomain);
+    ~Dataset ();
+
+    /*
+     * Keep only the latest [capacity] points (0 for no limit) and those
+     * added within the last [seconds] (0 for no limit). Observers are
+     * detached since existing points may be evicted.
+     */
+    void Window (size_type capacity, double seconds = 0.0);
 
     /* TODO: Provide const read-only version */
+    /* Missing (NaN) values are left out */
     void XData (std::vector< FloatType >& dest) const;
     void YData (std::vector< FloatType >& dest) const;
 
-    /* 
-     * TODO: This should resize range dynamically or a method
-     * should be exposed to do it prior to the next plot
-     * That or just remove this call
-     */
-    void Add (const Point& p) { points_.push_back (p); }
-    size_type Size () const { return points_.size (); }
+    /* Domains grow (and for windows shrink) to cover the points held */
+    void Add (const Point& p);
+
+    /* Evict points older than the time window; returns how many */
+    size_type Expire ();
+
+    size_type Size () const { return size_; }
+    size_type Capacity () const { return capacity_; }
+    double Seconds () const { return seconds_; }
 
     const Range& XDomain () const { return xdomain_; }
     const Range& YDomain () const { return ydomain_; }
 
-    const_iterator Begin () const { return points_.begin (); }
-    const_iterator End () const { return points_.end (); }
+    /* [pos] points on from the oldest */
+    const_iterator Iterator (std::ptrdiff_t pos) const;
+    const_iterator Begin () const { return Iterator (0); }
+    const_iterator End () const { return Iterator (size_); }
+
+    /* Observers are notified of every insert and eviction */
+    void Attach (DatasetObserver *observer) const;
+    void Detach (DatasetObserver *observer) const;
 };
 
 #endif /* DATASET_H__ */
@@ -0,0 +1,69 @@
+#ifndef FACETS_H__
+#define FACETS_H__
+
+#include <string>
+#include <vector>
+#include <graph/plot.h>
+#include <graph/dataset.h>
+
+/*
+ * Small multiples: a grid of panels, one plot of [type] per dataset,
+ * tiled inside the viewport of a single display. The panels share
+ * the x and y limits, so only the bottom row draws x ticks and only
+ * the left column y ticks, and are titled with their labels. The
+ * aggregates of every panel are computed on the worker pool (see
+ * BasicPlot::Prepare ()) before the panels are drawn in turn.
+ *
+ * Without Facets () the dataset passed to Plot () is drawn as a single
+ * panel.
+ */
+class FacetPlot : public BasicPlot {
+
+    ALLEGRO_DISPLAY *win_;
+    ALLEGRO_BITMAP *bmp_;
+    int type_;
+    std::vector< const Dataset * > data_;
+    std::vector< std::string > labels_;
+    std::vector< BasicPlot * > panels_;
+
+    FacetPlot ();
+    FacetPlot (const FacetPlot&);
+
+    void DeletePanels ();
+
+    /*
+     * Lay [n] panels out in [cols] columns, the first at [left], [top],
+     * each [width] by [height]
+     */
+    void Layout (std::size_t n, std::size_t& cols, FloatType& left,
+            FloatType& top, FloatType& width, FloatType& height) const;
+
+public:
+
+    FacetPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), win_(win),
+        bmp_(NULL), type_(0) {}
+    FacetPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), win_(NULL),
+        bmp_(bmp), type_(0) {}
+    ~FacetPlot ();
+
+    const char * Name () const { return "FacetPlot"; }
+
+    /*
+     * Draw a panel of plot [type] for each of [data] (which must outlive
+     * this plot or the next call) titled with [labels]
+     */
+    void Facets (int type, const std::vector< const Dataset * >& data,
+            const std::vector< std::string >& labels);
+
+    void Plot (const Dataset& data);
+    void Plot (const Dataset& data, const Parameters& par);
+
+    /*
+     * The data under pixel [x], [y] of the panel drawn there, mapped to
+     * the limits of the grid
+     */
+    Point Locate (FloatType x, FloatType y) const;
+
+};
+
+#endif /* FACETS_H__ */
@@ -4,6 +4,7 @@
 #include <allegro5/allegro.h>
 #include <allegro5/allegro_primitives.h>
 #include <allegro5/allegro_ttf.h>
+#include <vector>
 #include <graph/types.h>
 #include <graph/range.h>
 
@@ -36,6 +37,13 @@ struct Parameters {
     int                 yticks;     /* number of tick marks on y axis */
     int                 align;      /* text alignment */
     int                 nbins;      /* number of histogram bins */
+    int                 cmap;       /* colormap of density plots, CMAP_* */
+    int                 cscale;     /* count normalization, SCALE_* */
+    FloatType           nsd;        /* std devs spanned by spread ellipses */
+    int                 kde;        /* density curve bandwidth rule, KDE_* */
+    std::vector< FloatType > contours; /* mass shares of density contours */
+    int                 fit;        /* degree of the regression drawn, 0 none */
+    int                 corr;       /* correlation coefficient, CORR_* */
     
     Orientation         side;       /* which side of the plot */
 
@@ -9,6 +9,17 @@
 #include <graph/range.h>
 #include <graph/types.h>
 #include <graph/dataset.h>
+#include <dataset/aggregates.h>
+#include <dataset/contour.h>
+#include <dataset/gridindex.h>
+#include <dataset/kde.h>
+#include <dataset/moments.h>
+#include <dataset/pyramid.h>
+#include <dataset/regression.h>
+#include <dataset/splom.h>
+#include <dataset/summed.h>
+#include <dataset/table.h>
+#include <perf/stats.h>
 
 class ViewPort {
 
@@ -35,14 +46,19 @@ public:
 class BasicPlot {
 
     ALLEGRO_DISPLAY *win_;
+    ALLEGRO_BITMAP *bmp_;
     Parameters par_; 
     ViewPort view_;
 
     BasicPlot ();
     BasicPlot (const BasicPlot&);
 
-    FloatType DisplayWidth () const { return al_get_display_width (win_); }
-    FloatType DisplayHeight () const { return al_get_display_height (win_); }
+    FloatType DisplayWidth () const { 
+        return al_get_bitmap_width (Target ()); 
+    }
+    FloatType DisplayHeight () const { 
+        return al_get_bitmap_height (Target ()); 
+    }
 
     bool Selected () const;
 
@@ -51,19 +67,38 @@ class BasicPlot {
 protected:
 
     ALLEGRO_DISPLAY* Display () const { return win_; }
+    /* The display backbuffer, or the bitmap of an offscreen plot */
+    ALLEGRO_BITMAP* Target () const {
+        return (NULL == win_) ? bmp_ : al_get_backbuffer (win_);
+    }
     const Range& XRange () const { return view_.XRange (); }
     const Range& YRange () const { return view_.YRange (); }
     void GrabFocus () const;
 
+    /*
+     * Trace [fit] across the x limits in [par] and note its R^2 and [r]
+     * (the coefficient [par].corr picks, NaN if unknown) in the top
+     * right corner
+     */
+    void Fit (const Polynomial& fit, FloatType r, const Parameters& par) const;
+
 public:
 
-    BasicPlot (ALLEGRO_DISPLAY *win) : win_(win) {
+    BasicPlot (ALLEGRO_DISPLAY *win) : win_(win), bmp_(NULL) {
         if (NULL == win) {
             throw GeneralException ("Missing display", __FILE__, __LINE__);
         }
         Initialize ();
     }
 
+    /* Offscreen (headless) plot; Update () is a no-op */
+    BasicPlot (ALLEGRO_BITMAP *bmp) : win_(NULL), bmp_(bmp) {
+        if (NULL == bmp) {
+            throw GeneralException ("Missing bitmap", __FILE__, __LINE__);
+        }
+        Initialize ();
+    }
+
     virtual ~BasicPlot () {}
 
     const Parameters& Par () const { return par_; }
@@ -72,6 +107,22 @@ public:
     void Xlim (FloatType low, FloatType high);
     void Ylim (FloatType low, FloatType high);
 
+    /* 
+     * Confine the plot, margins included, to the rectangle [x1, y1] -
+     * [x2, y2] of its target (e.g. one panel of a grid); by default it
+     * covers all of it
+     */
+    void Region (FloatType x1, FloatType y1, FloatType x2, FloatType y2);
+
+    /*
+     * Cover all of the target again once it changed size; aggregates
+     * are kept, so the next Plot () only lays them out anew
+     */
+    void Resize () { Initialize (); }
+
+    /* The data coordinates under pixel [x], [y] at the current limits */
+    virtual Point Locate (FloatType x, FloatType y) const;
+
     void Update () const;
     void Clear () const;
 
@@ -108,6 +159,23 @@ public:
     void Text (const Point& at, const std::string& text) const;
     void Text (const Point& at, const std::string& text, 
             const Parameters& par) const;
+
+    /* Block of text in the top-left corner of the display (e.g. a HUD) */
+    void Overlay (const std::vector< std::string >& lines) const;
+    void Overlay (const std::vector< std::string >& lines, 
+            const Parameters& par) const;
+
+    /* Timing and size counters shared by every plot of this type */
+    PlotStats& Stats () const { return plotStats (Name ()); }
+
+    virtual const char * Name () const = 0;
+
+    /*
+     * Compute the aggregates Plot () with the same arguments would,
+     * without drawing, so it can run off the main thread ahead of it.
+     * Plots that only transform points have nothing to prepare.
+     */
+    virtual void Prepare (const Dataset&, const Parameters&) {}
     
     virtual void Plot (const Dataset& data) = 0;
     virtual void Plot (const Dataset& data, const Parameters& par) = 0;
@@ -116,16 +184,32 @@ public:
 
 class ECDFPlot : public BasicPlot {
 
+    SortedCache sorted_;
+    SortedCache *shared_;
+
     ECDFPlot ();
     ECDFPlot (const ECDFPlot&);
 
+    /* The sorted values, from the shared cache if there is one */
+    SortedCache& Sorted () { return (NULL == shared_) ? sorted_ : *shared_; }
+
     void ECDFHorizontal (const Dataset& data, const Parameters& par);
     void ECDFVertical (const Dataset& data, const Parameters& par);
 
 public:
 
-    ECDFPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win) {}
+    ECDFPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), shared_(NULL) {}
+    ECDFPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), shared_(NULL) {}
 
+    const char * Name () const { return "ECDFPlot"; }
+
+    /*
+     * Sort the data in [sorted] (which must outlive this plot) rather
+     * than privately, e.g. to share the order with other plots
+     */
+    void Share (SortedCache *sorted) { shared_ = sorted; }
+
+    void Prepare (const Dataset& data, const Parameters& par);
     void Plot (const Dataset& data);
     void Plot (const Dataset& data, const Parameters& par);
 
@@ -134,13 +218,68 @@ public:
 
 class ScatterPlot : public BasicPlot {
 
+    GridIndex index_;
+    PointPyramid pyramid_;
+    MomentsCache moments_;
+    MomentsCache *shared_;
+    SummedAreaTable areas_;
+    SummedAreaTable *shared_areas_;
+    DensityContours contours_;
+    RegressionCache regression_;
+    RegressionCache *shared_regression_;
+    RankCorrelation ranks_;
+
     ScatterPlot ();
     ScatterPlot (const ScatterPlot&);
 
+    /* The moments, the shared ones if there are */
+    MomentsCache& Spread () { return (NULL == shared_) ? moments_ : *shared_; }
+
+    /* The table contours are counted from, the shared one if there is one */
+    SummedAreaTable& Areas () {
+        return (NULL == shared_areas_) ? areas_ : *shared_areas_;
+    }
+
+    /* The sums fits are solved from, the shared ones if there are */
+    RegressionCache& Regression () {
+        return (NULL == shared_regression_) ? regression_ : *shared_regression_;
+    }
+
+    /*
+     * The ellipse holding the points within [par].nsd standard
+     * deviations of the mean (along the axes of their covariance)
+     */
+    void Ellipse (const Comoments& xy, const Parameters& par);
+
+    /*
+     * The coarsest level of detail drawing no differently from every
+     * point at the limits in [par], or NULL when every point must be
+     * drawn from [index_]; either is brought up to date with [data]
+     */
+    const PointPyramid::Level * Detail (const Dataset& data,
+            const Parameters& par);
+
 public:
 
-    ScatterPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win) {}
+    ScatterPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), shared_(NULL),
+        shared_areas_(NULL), shared_regression_(NULL) {}
+    ScatterPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), shared_(NULL),
+        shared_areas_(NULL), shared_regression_(NULL) {}
+
+    const char * Name () const { return "ScatterPlot"; }
+
+    /* Take the mean and spread from [moments] (which must outlive this plot) */
+    void Share (MomentsCache *moments) { shared_ = moments; }
 
+    /* Count density contours from [table] (which must outlive this plot) */
+    void Share (SummedAreaTable *table) { shared_areas_ = table; }
+
+    /* Fit from [regression] (which must outlive this plot) */
+    void Share (RegressionCache *regression) {
+        shared_regression_ = regression;
+    }
+
+    void Prepare (const Dataset& data, const Parameters& par);
     void Plot (const Dataset& data);
     void Plot (const Dataset& data, const Parameters& par);
 
@@ -149,9 +288,26 @@ public:
 
 class HistogramPlot : public BasicPlot {
 
+    BinCache bins_;
+    BinCachePool *pool_;
+    SortedCache *sorted_;
+    KernelDensity kde_;
+
     HistogramPlot ();
     HistogramPlot (const HistogramPlot&);
 
+    /* The counts along [axis], from the shared pool if there is one */
+    BinCache& Cache (Axis axis, int nbins);
+
+    /*
+     * Trace the density estimate of [axis] over the bars, scaled to the
+     * share of the points a bin [bin_width] wide would hold: positions
+     * along [along], shares across [across] (in the [axis] direction
+     * and the other respectively)
+     */
+    void Curve (Axis axis, FloatType bin_width, const Range& along,
+            const Range& across, const Parameters& par);
+
     void HistBottom (const Dataset& data, const Parameters& par);
     void HistLeft (const Dataset& data, const Parameters& par);
     void HistRight (const Dataset& data, const Parameters& par);
@@ -159,8 +315,27 @@ class HistogramPlot : public BasicPlot {
 
 public:
 
-    HistogramPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win) {}
+    HistogramPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), pool_(NULL),
+        sorted_(NULL) {}
+    HistogramPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), pool_(NULL),
+        sorted_(NULL) {}
 
+    const char * Name () const { return "HistogramPlot"; }
+
+    /*
+     * Count bins in [pool] (which must outlive this plot) rather than
+     * privately, e.g. to share them with the plots in other windows
+     */
+    void Share (BinCachePool *pool) { pool_ = pool; }
+
+    /*
+     * Recount bins from the column order in [sorted] (which must
+     * outlive this plot) when it is settled, by binary search rather
+     * than a pass over the data
+     */
+    void Share (SortedCache *sorted) { sorted_ = sorted; }
+
+    void Prepare (const Dataset& data, const Parameters& par);
     void Plot (const Dataset& data);
     void Plot (const Dataset& data, const Parameters& par);
 
@@ -168,16 +343,40 @@ public:
 
 class BoxPlot : public BasicPlot {
 
+    SortedCache sorted_;
+    SortedCache *shared_;
+    MomentsCache moments_;
+    MomentsCache *shared_moments_;
+
     BoxPlot ();
     BoxPlot (const BoxPlot&);
 
+    /* The sorted values, from the shared cache if there is one */
+    SortedCache& Sorted () { return (NULL == shared_) ? sorted_ : *shared_; }
+
+    /* The moments the mean is marked from, likewise */
+    MomentsCache& Spread () {
+        return (NULL == shared_moments_) ? moments_ : *shared_moments_;
+    }
+
     void Horizontal (const Dataset& data, const Parameters& par);
     void Vertical (const Dataset& data, const Parameters& par);
 
 public:
 
-    BoxPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win) {}
+    BoxPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), shared_(NULL),
+        shared_moments_(NULL) {}
+    BoxPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), shared_(NULL),
+        shared_moments_(NULL) {}
+
+    const char * Name () const { return "BoxPlot"; }
+
+    /* As ECDFPlot::Share () */
+    void Share (SortedCache *sorted) { shared_ = sorted; }
+    /* As ScatterPlot::Share () */
+    void Share (MomentsCache *moments) { shared_moments_ = moments; }
 
+    void Prepare (const Dataset& data, const Parameters& par);
     void Plot (const Dataset& data);
     void Plot (const Dataset& data, const Parameters& par);
 
@@ -185,16 +384,82 @@ public:
 
 class HexBinPlot : public BasicPlot {
 
+    HexCache cells_;
+    std::vector< unsigned int > counts_;
+    std::vector< ColorType > colors_;
+    MomentsCache moments_;
+    MomentsCache *shared_;
+    SummedAreaTable areas_;
+    SummedAreaTable *shared_areas_;
+    DensityContours contours_;
+
     HexBinPlot ();
     HexBinPlot (const HexBinPlot&);
 
     enum RangeType { RANGE_X, RANGE_Y };
     bool AllValid (const std::vector< FloatType >& xs, RangeType which);
 
+    /* The moments and table, the shared ones if there are */
+    MomentsCache& Spread () { return (NULL == shared_) ? moments_ : *shared_; }
+    SummedAreaTable& Areas () {
+        return (NULL == shared_areas_) ? areas_ : *shared_areas_;
+    }
+
 public:
 
-    HexBinPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win) {}
+    HexBinPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), shared_(NULL),
+        shared_areas_(NULL) {}
+    HexBinPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), shared_(NULL),
+        shared_areas_(NULL) {}
 
+    const char * Name () const { return "HexBinPlot"; }
+
+    /*
+     * Take the spread the contours are smoothed by from [moments], and
+     * count them from [table] (which must outlive this plot)
+     */
+    void Share (MomentsCache *moments) { shared_ = moments; }
+    void Share (SummedAreaTable *table) { shared_areas_ = table; }
+
+    void Prepare (const Dataset& data, const Parameters& par);
+    void Plot (const Dataset& data);
+    void Plot (const Dataset& data, const Parameters& par);
+
+};
+
+/*
+ * Rectangular bins shaded by count, [nbins] across and as many down as
+ * keep them square on screen. Bins are counted from a summed-area
+ * table over the data, so new limits or a new bin count cost time in
+ * the number of bins rather than points.
+ */
+class HeatmapPlot : public BasicPlot {
+
+    SummedAreaTable table_;
+    SummedAreaTable *shared_;
+    std::vector< FloatType > bins_;
+    std::vector< ColorType > colors_;
+
+    HeatmapPlot ();
+    HeatmapPlot (const HeatmapPlot&);
+
+    /* The table, the shared one if there is one */
+    SummedAreaTable& Table () { return (NULL == shared_) ? table_ : *shared_; }
+
+public:
+
+    HeatmapPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), shared_(NULL) {}
+    HeatmapPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), shared_(NULL) {}
+
+    const char * Name () const { return "HeatmapPlot"; }
+
+    /*
+     * Count from [table] (which must outlive this plot) rather than a
+     * private one, e.g. one that also answers selection counts
+     */
+    void Share (SummedAreaTable *table) { shared_ = table; }
+
+    void Prepare (const Dataset& data, const Parameters& par);
     void Plot (const Dataset& data);
     void Plot (const Dataset& data, const Parameters& par);
 
@@ -202,17 +467,120 @@ public:
 
 class LinePlot : public BasicPlot {
 
+    RegressionCache regression_;
+    RegressionCache *shared_regression_;
+    RankCorrelation ranks_;
+
     LinePlot ();
     LinePlot (const LinePlot&);
 
+    /* The sums fits are solved from, the shared ones if there are */
+    RegressionCache& Regression () {
+        return (NULL == shared_regression_) ? regression_ : *shared_regression_;
+    }
+
 public:
 
-    LinePlot (ALLEGRO_DISPLAY *win) : BasicPlot(win) {}
+    LinePlot (ALLEGRO_DISPLAY *win) : BasicPlot(win),
+        shared_regression_(NULL) {}
+    LinePlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp),
+        shared_regression_(NULL) {}
+
+    const char * Name () const { return "LinePlot"; }
+
+    /* Fit from [regression] (which must outlive this plot) */
+    void Share (RegressionCache *regression) {
+        shared_regression_ = regression;
+    }
+
+    void Prepare (const Dataset& data, const Parameters& par);
 
     void Plot (const Dataset& data);
     void Plot (const Dataset& data, const Parameters& par);
 
 };
 
+/*
+ * Scatterplot matrix: a grid of binned scatter panels for every pair
+ * of columns with histograms on the diagonal. Plots the x and y of the
+ * dataset unless Columns () picks columns of a Table instead; those
+ * are copied out of the dataset (and recoded) again only once it has
+ * changed, so redraws, resizes and zooms keep the codes.
+ */
+class SplomPlot : public BasicPlot, public DatasetObserver {
+
+    SplomCache splom_;
+    const Table *table_;
+    std::vector< int > columns_;
+    const Dataset *data_;               /* whose x and y are copied */
+    std::vector< FloatType > xs_, ys_;
+    bool stale_;
+
+    SplomPlot ();
+    SplomPlot (const SplomPlot&);
+
+public:
+
+    SplomPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), table_(NULL),
+        data_(NULL), stale_(true) {}
+    SplomPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), table_(NULL),
+        data_(NULL), stale_(true) {}
+    ~SplomPlot ();
+
+    const char * Name () const { return "SplomPlot"; }
+
+    /* Plot [columns] of [table] (which must stay loaded) in place of x/y */
+    void Columns (const Table *table, const std::vector< int >& columns);
+
+    void Plot (const Dataset& data);
+    void Plot (const Dataset& data, const Parameters& par);
+
+    void Inserted (const Point&) { stale_ = true; }
+    void Evicted (const Point&) { stale_ = true; }
+    void Detached () { data_ = NULL; }
+
+};
+
+/*
+ * Correlation matrix: a cell for every pair of columns colored on a
+ * diverging scale from -1 to 1 and labelled with the coefficient
+ * ([par].corr picks Pearson's or Spearman's). Shows the x and y of
+ * the dataset unless Columns () picks columns of a Table instead; those
+ * are copied out of the dataset again only once it has changed.
+ */
+class CorrelationPlot : public BasicPlot, public DatasetObserver {
+
+    CorrelationMatrix matrix_;
+    const Table *table_;
+    std::vector< int > columns_;
+    const Dataset *data_;               /* whose x and y are copied */
+    std::vector< FloatType > xs_, ys_;
+    bool stale_;
+
+    CorrelationPlot ();
+    CorrelationPlot (const CorrelationPlot&);
+
+public:
+
+    CorrelationPlot (ALLEGRO_DISPLAY *win) : BasicPlot(win), table_(NULL),
+        data_(NULL), stale_(true) {}
+    CorrelationPlot (ALLEGRO_BITMAP *bmp) : BasicPlot(bmp), table_(NULL),
+        data_(NULL), stale_(true) {}
+    ~CorrelationPlot ();
+
+    const char * Name () const { return "CorrelationPlot"; }
+
+    /* Correlate [columns] of [table] (which must stay loaded) instead */
+    void Columns (const Table *table, const std::vector< int >& columns);
+
+    void Plot (const Dataset& data);
+    void Plot (const Dataset& data, const Parameters& par);
+
+    void Inserted (const Point&) { stale_ = true; }
+    void Evicted (const Point&) { stale_ = true; }
+    void Detached () { data_ = NULL; }
+
+};
+
 
 #endif /*PLOT_H__*/
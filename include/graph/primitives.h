@@ -13,6 +13,12 @@ public:
     Point (const FloatType& x, const FloatType& y) : x_(x), y_(y) {}
     Point () : x_(0.0), y_(0.0) {}
 
+    Point& operator= (const Point& other) {
+        x_ = other.X ();
+        y_ = other.Y ();
+        return *this;
+    }
+
     inline FloatType X () const { return x_; }
     inline FloatType Y () const { return y_; }
 
@@ -30,6 +36,12 @@ public:
     Line (const Line& other) : start_(other.Start ()), end_(other.End ()) {}
     Line (const Point& start, const Point& end) : start_(start), end_(end) {}
 
+    Line& operator= (const Line& other) {
+        start_ = other.Start ();
+        end_ = other.End ();
+        return *this;
+    }
+
     inline const Point& Start () const { return start_; }
     inline const Point& End () const { return end_; }
 
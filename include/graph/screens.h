@@ -0,0 +1,119 @@
+#ifndef SCREENS_H__
+#define SCREENS_H__
+
+#include <vector>
+#include <unordered_map>
+#include <allegro5/allegro.h>
+#include <graph/plot.h>
+#include <dataset/aggregates.h>
+#include <dataset/summed.h>
+#include <dataset/moments.h>
+#include <dataset/regression.h>
+
+/*
+ * The windows of a session, any number of which may be opened and
+ * closed while it runs. Each holds one plot drawn from the session's
+ * dataset; histograms on every window count their bins in the one
+ * pool kept here, and they, ECDF and box plots share one sorted copy
+ * of each column. Heatmaps and density contours count from one
+ * summed-area table, which also answers counts of regions of the data,
+ * scatter and box plots mark the mean from one set of moments, and
+ * scatter and line plots solve their fits from one set of power sums.
+ * Windows are numbered from 0 and keep their number while open; a
+ * closed window's number goes to the next one opened.
+ *
+ * Running headless the windows are offscreen bitmaps of a fixed size
+ * rather than displays.
+ */
+class Screens {
+
+public:
+
+    struct View {
+        ALLEGRO_DISPLAY *display;
+        ALLEGRO_BITMAP *target;
+        BasicPlot *plot;
+        int type;
+        bool stale;     /* resized since it was last drawn */
+    };
+
+private:
+
+    std::vector< View * > views_;
+    std::unordered_map< ALLEGRO_DISPLAY *, int > index_;
+    ALLEGRO_EVENT_QUEUE *queue_;
+    BinCachePool bins_;
+    SortedCache sorted_;
+    SummedAreaTable areas_;
+    MomentsCache moments_;
+    RegressionCache regression_;
+    int open_, width_, height_, right_, bottom_;
+    bool offscreen_;
+
+    Screens (const Screens&);
+    Screens& operator= (const Screens&);
+
+    void Place (int i);
+
+public:
+
+    Screens () : queue_(NULL), open_(0), width_(0), height_(0), right_(0),
+        bottom_(0), offscreen_(true) {}
+    ~Screens ();
+
+    /*
+     * Open [width] x [height] displays, tiled from the bottom right
+     * corner ([right], [bottom]) of the monitor
+     */
+    void Displays (int width, int height, int right, int bottom);
+
+    /* Open [width] x [height] memory bitmaps instead of displays */
+    void Offscreen (int width, int height);
+
+    /*
+     * Deliver the events of every display, open or yet to be, to [queue]
+     * instead of the last one given (NULL for none, e.g. before the
+     * queue is destroyed)
+     */
+    void Listen (ALLEGRO_EVENT_QUEUE *queue);
+
+    /* Open a window with no plot yet; returns its number */
+    int Open ();
+
+    /*
+     * Delete the plot of window [i] and destroy it; its pending events
+     * are dropped from the queue
+     */
+    void Close (int i);
+
+    /* Take on the new size of window [i] and lay its plot out again */
+    void Resize (int i);
+
+    /* Number of window [display] in O(1), -1 if it is not one of ours */
+    int Find (ALLEGRO_DISPLAY *display) const;
+
+    /* Whether window [i] is open */
+    bool Valid (int i) const {
+        return i >= 0 && i < Slots () && NULL != views_[i];
+    }
+
+    /* One past the highest window number in use */
+    int Slots () const { return static_cast< int >(views_.size ()); }
+    /* Windows open */
+    int Count () const { return open_; }
+
+    View& operator[] (int i) { return *views_[i]; }
+    const View& operator[] (int i) const { return *views_[i]; }
+
+    int Width (int i) const;
+    int Height (int i) const;
+
+    BinCachePool& Bins () { return bins_; }
+    SortedCache& Sorted () { return sorted_; }
+    SummedAreaTable& Areas () { return areas_; }
+    MomentsCache& Spread () { return moments_; }
+    RegressionCache& Regression () { return regression_; }
+
+};
+
+#endif /* SCREENS_H__ */
@@ -17,6 +17,11 @@ enum Orientation {
     HORIZONTAL
 };
 
+enum Axis {
+    AXIS_X = 0,
+    AXIS_Y
+};
+
 #ifdef USE_FLOAT
     typedef float           FloatType;
     #define FT_EPSILON      FLT_EPSILON
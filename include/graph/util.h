@@ -21,7 +21,11 @@ ColorType gradient (ColorType c1, ColorType c2, FloatType amnt);
  */
 std::vector< std::string > breakLines (const std::string& str);
 
-Line lineclip (const Range& xlim, const Range& ylim, const Line& line);
+/*
+ * Clip [line] to [xlim] x [ylim] in place; false when none of it is
+ * inside (it is then left as it was)
+ */
+bool lineclip (const Range& xlim, const Range& ylim, Line& line);
 std::vector< FloatType > prettyTicks (const Range& range, int ndiv);
 const char * orientation2str (Orientation o);
 
@@ -0,0 +1,45 @@
+#ifndef VIEWS_H__
+#define VIEWS_H__
+
+#include <graph/plot.h>
+#include <graph/dataset.h>
+
+/* TODO: Make this better. simple struct with a 'Next' interface? something */
+#define PLOT_SCATTER   0
+#define PLOT_BOX_H     1
+#define PLOT_BOX_V     2
+#define PLOT_HIST_L    3
+#define PLOT_HIST_R    4
+#define PLOT_HIST_B    5
+#define PLOT_HIST_T    6
+#define PLOT_HEXBIN    7
+#define PLOT_LINE      8
+#define PLOT_ECDF_H    9
+#define PLOT_ECDF_V    10
+#define PLOT_SPLOM     11
+#define PLOT_FACETS    12
+#define PLOT_HEATMAP   13
+#define PLOT_CORRELATION 14
+#define MAX_PLOT       15
+
+const char * plottype2str (int type);
+
+/* Inverse of plottype2str (); -1 if [name] is not a plot type */
+int str2plottype (const char *name);
+
+/*
+ * Allocate an empty plot of [type] drawing onto [win], or onto an
+ * offscreen [bmp] for headless rendering
+ */
+BasicPlot * new_plot (int type, ALLEGRO_DISPLAY *win);
+BasicPlot * new_plot (int type, ALLEGRO_BITMAP *bmp);
+
+/*
+ * Render [plot] (created as [type]) from scratch and flip it to the
+ * display. When [hud] is set the performance overlay is drawn on top.
+ */
+void draw_plot (BasicPlot *plot, int type, const Dataset& data,
+        FloatType minx, FloatType maxx, FloatType miny, FloatType maxy,
+        bool hud);
+
+#endif /* VIEWS_H__ */
@@ -0,0 +1,102 @@
+#ifndef CONTROL_H__
+#define CONTROL_H__
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <functional>
+#include <condition_variable>
+#include <allegro5/allegro.h>
+
+/*
+ * Remote control of a session over a 0MQ REP socket.
+ *
+ * Every request is a single line of whitespace separated words and
+ * gets a single reply starting with "ok" or "err <reason>":
+ *
+ *   ping                        ok
+ *   help                        ok <commands>
+ *   stats [key]                 ok followed by "key value..." lines
+ *   view <screen> <type>        switch plot type (name or number)
+ *   open [type]                 open another window, replying ok <screen>
+ *   close <screen>              close a window (but not the last one)
+ *   xlim <low> <high> | auto    set the x limits of every plot
+ *   ylim <low> <high> | auto    set the y limits of every plot
+ *   nbins <n>                   number of histogram bins
+ *   colormap <name> [scale]     color density plots with <name> (see
+ *                               colormap.h), scaling counts linear, log
+ *                               or equalized
+ *   sd <k>                      ring <k> standard deviations about the
+ *                               mean of scatter plots (0 for none)
+ *   kde none|silverman|scott    bandwidth rule of the density curves
+ *                               over histograms
+ *   contours <share>... | none  trace density contours enclosing each
+ *                               share (0 to 1) of the points in view
+ *                               over scatter and hexbin plots
+ *   fit <degree>                draw the least squares polynomial of
+ *                               <degree> (0 for none, up to 3) over
+ *                               scatter and line plots
+ *   corr pearson|spearman       coefficient noted with fits and shown
+ *                               by the correlation matrix
+ *   columns <x> <y>             plot other columns of a --xcol/--ycol table
+ *   count <xl> <xh> <yl> <yh>   points in a rectangle, ok <n> (to within
+ *                               the summed-area table's base cells)
+ *   snapshot <screen> <png>     render the plot on <screen> to <png>
+ *
+ * Requests are received on a dedicated thread. ping, help and stats
+ * are answered there from values the main thread caches with Cache ()
+ * (plus the perf registry), so polling never waits on rendering. The
+ * rest are queued for the main thread, which is woken with a
+ * CONTROL_EVENT and executes them in Service ().
+ */
+
+#define CONTROL_EVENT ALLEGRO_GET_EVENT_TYPE ('T', 'N', 'D', 'C')
+
+class Control {
+
+    struct Request {
+        std::string command, reply;
+        bool done;
+        Request (const std::string& cmd) : command(cmd), done(false) {}
+    };
+
+    void *ctx_, *sock_;
+    std::thread thread_;
+    std::atomic< bool > running_, signalled_;
+    std::mutex lock_;
+    std::condition_variable replied_;
+    std::deque< Request * > pending_;
+    std::map< std::string, std::string > cache_;
+    ALLEGRO_EVENT_SOURCE source_;
+
+    Control (const Control&);
+
+    void Receive ();
+    std::string Marshal (const std::string& command);
+    std::string Stats (const std::string& key);
+
+public:
+
+    typedef std::function< std::string (const std::string&) > Handler;
+
+    Control ();
+    ~Control ();
+
+    /* Binds a REP socket to [endpoint]; false on failure */
+    bool Start (const char *endpoint);
+    void Stop ();
+
+    ALLEGRO_EVENT_SOURCE * EventSource () { return &source_; }
+
+    /* Run queued requests through [handler]; main thread only */
+    void Service (const Handler& handler);
+
+    /* Publish [value] as the answer to "stats [key]" */
+    void Cache (const std::string& key, const std::string& value);
+
+};
+
+#endif /* CONTROL_H__ */
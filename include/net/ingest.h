@@ -0,0 +1,74 @@
+#ifndef INGEST_H__
+#define INGEST_H__
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <zmq.h>
+#include <allegro5/allegro.h>
+#include <graph/dataset.h>
+
+/*
+ * Streaming of points into a running session over 0MQ.
+ *
+ * Each message is one batch of points encoded as consecutive pairs of
+ * native endian doubles: x0 y0 x1 y1 ... Messages that are empty or
+ * not a multiple of 16 bytes are dropped, as are non-finite points.
+ *
+ * A receiver thread takes ownership of the messages as they arrive and
+ * queues them untouched; the main thread is woken with an INGEST_EVENT
+ * and appends the payloads straight into the Dataset with Drain ().
+ * Only one event is outstanding at a time so a burst of batches costs
+ * a single redraw.
+ */
+
+#define INGEST_EVENT ALLEGRO_GET_EVENT_TYPE ('T', 'N', 'D', 'I')
+
+enum IngestMode {
+    INGEST_PULL = 0,    /* bind a PULL socket, collectors PUSH to us */
+    INGEST_SUB          /* connect a SUB socket to a collector's PUB */
+};
+
+class Ingest {
+
+    void *ctx_, *sock_;
+    std::thread thread_;
+    std::atomic< bool > running_, signalled_;
+    std::mutex lock_;
+    std::deque< zmq_msg_t * > pending_;
+    ALLEGRO_EVENT_SOURCE source_;
+    std::atomic< unsigned long > batches_, points_, rejected_;
+
+    Ingest (const Ingest&);
+
+    void Receive ();
+
+public:
+
+    Ingest ();
+    ~Ingest ();
+
+    /* Returns false (with a message on stderr) if the socket fails */
+    bool Start (const char *endpoint, IngestMode mode);
+    void Stop ();
+
+    /* Register with the event queue to receive INGEST_EVENTs */
+    ALLEGRO_EVENT_SOURCE * EventSource () { return &source_; }
+
+    /* 
+     * Append every queued batch to [data]; main thread only.
+     * Returns the number of points added.
+     */
+    std::size_t Drain (Dataset& data);
+
+    unsigned long Batches () const { return batches_; }
+    unsigned long Points () const { return points_; }
+    unsigned long Rejected () const { return rejected_; }
+
+};
+
+/* ipc:// and inproc:// endpoints, or tcp:// on the loopback only */
+bool localEndpoint (const char *endpoint);
+
+#endif /* INGEST_H__ */
@@ -0,0 +1,58 @@
+#ifndef SHMINGEST_H__
+#define SHMINGEST_H__
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <allegro5/allegro.h>
+#include <graph/dataset.h>
+#include <net/shmring.h>
+
+/*
+ * Consumer side of the shared memory ring (net/shmring.h).
+ *
+ * A watcher thread polls the ring's head and wakes the main thread with
+ * an SHM_EVENT when records are waiting; Drain () then appends them to
+ * the Dataset straight out of the shared mapping. Only one event is
+ * outstanding at a time so bursts cost a single redraw.
+ */
+
+#define SHM_EVENT ALLEGRO_GET_EVENT_TYPE ('T', 'N', 'D', 'S')
+
+/* Default ring size in records (16 bytes each) */
+#define SHM_CAPACITY (1 << 21)
+
+class ShmIngest {
+
+    std::string name_;
+    struct tandem_shm_header *ring_;
+    std::thread thread_;
+    std::atomic< bool > running_, signalled_;
+    ALLEGRO_EVENT_SOURCE source_;
+    unsigned long points_;
+
+    ShmIngest (const ShmIngest&);
+
+    void Watch ();
+
+public:
+
+    ShmIngest ();
+    ~ShmIngest ();
+
+    /* Create the ring /[name] (see shm_open(3)) of [capacity] records */
+    bool Start (const char *name, unsigned long capacity = SHM_CAPACITY);
+
+    /* Stop watching and remove the ring */
+    void Stop ();
+
+    ALLEGRO_EVENT_SOURCE * EventSource () { return &source_; }
+
+    /* Append waiting records to [data]; main thread only */
+    std::size_t Drain (Dataset& data);
+
+    unsigned long Points () const { return points_; }
+
+};
+
+#endif /* SHMINGEST_H__ */
@@ -0,0 +1,192 @@
+#ifndef SHMRING_H__
+#define SHMRING_H__
+
+/*
+ * Shared memory point ring for producers on the same host as tandem
+ * ('tandem --shm <name>'). Plain C so acquisition code can include it.
+ *
+ * Layout of the POSIX shared memory object <name> (see shm_open(3)):
+ *
+ *   offset 0    struct tandem_shm_header   (3 cache lines)
+ *   offset 192  struct tandem_shm_record[capacity]
+ *
+ * It is a single-producer/single-consumer lock-free ring. [head] and
+ * [tail] count records ever written/read and never wrap; a record's
+ * slot is its count modulo [capacity] (a power of two). The producer
+ * only writes [head] and the slots in [head, tail + capacity); the
+ * consumer only writes [tail] and reads the slots in [tail, head).
+ * Slots are filled before [head] is published with release semantics
+ * and read after it is loaded with acquire semantics (and likewise
+ * for [tail]), so no locks or syscalls are involved.
+ *
+ * tandem creates the object and fills in the header, writing [magic]
+ * last; producers must wait for a valid [magic]/[version] before use.
+ * Records are native endian doubles. A full ring is never overwritten:
+ * tandem_shm_write () accepts what fits and the producer decides
+ * whether to retry or drop the rest.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TANDEM_SHM_MAGIC 0x544e4452u   /* "TNDR" */
+#define TANDEM_SHM_VERSION 1u
+#define TANDEM_SHM_LINE 64
+
+struct tandem_shm_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;                  /* records, power of two */
+    uint64_t record_size;               /* sizeof (struct tandem_shm_record) */
+    char pad0[TANDEM_SHM_LINE - 24];
+    uint64_t head;                      /* written by the producer */
+    char pad1[TANDEM_SHM_LINE - 8];
+    uint64_t tail;                      /* written by the consumer */
+    char pad2[TANDEM_SHM_LINE - 8];
+};
+
+struct tandem_shm_record {
+    double x, y;
+};
+
+static inline size_t tandem_shm_bytes (uint64_t capacity) {
+    return sizeof (struct tandem_shm_header) + 
+        capacity * sizeof (struct tandem_shm_record);
+}
+
+static inline struct tandem_shm_record * 
+tandem_shm_records (struct tandem_shm_header *h) {
+    return (struct tandem_shm_record *) (h + 1);
+}
+
+/* Consumer: create and initialize the ring; NULL on failure */
+static inline struct tandem_shm_header * 
+tandem_shm_create (const char *name, uint64_t capacity) {
+    struct tandem_shm_header *h = NULL;
+    void *mem = NULL;
+    int fd = -1;
+
+    if (0 == capacity || 0 != (capacity & (capacity - 1))) { return NULL; }
+
+    fd = shm_open (name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) { return NULL; }
+    if (0 != ftruncate (fd, (off_t) tandem_shm_bytes (capacity))) {
+        close (fd);
+        return NULL;
+    }
+    mem = mmap (NULL, tandem_shm_bytes (capacity), PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    close (fd);
+    if (MAP_FAILED == mem) { return NULL; }
+
+    h = (struct tandem_shm_header *) mem;
+    h->version = TANDEM_SHM_VERSION;
+    h->capacity = capacity;
+    h->record_size = sizeof (struct tandem_shm_record);
+    __atomic_store_n (&h->head, 0, __ATOMIC_RELAXED);
+    __atomic_store_n (&h->tail, 0, __ATOMIC_RELAXED);
+    __atomic_store_n (&h->magic, TANDEM_SHM_MAGIC, __ATOMIC_RELEASE);
+    return h;
+}
+
+/* Producer: map an existing ring; NULL if missing or not ready yet */
+static inline struct tandem_shm_header * tandem_shm_attach (const char *name) {
+    struct tandem_shm_header *h = NULL;
+    struct stat sb;
+    void *mem = NULL;
+    int fd = shm_open (name, O_RDWR, 0);
+
+    if (fd < 0) { return NULL; }
+    if (0 != fstat (fd, &sb) || 
+            (size_t) sb.st_size < sizeof (struct tandem_shm_header)) {
+        close (fd);
+        return NULL;
+    }
+    mem = mmap (NULL, (size_t) sb.st_size, PROT_READ | PROT_WRITE, 
+            MAP_SHARED, fd, 0);
+    close (fd);
+    if (MAP_FAILED == mem) { return NULL; }
+
+    h = (struct tandem_shm_header *) mem;
+    if (TANDEM_SHM_MAGIC != __atomic_load_n (&h->magic, __ATOMIC_ACQUIRE) ||
+            TANDEM_SHM_VERSION != h->version ||
+            sizeof (struct tandem_shm_record) != h->record_size ||
+            tandem_shm_bytes (h->capacity) > (size_t) sb.st_size) {
+        munmap (mem, (size_t) sb.st_size);
+        return NULL;
+    }
+    return h;
+}
+
+static inline void tandem_shm_detach (struct tandem_shm_header *h) {
+    if (NULL != h) {
+        munmap (h, tandem_shm_bytes (h->capacity));
+    }
+}
+
+/* Producer: append up to [n] records; returns how many fit */
+static inline uint64_t tandem_shm_write (struct tandem_shm_header *h,
+        const struct tandem_shm_record *recs, uint64_t n) {
+    struct tandem_shm_record *slots = tandem_shm_records (h);
+    uint64_t mask = h->capacity - 1;
+    uint64_t head = __atomic_load_n (&h->head, __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n (&h->tail, __ATOMIC_ACQUIRE);
+    uint64_t space = h->capacity - (head - tail);
+    uint64_t first = 0;
+
+    if (n > space) { n = space; }
+    if (0 == n) { return 0; }
+
+    /* at most two copies: up to the end of the buffer, then the start */
+    first = h->capacity - (head & mask);
+    if (first > n) { first = n; }
+    memcpy (slots + (head & mask), recs, first * sizeof (*recs));
+    memcpy (slots, recs + first, (n - first) * sizeof (*recs));
+
+    __atomic_store_n (&h->head, head + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+/*
+ * Consumer: the contiguous run of unread records starting at the
+ * tail; [count] may be less than everything available when the run
+ * wraps, so call again after tandem_shm_release ()
+ */
+static inline const struct tandem_shm_record * 
+tandem_shm_peek (struct tandem_shm_header *h, uint64_t *count) {
+    uint64_t mask = h->capacity - 1;
+    uint64_t tail = __atomic_load_n (&h->tail, __ATOMIC_RELAXED);
+    uint64_t head = __atomic_load_n (&h->head, __ATOMIC_ACQUIRE);
+    uint64_t run = h->capacity - (tail & mask);
+
+    *count = head - tail;
+    if (*count > run) { *count = run; }
+    return tandem_shm_records (h) + (tail & mask);
+}
+
+/* Consumer: hand [n] peeked records back to the producer */
+static inline void tandem_shm_release (struct tandem_shm_header *h, uint64_t n) {
+    uint64_t tail = __atomic_load_n (&h->tail, __ATOMIC_RELAXED);
+    __atomic_store_n (&h->tail, tail + n, __ATOMIC_RELEASE);
+}
+
+/* Records written but not yet consumed */
+static inline uint64_t tandem_shm_pending (struct tandem_shm_header *h) {
+    return __atomic_load_n (&h->head, __ATOMIC_ACQUIRE) - 
+        __atomic_load_n (&h->tail, __ATOMIC_ACQUIRE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHMRING_H__ */
@@ -0,0 +1,14 @@
+#ifndef HUD_H__
+#define HUD_H__
+
+#include <string>
+#include <vector>
+#include <perf/stats.h>
+
+/*
+ * Text for the on-screen performance overlay of a single plot:
+ * per-stage p50/p99 timings, point count, cache hit rates and memory
+ */
+std::vector< std::string > hudLines (const PlotStats& stats);
+
+#endif /* HUD_H__ */
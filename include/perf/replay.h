@@ -0,0 +1,66 @@
+#ifndef REPLAY_H__
+#define REPLAY_H__
+
+#include <cstdio>
+#include <vector>
+#include <allegro5/allegro.h>
+
+/*
+ * Recording and playback of the user input driving a session.
+ *
+ * Events are stored one per line as plain text:
+ *
+ *   <seconds> <type> <screen> <a> <b> <c> <d>
+ *
+ * where <seconds> is relative to the first recorded event, <type> is
+ * the ALLEGRO_EVENT_* value, <screen> the index of the window the event
+ * belongs to (-1 if none) and a..d depend on the type:
+ *
+ *   key events      keycode unichar modifiers 0
+ *   mouse events    x y z button
+ *   display events  width height 0 0
+ *
+ * The first line is a header "# tandem-events 1 <width> <height>" with
+ * the size of the windows at record time.
+ */
+
+struct RecordedEvent {
+    double time;
+    unsigned type;
+    int screen;
+    int a, b, c, d;
+};
+
+class EventRecorder {
+
+    FILE *out_;
+    double start_;
+
+    EventRecorder (const EventRecorder&);
+
+public:
+
+    EventRecorder () : out_(NULL), start_(-1.0) {}
+    ~EventRecorder () { Close (); }
+
+    bool Open (const char *path, int width, int height);
+    void Close ();
+    bool Active () const { return NULL != out_; }
+
+    /* Ignores any event that is not user input or window related */
+    void Record (const ALLEGRO_EVENT& event, int screen);
+
+};
+
+bool loadEvents (const char *path, int& width, int& height, 
+        std::vector< RecordedEvent >& events);
+
+/* Rebuild an event for replay; display/source pointers are left NULL */
+ALLEGRO_EVENT toEvent (const RecordedEvent& rec);
+
+/* The display an event was generated for (NULL if not display bound) */
+ALLEGRO_DISPLAY * eventDisplay (const ALLEGRO_EVENT& event);
+
+const char * eventtype2str (unsigned type);
+
+#endif /* REPLAY_H__ */
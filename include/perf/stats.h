@@ -0,0 +1,160 @@
+#ifndef STATS_H__
+#define STATS_H__
+
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <perf/trace.h>
+
+/*
+ * Lightweight instrumentation for the load -> compute -> draw -> flip
+ * pipeline of each plot. Timings are kept in microseconds.
+ */
+
+enum Stage {
+    STAGE_LOAD = 0,
+    STAGE_COMPUTE,
+    STAGE_DRAW,
+    STAGE_FLIP,
+    NUM_STAGES
+};
+
+const char * stage2str (Stage s);
+
+/*
+ * Fixed-size window over the most recent samples; percentiles are
+ * computed on demand so recording a sample is just a store
+ */
+class RollingHistogram {
+
+    std::vector< double > samples_;
+    std::size_t next_, total_;
+
+public:
+
+    RollingHistogram (std::size_t window = 128) : 
+        samples_(window), next_(0), total_(0) {}
+
+    void Add (double usec);
+
+    /* [p] is a value between 0.0 and 1.0 */
+    double Percentile (double p) const;
+    double Last () const;
+    std::size_t Total () const { return total_; }
+    std::size_t Window () const { return std::min (total_, samples_.size ()); }
+
+};
+
+class PlotStats {
+
+    std::string name_;
+    RollingHistogram stages_[NUM_STAGES];
+    std::size_t points_;
+    mutable std::mutex lock_;
+
+    PlotStats ();
+    PlotStats (const PlotStats&);
+
+public:
+
+    PlotStats (const std::string& name) : name_(name), points_(0) {}
+
+    const std::string& Name () const { return name_; }
+
+    void Record (Stage stage, double usec);
+    void Points (std::size_t n);
+
+    std::size_t Points () const;
+    double Percentile (Stage stage, double p) const;
+    double Last (Stage stage) const;
+    std::size_t Total (Stage stage) const;
+
+};
+
+/*
+ * Hit/miss tallies for any of the caches in the system
+ */
+class CacheCounter {
+
+    std::string name_;
+    std::atomic< unsigned long > hits_, misses_;
+
+    CacheCounter ();
+    CacheCounter (const CacheCounter&);
+
+public:
+
+    CacheCounter (const std::string& name) : name_(name), hits_(0), misses_(0) {}
+
+    const std::string& Name () const { return name_; }
+
+    void Hit () { ++hits_; }
+    void Miss () { ++misses_; }
+
+    unsigned long Hits () const { return hits_; }
+    unsigned long Misses () const { return misses_; }
+    double HitRate () const;
+
+};
+
+/*
+ * Records the lifetime of the object into [stats] under [stage] (and
+ * as a trace event named after the stage when tracing is enabled)
+ * Stop () ends the measurement early for stages that do not map
+ * onto a single block
+ */
+class ScopedTimer {
+
+    typedef std::chrono::steady_clock Clock;
+
+    PlotStats& stats_;
+    Stage stage_;
+    Clock::time_point start_;
+    bool stopped_, traced_;
+
+    ScopedTimer ();
+    ScopedTimer (const ScopedTimer&);
+
+public:
+
+    ScopedTimer (PlotStats& stats, Stage stage) : 
+        stats_(stats), stage_(stage), start_(Clock::now ()), stopped_(false),
+        traced_(traceEnabled ()) {
+        if (traced_) { traceBegin (stage2str (stage_)); }
+    }
+
+    ~ScopedTimer () { Stop (); }
+
+    void Stop () {
+        if (stopped_) { return; }
+        std::chrono::duration< double, std::micro > d = Clock::now () - start_;
+        stats_.Record (stage_, d.count ());
+        if (traced_) { traceEnd (stage2str (stage_)); }
+        stopped_ = true;
+    }
+
+};
+
+/*
+ * Process-wide registries; entries are created on first use and
+ * live until exit so plots can be torn down and rebuilt freely
+ */
+PlotStats& plotStats (const std::string& name);
+CacheCounter& cacheCounter (const std::string& name);
+
+/* Stats that are not tied to a single plot (e.g. loading the input) */
+PlotStats& sessionStats ();
+
+std::vector< const PlotStats * > allPlotStats ();
+std::vector< const CacheCounter * > allCacheCounters ();
+
+/* Resident set size of this process in bytes (0 if unknown) */
+std::size_t residentBytes ();
+
+void dumpStats (FILE *out);
+
+#endif /* STATS_H__ */
@@ -0,0 +1,65 @@
+#ifndef TRACE_H__
+#define TRACE_H__
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * Begin/end event tracing written out in the Chrome trace-event format
+ * (loadable in chrome://tracing or Perfetto).
+ *
+ * Each thread records into its own fixed-size ring buffer so recording
+ * never takes a lock; when the ring fills the oldest events are
+ * overwritten. Event names are not copied and must be string literals
+ * (or otherwise outlive the trace).
+ *
+ * When tracing is disabled every hook costs a single relaxed load.
+ */
+
+extern std::atomic< bool > trace_enabled;
+
+inline bool traceEnabled () { 
+    return trace_enabled.load (std::memory_order_relaxed); 
+}
+
+/* Enable tracing; the trace is written to [path] by traceWrite () */
+void traceStart (const char *path, std::size_t events_per_thread = 1 << 16);
+
+/* Write all buffered events to the path given to traceStart () */
+bool traceWrite ();
+
+/* Label the calling thread in the trace viewer */
+void traceThreadName (const char *name);
+
+void traceBegin (const char *name);
+void traceEnd (const char *name);
+
+class TraceScope {
+
+    const char *name_;
+
+    TraceScope ();
+    TraceScope (const TraceScope&);
+
+public:
+
+    TraceScope (const char *name) : name_(NULL) {
+        if (traceEnabled ()) {
+            name_ = name;
+            traceBegin (name_);
+        }
+    }
+
+    ~TraceScope () {
+        if (NULL != name_) {
+            traceEnd (name_);
+        }
+    }
+
+};
+
+#define TRACE_CONCAT_(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__) (name)
+
+#endif /* TRACE_H__ */
@@ -0,0 +1,364 @@
+
+#include <cmath>
+#include <algorithm>
+#include <dataset/aggregates.h>
+#include <dataset/binning.h>
+#include <dataset/radix.h>
+#include <perf/stats.h>
+
+static bool sameRange (const Range& a, const Range& b) {
+    return a.X () == b.X () && a.Y () == b.Y ();
+}
+
+/* Whether [outer] reaches at least as far as [inner] both ways */
+static bool holds (const Range& outer, const Range& inner) {
+    return outer.Low () <= inner.Low () && inner.High () <= outer.High ();
+}
+
+/* Most times bins may double to take in one point before a recount */
+#define BIN_DOUBLINGS 64
+
+BinCache::~BinCache () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+FloatType BinCache::Index (FloatType v) const {
+    if (v != v) { return NAN; }
+    /* single valued data collapses into the first bin */
+    if (! (unit_ > 0.0)) { return -first_; }
+    /* the bin binIndex () gave it when counted, widened since */
+    FloatType at = (v - origin_) / unit_;
+    if (floor (at) == static_cast< FloatType >(bins_.size ())) {
+        return fold_ - first_;
+    }
+    return floor (at / scale_) - first_;
+}
+
+int BinCache::Bin (const Point& p) const {
+    FloatType at = Index ((AXIS_X == axis_) ? p.X () : p.Y ());
+    return (at >= 0.0 && at < bins_.size ()) ? static_cast< int >(at) : -1;
+}
+
+void BinCache::Grow (FloatType v) {
+
+    int nbins = static_cast< int >(bins_.size ());
+    if (0 == nbins || ! std::isfinite (v) || ! (unit_ > 0.0)) {
+        stale_ = true;
+        return;
+    }
+
+    for (int doubled = 0; ; ++doubled) {
+        FloatType at = Index (v);
+        if (at >= 0.0 && at < nbins) { break; }
+        if (BIN_DOUBLINGS == doubled) {
+            stale_ = true;
+            return;
+        }
+
+        /* slide along if the bins given up for it are empty */
+        bool up = at >= nbins;
+        FloatType shift = up ? at - nbins + 1 : -at;
+        int empty = 0;
+        while (empty < nbins && 0 == bins_[up ? empty : nbins - 1 - empty]) {
+            ++empty;
+        }
+        if (shift <= empty || nbins == empty) {
+            int k = static_cast< int >(std::min (shift,
+                        static_cast< FloatType >(nbins)));
+            if (up) {
+                std::copy (bins_.begin () + k, bins_.end (), bins_.begin ());
+                std::fill (bins_.end () - k, bins_.end (), 0);
+                first_ += shift;
+            } else {
+                std::copy_backward (bins_.begin (), bins_.end () - k,
+                        bins_.end ());
+                std::fill (bins_.begin (), bins_.begin () + k, 0);
+                first_ -= shift;
+            }
+            break;
+        }
+
+        /* otherwise merge pairs of bins, keeping the far end in place */
+        FloatType first = up ? floor (first_ / 2.0) :
+            floor ((first_ + nbins - 1) / 2.0) - (nbins - 1);
+        std::vector< long > merged (nbins, 0);
+        for (int k = 0; k < nbins; ++k) {
+            merged[static_cast< int >(floor ((first_ + k) / 2.0) - first)] +=
+                bins_[k];
+        }
+        bins_.swap (merged);
+        first_ = first;
+        fold_ = floor (fold_ / 2.0);
+        scale_ *= 2.0;
+    }
+
+    FloatType width = unit_ * scale_;
+    domain_.Reset (origin_ + first_ * width,
+            origin_ + (first_ + nbins) * width);
+    stale_max_ = true;
+}
+
+long BinCache::Update (const Dataset& data, Axis axis, const Range& domain,
+        int nbins, SortedCache *sorted) {
+
+    const Range& extent = (AXIS_X == axis) ? data.XDomain () : data.YDomain ();
+    bool same = &data == data_ && axis == axis_ && ! stale_ &&
+        static_cast< std::size_t >(nbins) == bins_.size ();
+    /* bins holding all of the data serve any limits showing all of it */
+    bool close = domain.Distance () * BIN_SLACK >= domain_.Distance () &&
+        domain_.Distance () * BIN_SLACK >= domain.Distance ();
+    if (same && (sameRange (domain, asked_) ||
+                (covers_ && holds (domain, extent) && close))) {
+        cacheCounter ("bins").Hit ();
+    } else {
+        cacheCounter ("bins").Miss ();
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+        axis_ = axis;
+        asked_.Reset (domain.X (), domain.Y ());
+        domain_.Reset (domain.X (), domain.Y ());
+        origin_ = domain.Low ();
+        unit_ = domain.Distance () / nbins;
+        scale_ = 1.0;
+        first_ = 0.0;
+        fold_ = nbins - 1;
+        covers_ = holds (domain, extent);
+        stale_ = false;
+        const std::vector< FloatType > *values = (NULL != sorted) ?
+            sorted->Settled (data, axis) : NULL;
+        max_ = (NULL != values) ? 
+            sortedBinCounts (*values, domain, nbins, bins_) :
+            binCounts (data, axis, domain, nbins, bins_);
+        stale_max_ = false;
+    }
+
+    if (stale_max_) {
+        max_ = bins_.empty () ? 0 : *std::max_element (bins_.begin (), bins_.end ());
+        stale_max_ = false;
+    }
+    return max_;
+}
+
+void BinCache::Inserted (const Point& p) {
+    if (stale_) { return; }
+    int bin = Bin (p);
+    if (bin < 0 && covers_) {
+        FloatType v = (AXIS_X == axis_) ? p.X () : p.Y ();
+        if (v != v) { return; }
+        Grow (v);
+        if (stale_) { return; }
+        bin = Bin (p);
+    } else if (covers_ && ! (unit_ > 0.0) &&
+            ((AXIS_X == axis_) ? p.X () : p.Y ()) != origin_) {
+        /* single valued no longer */
+        stale_ = true;
+        return;
+    }
+    if (bin < 0) { return; }
+    max_ = std::max (max_, ++bins_[bin]);
+}
+
+void BinCache::Evicted (const Point& p) {
+    if (stale_) { return; }
+    int bin = Bin (p);
+    if (bin < 0) { return; }
+    if (bins_[bin]-- == max_) { stale_max_ = true; }
+}
+
+BinCachePool::~BinCachePool () {
+    std::map< std::pair< int, int >, BinCache * >::iterator CIT = 
+        caches_.begin (), CEND = caches_.end ();
+    for (; CIT != CEND; ++CIT) {
+        delete CIT->second;
+    }
+}
+
+BinCache& BinCachePool::Get (Axis axis, int nbins) {
+    BinCache *& cache = caches_[std::make_pair (static_cast< int >(axis), 
+            nbins)];
+    if (NULL == cache) { cache = new BinCache (); }
+    return *cache;
+}
+
+HexCache::~HexCache () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+int * HexCache::Cell (const Point& p) {
+    int row = 0, col = 0;
+    int nrows = static_cast< int >(grid_.size ());
+    int ncols = nrows ? static_cast< int >(grid_[0].size ()) : 0;
+    if (! hexIndex (p, xregion_, yregion_, xunit_, yunit_, 
+                width_, height_, offset_, nrows, ncols, row, col)) {
+        return NULL;
+    }
+    return &grid_[row][col];
+}
+
+/* [r] mapped onto 0..1, keeping its direction */
+static Range unitRange (const Range& r) {
+    return (r.X () <= r.Y ()) ? Range (0.0, 1.0) : Range (1.0, 0.0);
+}
+
+/*
+ * The span of [domain] from [before] to [after] its length beyond the
+ * ends, oriented so [unit] maps onto it as onto [domain]
+ */
+static Range padRange (const Range& domain, const Range& unit,
+        FloatType before, FloatType after) {
+    FloatType from = (0.0 == unit.X ()) ? -before : 1.0 + after;
+    FloatType to = (0.0 == unit.Y ()) ? -before : 1.0 + after;
+    Range r;
+    r.Reset (transform (from, unit, domain), transform (to, unit, domain));
+    return r;
+}
+
+/* Whether [s] is within HEX_STRETCH of 1 */
+static bool unstretched (FloatType s) {
+    return s <= HEX_STRETCH && s >= 1.0 / HEX_STRETCH;
+}
+
+void HexCache::Place (const Range& xdomain, const Range& ydomain,
+        const Range& xrange, const Range& yrange, FloatType& x0,
+        FloatType& y0, FloatType& xspan, FloatType& yspan) const {
+    x0 = transform (transform (xunit_.Low (), xunit_, xregion_), xdomain,
+            xrange);
+    y0 = transform (transform (yunit_.Low (), yunit_, yregion_), ydomain,
+            yrange);
+    xspan = transform (transform (xunit_.High (), xunit_, xregion_), xdomain,
+            xrange) - x0;
+    yspan = transform (transform (yunit_.High (), yunit_, yregion_), ydomain,
+            yrange) - y0;
+}
+
+int HexCache::Update (const Dataset& data, 
+        const Range& xdomain, const Range& ydomain,
+        const Range& xrange, const Range& yrange,
+        FloatType width, FloatType height, FloatType offset) {
+
+    bool same = &data == data_ && ! stale_;
+    if (same) {
+        FloatType x0 = 0.0, y0 = 0.0, xspan = 0.0, yspan = 0.0;
+        Place (xdomain, ydomain, xrange, yrange, x0, y0, xspan, yspan);
+        same = unstretched (width_ * fabs (xspan) / width) &&
+            unstretched (height_ * fabs (yspan) / height) &&
+            ((holds (xregion_, xdomain) && holds (yregion_, ydomain)) ||
+             (covers_ && holds (xdomain, data.XDomain ()) &&
+              holds (ydomain, data.YDomain ())));
+    }
+
+    if (same) {
+        cacheCounter ("hexbin").Hit ();
+    } else {
+        cacheCounter ("hexbin").Miss ();
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+        /* same cells as binning in pixels, scaled down to the unit square */
+        FloatType xscale = std::max (xrange.Distance (), 
+                static_cast< FloatType >(1.0));
+        FloatType yscale = std::max (yrange.Distance (), 
+                static_cast< FloatType >(1.0));
+        FloatType w = width / xscale, h = height / yscale;
+        /*
+         * padded by whole cells, and an even number of rows so they
+         * keep their offsets, to lie as they would over the limits alone
+         */
+        FloatType xpad = (w > 0.0) ? ceil (HEX_PAD / w) * w : 0.0;
+        FloatType ypad = (h > 0.0) ? 2.0 * ceil (HEX_PAD / h / 2.0) * h : 0.0;
+        Range unitx = unitRange (xrange), unity = unitRange (yrange);
+        xunit_.Reset (unitx.X (), unitx.Y ());
+        yunit_.Reset (unity.X (), unity.Y ());
+        xregion_ = padRange (xdomain, unitx, xpad, xpad);
+        yregion_ = padRange (ydomain, unity, ypad, ypad);
+        width_ = w / (1.0 + 2.0 * xpad);
+        height_ = h / (1.0 + 2.0 * ypad);
+        offset_ = offset / xscale / (1.0 + 2.0 * xpad);
+        covers_ = holds (xregion_, data.XDomain ()) &&
+            holds (yregion_, data.YDomain ());
+        stale_ = false;
+        max_ = hexCounts (data, xregion_, yregion_, xunit_, yunit_, 
+                width_, height_, offset_, grid_);
+        stale_max_ = false;
+    }
+
+    if (stale_max_) {
+        max_ = 0;
+        std::vector< std::vector< int > >::const_iterator RIT = grid_.begin (),
+            REND = grid_.end ();
+        for (; RIT != REND; ++RIT) {
+            if (RIT->empty ()) { continue; }
+            max_ = std::max (max_, *std::max_element (RIT->begin (), RIT->end ()));
+        }
+        stale_max_ = false;
+    }
+    return max_;
+}
+
+void HexCache::Inserted (const Point& p) {
+    if (stale_) { return; }
+    int *cell = Cell (p);
+    if (NULL == cell) {
+        /* the cells no longer hold all of the data */
+        if (covers_ && p.X () == p.X () && p.Y () == p.Y ()) { stale_ = true; }
+        return;
+    }
+    max_ = std::max (max_, ++*cell);
+}
+
+void HexCache::Evicted (const Point& p) {
+    if (stale_) { return; }
+    int *cell = Cell (p);
+    if (NULL == cell) { return; }
+    if ((*cell)-- == max_) { stale_max_ = true; }
+}
+
+SortedCache::~SortedCache () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+const std::vector< FloatType >& SortedCache::Update (const Dataset& data, 
+        Axis axis) {
+
+    if (&data == data_ && ! stale_[axis]) {
+        cacheCounter ("sorted").Hit ();
+        return values_[axis];
+    }
+
+    cacheCounter ("sorted").Miss ();
+    if (&data != data_) {
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+        stale_[AXIS_X] = stale_[AXIS_Y] = true;
+    }
+    if (AXIS_X == axis) {
+        data.XData (values_[axis]);
+    } else {
+        data.YData (values_[axis]);
+    }
+    radixSort (values_[axis]);
+    stale_[axis] = moving_[axis] = false;
+    return values_[axis];
+}
+
+const std::vector< FloatType > * SortedCache::Settled (const Dataset& data,
+        Axis axis) {
+    if (&data == data_ && stale_[axis] && moving_[axis]) {
+        /* still streaming: wait for it to settle */
+        moving_[axis] = false;
+        return NULL;
+    }
+    return &Update (data, axis);
+}
+
+void SortedCache::Inserted (const Point&) {
+    stale_[AXIS_X] = stale_[AXIS_Y] = true;
+    moving_[AXIS_X] = moving_[AXIS_Y] = true;
+}
+
+void SortedCache::Evicted (const Point&) {
+    stale_[AXIS_X] = stale_[AXIS_Y] = true;
+    moving_[AXIS_X] = moving_[AXIS_Y] = true;
+}
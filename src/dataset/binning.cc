@@ -0,0 +1,82 @@
+
+#include <cmath>
+#include <algorithm>
+#include <dataset/binning.h>
+
+long binCounts (const Dataset& data, Axis axis, const Range& domain, 
+        int nbins, std::vector< long >& bins) {
+
+    Dataset::const_iterator DIT = data.Begin (), DEND = data.End ();
+    long bin_max = 0;
+
+    bins.assign (std::max (nbins, 0), 0);
+
+    for (; DIT != DEND; ++DIT) {
+        int bin = binIndex ((AXIS_X == axis) ? DIT->X () : DIT->Y (),
+                domain, nbins);
+        if (bin < 0) { continue; }
+        bins[bin]++;
+        bin_max = std::max (bin_max, bins[bin]);
+    }
+
+    return bin_max;
+}
+
+long sortedBinCounts (const std::vector< FloatType >& sorted, 
+        const Range& domain, int nbins, std::vector< long >& bins) {
+
+    bins.assign (std::max (nbins, 0), 0);
+    if (nbins <= 0) { return 0; }
+
+    /*
+     * The bin binIndex () gives [v] before it drops those out of range;
+     * never decreasing in [v], so each bin is a run of the sorted values
+     */
+    FloatType bin_width = domain.Distance () / nbins;
+    FloatType low = domain.Low ();
+    auto before = [=] (FloatType v, FloatType bin) {
+        FloatType b = (bin_width > 0.0) ? floor ((v - low) / bin_width) : 0.0;
+        if (b == nbins) { --b; }
+        return b < bin;
+    };
+
+    std::vector< FloatType >::const_iterator VIT = std::partition_point (
+            sorted.begin (), sorted.end (), 
+            [&] (FloatType v) { return before (v, 0.0); });
+    long bin_max = 0;
+    for (int bin = 0; bin < nbins; ++bin) {
+        std::vector< FloatType >::const_iterator VNEXT = std::partition_point (
+                VIT, sorted.end (),
+                [&] (FloatType v) { return before (v, bin + 1.0); });
+        bins[bin] = VNEXT - VIT;
+        bin_max = std::max (bin_max, bins[bin]);
+        VIT = VNEXT;
+    }
+
+    return bin_max;
+}
+
+int hexCounts (const Dataset& data, 
+        const Range& xdomain, const Range& ydomain,
+        const Range& xrange, const Range& yrange,
+        FloatType width, FloatType height, FloatType offset,
+        std::vector< std::vector< int > >& grid) {
+
+    int nxbins = static_cast< int >(ceil (xrange.Distance () / width));
+    int nybins = static_cast< int >(ceil (yrange.Distance () / height));
+
+    grid.assign (nybins, std::vector< int >(nxbins, 0));
+
+    Dataset::const_iterator DIT = data.Begin (), DEND = data.End ();
+    int yidx = 0, xidx = 0, maxbin = 0;
+    for (; DIT != DEND; ++DIT) {
+        if (! hexIndex (*DIT, xdomain, ydomain, xrange, yrange, 
+                    width, height, offset, nybins, nxbins, yidx, xidx)) {
+            continue;
+        }
+        grid[yidx][xidx] += 1;
+        maxbin = std::max (maxbin, grid[yidx][xidx]);
+    }
+
+    return maxbin;
+}
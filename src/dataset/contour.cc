@@ -0,0 +1,241 @@
+
+#include <cmath>
+#include <algorithm>
+#include <dataset/contour.h>
+#include <dataset/parallel.h>
+#include <dataset/radix.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+/* Rows (or columns) of the grid per blurring or tracing task */
+#define CONTOUR_BAND 16
+
+/* Box passes making up each Gaussian */
+#define CONTOUR_PASSES 3
+
+/* Sigmas of margin counted around the view before blurring */
+#define CONTOUR_MARGIN 3.0
+
+/*
+ * Radius of the boxes whose CONTOUR_PASSES convolutions have about the
+ * variance of a Gaussian of [sigma] cells: a box of width w has variance
+ * (w^2 - 1) / 12
+ */
+static int boxRadius (FloatType sigma) {
+    if (! (sigma > 0.0)) { return 0; }
+    FloatType width = sqrt (12.0 * sigma * sigma / CONTOUR_PASSES + 1.0);
+    return static_cast< int >(floor ((width - 1.0) / 2.0 + 0.5));
+}
+
+/* Mean of the [n] values of [in] within [r] of each into [out] */
+static void boxLine (const FloatType *in, FloatType *out, int n, int r) {
+    double sum = 0.0, scale = 1.0 / (2 * r + 1);
+    for (int i = 0; i < std::min (r, n); ++i) { sum += in[i]; }
+    for (int i = 0; i < n; ++i) {
+        if (i + r < n) { sum += in[i + r]; }
+        out[i] = sum * scale;
+        if (i - r >= 0) { sum -= in[i - r]; }
+    }
+}
+
+/* Blur the [n] values of [line] [stride] apart with boxes of radius [r] */
+static void blurLine (FloatType *line, int n, std::size_t stride, int r,
+        std::vector< FloatType >& a, std::vector< FloatType >& b) {
+    a.resize (n);
+    b.resize (n);
+    for (int i = 0; i < n; ++i) { a[i] = line[i * stride]; }
+    for (int pass = 0; pass < CONTOUR_PASSES; ++pass) {
+        boxLine (&a[0], &b[0], n, r);
+        a.swap (b);
+    }
+    for (int i = 0; i < n; ++i) { line[i * stride] = a[i]; }
+}
+
+void blurGrid (std::vector< FloatType >& grid, int ncols, int nrows,
+        FloatType xsigma, FloatType ysigma) {
+
+    TRACE_SCOPE ("blurGrid");
+    if (ncols <= 0 || nrows <= 0) { return; }
+    int xr = boxRadius (xsigma), yr = boxRadius (ysigma);
+
+    if (xr > 0) {
+        parallelFor ((nrows + CONTOUR_BAND - 1) / CONTOUR_BAND,
+                [&] (std::size_t band) {
+            std::vector< FloatType > a, b;
+            int end = std::min (nrows, static_cast< int >(band + 1) *
+                    CONTOUR_BAND);
+            for (int r = band * CONTOUR_BAND; r < end; ++r) {
+                blurLine (&grid[r * ncols], ncols, 1, xr, a, b);
+            }
+        });
+    }
+    if (yr > 0) {
+        parallelFor ((ncols + CONTOUR_BAND - 1) / CONTOUR_BAND,
+                [&] (std::size_t band) {
+            std::vector< FloatType > a, b;
+            int end = std::min (ncols, static_cast< int >(band + 1) *
+                    CONTOUR_BAND);
+            for (int c = band * CONTOUR_BAND; c < end; ++c) {
+                blurLine (&grid[c], nrows, ncols, yr, a, b);
+            }
+        });
+    }
+}
+
+std::vector< FloatType > massLevels (const std::vector< FloatType >& grid,
+        const std::vector< FloatType >& shares) {
+
+    std::vector< FloatType > levels;
+    std::vector< FloatType > sorted (grid);
+    radixSort (sorted);
+
+    /* mass from the densest cell down, then the level each share needs */
+    std::vector< double > above (sorted.size () + 1, 0.0);
+    for (std::size_t i = sorted.size (); i > 0; --i) {
+        FloatType v = sorted[i - 1];
+        above[i - 1] = above[i] + ((v > 0.0) ? v : 0.0);
+    }
+    double total = above[0];
+    if (! (total > 0.0)) { return levels; }
+
+    for (std::size_t s = 0; s < shares.size (); ++s) {
+        FloatType share = shares[s];
+        if (! (share > 0.0 && share < 1.0)) { continue; }
+        /* the last cell from the top that is still needed */
+        std::size_t lo = 0, hi = sorted.size ();
+        while (lo + 1 < hi) {
+            std::size_t mid = (lo + hi) / 2;
+            if (above[mid] >= share * total) { lo = mid; } else { hi = mid; }
+        }
+        if (sorted[lo] > 0.0) { levels.push_back (sorted[lo]); }
+    }
+    return levels;
+}
+
+/* Where [level] crosses between values [a] at [p] and [b] at [q] */
+static Point crossing (FloatType a, FloatType b, FloatType level,
+        const Point& p, const Point& q) {
+    FloatType t = (a == b) ? 0.5 : (level - a) / (b - a);
+    return Point (p.X () + t * (q.X () - p.X ()),
+            p.Y () + t * (q.Y () - p.Y ()));
+}
+
+/*
+ * Segments to draw for each case of corners at or above the level
+ * (bottom left 1, bottom right 2, top right 4, top left 8), as pairs of
+ * edges (bottom 0, right 1, top 2, left 3), -1 for none. Saddles (5
+ * and 10) list the pairs cutting off the two corners above the level,
+ * for a center below it; with the center above, the corners below are
+ * cut off instead, which are the pairs of the other saddle.
+ */
+static const int SEGMENTS[16][4] = {
+    { -1, -1, -1, -1 }, { 3, 0, -1, -1 }, { 0, 1, -1, -1 },
+    { 3, 1, -1, -1 }, { 1, 2, -1, -1 }, { 3, 0, 1, 2 },
+    { 0, 2, -1, -1 }, { 3, 2, -1, -1 }, { 3, 2, -1, -1 },
+    { 0, 2, -1, -1 }, { 0, 1, 3, 2 }, { 1, 2, -1, -1 },
+    { 3, 1, -1, -1 }, { 0, 1, -1, -1 }, { 3, 0, -1, -1 },
+    { -1, -1, -1, -1 }
+};
+
+void isolines (const std::vector< FloatType >& grid, int ncols, int nrows,
+        FloatType level, const Range& xlim, const Range& ylim,
+        std::vector< Line >& lines) {
+
+    TRACE_SCOPE ("isolines");
+    if (ncols < 2 || nrows < 2) { return; }
+    FloatType dx = xlim.Distance () / ncols, dy = ylim.Distance () / nrows;
+    FloatType x0 = xlim.Low () + dx / 2.0, y0 = ylim.Low () + dy / 2.0;
+
+    /* squares join the centers of rows r and r + 1 */
+    int squares = nrows - 1;
+    std::size_t bands = (squares + CONTOUR_BAND - 1) / CONTOUR_BAND;
+    std::vector< std::vector< Line > > found (bands);
+    parallelFor (bands, [&] (std::size_t band) {
+        int end = std::min (squares, static_cast< int >(band + 1) *
+                CONTOUR_BAND);
+        for (int r = band * CONTOUR_BAND; r < end; ++r) {
+            const FloatType *lo = &grid[r * ncols], *hi = lo + ncols;
+            for (int c = 0; c + 1 < ncols; ++c) {
+                FloatType v[4] = { lo[c], lo[c + 1], hi[c + 1], hi[c] };
+                int index = ((v[0] >= level) ? 1 : 0) |
+                    ((v[1] >= level) ? 2 : 0) | ((v[2] >= level) ? 4 : 0) |
+                    ((v[3] >= level) ? 8 : 0);
+                if (0 == index || 15 == index) { continue; }
+
+                Point corner[4] = {
+                    Point (x0 + c * dx, y0 + r * dy),
+                    Point (x0 + (c + 1) * dx, y0 + r * dy),
+                    Point (x0 + (c + 1) * dx, y0 + (r + 1) * dy),
+                    Point (x0 + c * dx, y0 + (r + 1) * dy)
+                };
+                /*
+                 * edges run left to right and bottom to top, so the
+                 * squares either side of one find the same crossing
+                 */
+                static const int FROM[4] = { 0, 1, 3, 0 }, TO[4] = { 1, 2, 2, 3 };
+                Point edge[4];
+                for (int e = 0; e < 4; ++e) {
+                    edge[e] = crossing (v[FROM[e]], v[TO[e]], level,
+                            corner[FROM[e]], corner[TO[e]]);
+                }
+
+                if ((5 == index || 10 == index) &&
+                        (v[0] + v[1] + v[2] + v[3]) / 4.0 >= level) {
+                    index = 15 - index;
+                }
+                const int *seg = SEGMENTS[index];
+                for (int s = 0; s < 4 && seg[s] >= 0; s += 2) {
+                    found[band].push_back (Line (edge[seg[s]],
+                                edge[seg[s + 1]]));
+                }
+            }
+        }
+    });
+    for (std::size_t b = 0; b < bands; ++b) {
+        lines.insert (lines.end (), found[b].begin (), found[b].end ());
+    }
+}
+
+const std::vector< Line >& DensityContours::Update (
+        const SummedAreaTable& table, const Range& xlim, const Range& ylim,
+        int ncols, int nrows, FloatType xsigma, FloatType ysigma,
+        const std::vector< FloatType >& shares) {
+
+    TRACE_SCOPE ("DensityContours::Update");
+    lines_.clear ();
+    if (shares.empty () || ncols < 2 || nrows < 2) { return lines_; }
+    if (! (xlim.Distance () > 0.0 && ylim.Distance () > 0.0)) {
+        return lines_;
+    }
+
+    /*
+     * points just off the view blur into it, so a margin of cells is
+     * counted all round (at most the view again on each side) and cut
+     * away after blurring
+     */
+    FloatType xs = xsigma * ncols / xlim.Distance (),
+              ys = ysigma * nrows / ylim.Distance ();
+    int xm = (xs > 0.0) ? static_cast< int >(std::min (
+                static_cast< FloatType >(ncols), ceil (CONTOUR_MARGIN * xs))) : 0;
+    int ym = (ys > 0.0) ? static_cast< int >(std::min (
+                static_cast< FloatType >(nrows), ceil (CONTOUR_MARGIN * ys))) : 0;
+    FloatType dx = xlim.Distance () / ncols, dy = ylim.Distance () / nrows;
+    Range xwide (xlim.Low () - xm * dx, xlim.High () + xm * dx);
+    Range ywide (ylim.Low () - ym * dy, ylim.High () + ym * dy);
+    int wcols = ncols + 2 * xm, wrows = nrows + 2 * ym;
+
+    table.Bins (xwide, ywide, wcols, wrows, wide_);
+    blurGrid (wide_, wcols, wrows, xs, ys);
+    grid_.resize (ncols * nrows);
+    for (int r = 0; r < nrows; ++r) {
+        std::vector< FloatType >::const_iterator row =
+            wide_.begin () + (r + ym) * wcols + xm;
+        std::copy (row, row + ncols, grid_.begin () + r * ncols);
+    }
+
+    std::vector< FloatType > levels = massLevels (grid_, shares);
+    for (std::size_t i = 0; i < levels.size (); ++i) {
+        isolines (grid_, ncols, nrows, levels[i], xlim, ylim, lines_);
+    }
+    return lines_;
+}
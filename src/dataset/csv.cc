@@ -0,0 +1,42 @@
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dataset/csv.h>
+
+void load (const char *csv, std::vector< Point > &pts) {
+    FILE *fin = fopen (csv, "rb");
+    if (NULL == fin) { return; }
+    while (! ferror (fin) && ! feof (fin)) {
+        FloatType x = 0, y = 0;
+        if (2 != fscanf (fin, "%lf,%lf", &x, &y)) {
+            break;
+        }
+        pts.push_back (Point (x,y));
+        if (feof (fin)) { break; }
+    }
+    fclose (fin);
+}
+
+std::size_t parse (const char *buf, std::size_t len, std::vector< Point > &pts) {
+
+    const char *line = buf, *end = buf + len;
+    const char *nl = NULL;
+
+    while (NULL != (nl = static_cast< const char * >(
+                    memchr (line, '\n', end - line)))) {
+        /* strtod stops at the ',' and the newline, never past [nl] */
+        char *next = NULL;
+        FloatType x = strtod (line, &next);
+        if (next != line && next < nl && ',' == *next) {
+            const char *ystart = next + 1;
+            FloatType y = strtod (ystart, &next);
+            if (next != ystart && next <= nl) {
+                pts.push_back (Point (x, y));
+            }
+        }
+        line = nl + 1;
+    }
+
+    return line - buf;
+}
@@ -0,0 +1,190 @@
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <dataset/follow.h>
+#include <dataset/csv.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+extern "C" {
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+}
+
+/* How often the watcher re-checks the file without an inotify event */
+#define FOLLOW_POLL_MS 100
+#define FOLLOW_CHUNK (1 << 16)
+
+Follow::Follow (const char *path) : path_(path), fd_(-1), inotify_(-1), 
+    watch_(-1), offset_(0), running_(false), signalled_(false), rows_(0) {
+    al_init_user_event_source (&source_);
+}
+
+Follow::~Follow () {
+    Stop ();
+    al_destroy_user_event_source (&source_);
+}
+
+bool Follow::Open () {
+    fd_ = open (path_.c_str (), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) { return false; }
+    if (inotify_ >= 0) {
+        watch_ = inotify_add_watch (inotify_, path_.c_str (), 
+                IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+    }
+    return true;
+}
+
+void Follow::Close () {
+    if (watch_ >= 0) {
+        inotify_rm_watch (inotify_, watch_);
+        watch_ = -1;
+    }
+    if (fd_ >= 0) {
+        close (fd_);
+        fd_ = -1;
+    }
+}
+
+bool Follow::Read (std::vector< Point >& pts) {
+
+    if (fd_ < 0 && ! Open ()) { return false; }
+
+    std::size_t before = pts.size ();
+    char chunk[FOLLOW_CHUNK];
+
+    for (;;) {
+        struct stat sb;
+        if (0 != fstat (fd_, &sb)) { return false; }
+        if (sb.st_size < offset_) {
+            /* truncated in place; start over */
+            offset_ = 0;
+            partial_.clear ();
+        }
+
+        ssize_t n = 0;
+        while (0 < (n = pread (fd_, chunk, FOLLOW_CHUNK, offset_))) {
+            offset_ += n;
+            partial_.append (chunk, n);
+            partial_.erase (0, parse (partial_.c_str (), partial_.size (), pts));
+        }
+
+        /* rotated (renamed/deleted and recreated) once fully read */
+        struct stat path_sb;
+        if (0 == stat (path_.c_str (), &path_sb) && 
+                (path_sb.st_ino != sb.st_ino || path_sb.st_dev != sb.st_dev)) {
+            Close ();
+            offset_ = 0;
+            partial_.clear ();
+            if (! Open ()) { break; }
+            continue;
+        }
+        break;
+    }
+
+    rows_ += pts.size () - before;
+    return true;
+}
+
+bool Follow::Start () {
+
+    if (running_) { return false; }
+
+    inotify_ = inotify_init1 (IN_CLOEXEC);
+    if (inotify_ < 0) {
+        perror ("inotify");
+        return false;
+    }
+    if (fd_ >= 0) {
+        watch_ = inotify_add_watch (inotify_, path_.c_str (), 
+                IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+    }
+
+    running_ = true;
+    thread_ = std::thread (&Follow::Watch, this);
+    return true;
+}
+
+void Follow::Stop () {
+
+    running_ = false;
+    if (thread_.joinable ()) {
+        thread_.join ();
+    }
+
+    Close ();
+    if (inotify_ >= 0) {
+        close (inotify_);
+        inotify_ = -1;
+    }
+}
+
+void Follow::Watch () {
+
+    traceThreadName ("follow");
+
+    /* the events only say something changed; Read () works out what */
+    char events[4096] 
+        __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+
+    while (running_) {
+
+        struct pollfd pfd;
+        pfd.fd = inotify_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (0 < poll (&pfd, 1, FOLLOW_POLL_MS) && 
+                0 > read (inotify_, events, sizeof (events)) && 
+                EINTR != errno) {
+            perror ("inotify");
+            break;
+        }
+
+        std::vector< Point > pts;
+        Read (pts);
+        if (pts.empty ()) { continue; }
+
+        {
+            std::lock_guard< std::mutex > guard (lock_);
+            if (pending_.empty ()) {
+                pending_.swap (pts);
+            } else {
+                pending_.insert (pending_.end (), pts.begin (), pts.end ());
+            }
+        }
+
+        if (! signalled_.exchange (true)) {
+            ALLEGRO_EVENT event;
+            memset (&event, 0, sizeof (event));
+            event.user.type = FOLLOW_EVENT;
+            al_emit_user_event (&source_, &event, NULL);
+        }
+    }
+}
+
+std::size_t Follow::Drain (Dataset& data) {
+
+    ScopedTimer timer (plotStats ("follow"), STAGE_LOAD);
+    TRACE_SCOPE ("Follow::Drain");
+
+    std::vector< Point > pts;
+
+    signalled_ = false;
+    {
+        std::lock_guard< std::mutex > guard (lock_);
+        pts.swap (pending_);
+    }
+
+    std::vector< Point >::const_iterator PIT = pts.begin (), 
+        PEND = pts.end ();
+    for (; PIT != PEND; ++PIT) {
+        data.Add (*PIT);
+    }
+
+    plotStats ("follow").Points (rows_);
+    return pts.size ();
+}
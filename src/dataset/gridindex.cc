@@ -0,0 +1,133 @@
+
+#include <cmath>
+#include <algorithm>
+#include <dataset/gridindex.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+GridIndex::~GridIndex () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+void GridIndex::Update (const Dataset& data) {
+
+    if (&data == data_ && ! stale_) {
+        cacheCounter ("grid").Hit ();
+        return;
+    }
+
+    TRACE_SCOPE ("GridIndex::Update");
+    cacheCounter ("grid").Miss ();
+    if (&data != data_) {
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+    }
+    stale_ = false;
+
+    Build (data.Begin (), data.End (), data.Size (), data.XDomain (),
+            data.YDomain ());
+}
+
+void GridIndex::Assign (const std::vector< Point >& points,
+        const Range& xdomain, const Range& ydomain) {
+    if (NULL != data_) {
+        data_->Detach (this);
+        data_ = NULL;
+    }
+    stale_ = false;
+    Build (points.begin (), points.end (), points.size (), xdomain, ydomain);
+}
+
+template < typename Iterator >
+void GridIndex::Build (Iterator begin, Iterator end, std::size_t n,
+        const Range& xdomain, const Range& ydomain) {
+
+    xdomain_.Reset (xdomain.X (), xdomain.Y ());
+    ydomain_.Reset (ydomain.X (), ydomain.Y ());
+    xbounds_.Reset (xdomain.X (), xdomain.Y ());
+    ybounds_.Reset (ydomain.X (), ydomain.Y ());
+    int side = static_cast< int >(sqrt (static_cast< double >(n) / GRID_LOAD));
+    cols_ = rows_ = std::max (1, std::min (side, GRID_MAX_SIDE));
+
+    /* counting sort by cell: sizes, offsets, then the points */
+    std::vector< int > cells;
+    cells.reserve (n);
+    start_.assign (cols_ * rows_ + 1, 0);
+    for (Iterator PIT = begin; PIT != end; ++PIT) {
+        FloatType x = PIT->X (), y = PIT->Y ();
+        if (x != x || y != y) {
+            cells.push_back (-1);
+            continue;
+        }
+        int cell = Cell (y, ydomain_, rows_) * cols_ + 
+            Cell (x, xdomain_, cols_);
+        cells.push_back (cell);
+        start_[cell + 1]++;
+    }
+    for (std::size_t c = 1; c < start_.size (); ++c) {
+        start_[c] += start_[c - 1];
+    }
+
+    std::vector< std::size_t > next (start_.begin (), start_.end () - 1);
+    xs_.resize (start_.back ());
+    ys_.resize (start_.back ());
+    std::size_t i = 0;
+    for (Iterator PIT = begin; PIT != end; ++PIT, ++i) {
+        if (cells[i] < 0) { continue; }
+        std::size_t at = next[cells[i]]++;
+        xs_[at] = PIT->X ();
+        ys_[at] = PIT->Y ();
+    }
+
+    added_.clear ();
+    built_ = start_.back ();
+    inserted_ = struck_ = 0;
+}
+
+void GridIndex::Inserted (const Point& p) {
+    if (stale_ || p.X () != p.X () || p.Y () != p.Y ()) { return; }
+    if (inserted_ >= std::max (built_, static_cast< std::size_t >(GRID_LOAD))) {
+        /* cheaper to lay the grid out again for the larger size */
+        stale_ = true;
+        return;
+    }
+    if (added_.empty ()) { added_.resize (cols_ * rows_); }
+    added_[Cell (p.Y (), ydomain_, rows_) * cols_ + 
+        Cell (p.X (), xdomain_, cols_)].push_back (p);
+    ++inserted_;
+    xbounds_.Reset (std::min (xbounds_.Low (), p.X ()),
+            std::max (xbounds_.High (), p.X ()));
+    ybounds_.Reset (std::min (ybounds_.Low (), p.Y ()),
+            std::max (ybounds_.High (), p.Y ()));
+}
+
+void GridIndex::Evicted (const Point& p) {
+    if (stale_ || p.X () != p.X () || p.Y () != p.Y ()) { return; }
+    int cell = Cell (p.Y (), ydomain_, rows_) * cols_ + 
+        Cell (p.X (), xdomain_, cols_);
+
+    if (0 < inserted_) {
+        std::vector< Point >& bucket = added_[cell];
+        std::vector< Point >::iterator PIT = bucket.begin (),
+            PEND = bucket.end ();
+        for (; PIT != PEND; ++PIT) {
+            if (PIT->X () == p.X () && PIT->Y () == p.Y ()) {
+                *PIT = bucket.back ();
+                bucket.pop_back ();
+                --inserted_;
+                return;
+            }
+        }
+    }
+
+    for (std::size_t i = start_[cell]; i < start_[cell + 1]; ++i) {
+        if (xs_[i] == p.X () && ys_[i] == p.Y ()) {
+            xs_[i] = ys_[i] = NAN;
+            if (2 * ++struck_ > built_) { stale_ = true; }
+            return;
+        }
+    }
+    /* not indexed where it should be */
+    stale_ = true;
+}
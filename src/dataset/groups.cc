@@ -0,0 +1,121 @@
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <dataset/groups.h>
+#include <perf/trace.h>
+
+/* Finite extent of [xs], (0, 0) if there is none */
+static Range extent (const std::vector< FloatType >& xs) {
+    FloatType low = 0.0, high = 0.0;
+    bool any = false;
+    for (std::size_t i = 0; i < xs.size (); ++i) {
+        if (! std::isfinite (xs[i])) { continue; }
+        if (! any) {
+            low = high = xs[i];
+            any = true;
+        }
+        low = std::min (low, xs[i]);
+        high = std::max (high, xs[i]);
+    }
+    return Range (low, high);
+}
+
+Groups::~Groups () {
+    Clear ();
+}
+
+void Groups::Clear () {
+    for (std::size_t i = 0; i < views_.size (); ++i) {
+        delete views_[i];
+    }
+    views_.clear ();
+    keys_.clear ();
+    labels_.clear ();
+    xs_.clear ();
+    ys_.clear ();
+}
+
+bool Groups::Split (const Table& table, int by, int x, int y, size_type max) {
+
+    TRACE_SCOPE ("Groups::Split");
+
+    const std::vector< FloatType >& xs = table.Column (x);
+    const std::vector< FloatType >& ys = table.Column (y);
+    std::size_t n = std::min (xs.size (), ys.size ());
+
+    /* group of each row; built aside so a failed split changes nothing */
+    std::vector< FloatType > keys;
+    std::vector< std::string > labels;
+    std::vector< int > group;
+    if (COLUMN_CATEGORY == table.Kind (by)) {
+        /* the codes already number the names in order */
+        const std::vector< std::uint32_t >& codes = table.Codes (by);
+        const std::vector< std::string >& names = table.Categories (by);
+        if (names.size () > max) {
+            return false;
+        }
+        n = std::min (n, codes.size ());
+        group.assign (n, -1);
+        for (std::size_t r = 0; r < n; ++r) {
+            if (TABLE_NO_CODE != codes[r]) { group[r] = codes[r]; }
+        }
+        for (std::size_t g = 0; g < names.size (); ++g) {
+            keys.push_back (g);
+            labels.push_back (names[g]);
+        }
+    } else {
+        const std::vector< FloatType >& cats = table.Column (by);
+        n = std::min (n, cats.size ());
+        for (std::size_t r = 0; r < n; ++r) {
+            if (cats[r] != cats[r]) { continue; }
+            if (keys.end () == std::find (keys.begin (), keys.end (), cats[r])) {
+                if (keys.size () == max) {
+                    return false;
+                }
+                keys.push_back (cats[r]);
+            }
+        }
+        std::sort (keys.begin (), keys.end ());
+        group.assign (n, -1);
+        for (std::size_t r = 0; r < n; ++r) {
+            if (cats[r] != cats[r]) { continue; }
+            group[r] = std::lower_bound (keys.begin (), keys.end (), cats[r]) -
+                keys.begin ();
+        }
+        for (std::size_t g = 0; g < keys.size (); ++g) {
+            char buff[64];
+            snprintf (buff, sizeof (buff), "%g", keys[g]);
+            labels.push_back (buff);
+        }
+    }
+
+    /* then gather with the sizes known up front */
+    std::vector< std::size_t > counts (keys.size (), 0);
+    for (std::size_t r = 0; r < n; ++r) {
+        if (group[r] >= 0) { counts[group[r]]++; }
+    }
+
+    std::vector< std::vector< FloatType > > gxs (keys.size ()), 
+        gys (keys.size ());
+    for (std::size_t g = 0; g < keys.size (); ++g) {
+        gxs[g].reserve (counts[g]);
+        gys[g].reserve (counts[g]);
+    }
+    for (std::size_t r = 0; r < n; ++r) {
+        if (group[r] < 0) { continue; }
+        gxs[group[r]].push_back (xs[r]);
+        gys[group[r]].push_back (ys[r]);
+    }
+
+    Clear ();
+    keys_.swap (keys);
+    labels_.swap (labels);
+    xs_.swap (gxs);
+    ys_.swap (gys);
+    for (std::size_t g = 0; g < keys_.size (); ++g) {
+        views_.push_back (new Dataset (xs_[g], ys_[g],
+                    extent (xs_[g]), extent (ys_[g])));
+    }
+    return true;
+}
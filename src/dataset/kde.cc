@@ -0,0 +1,240 @@
+
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <dataset/kde.h>
+#include <dataset/parallel.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+/* Fewest values each worker bins before the pass is split */
+#define KDE_SHARE 65536
+
+/* Bandwidths the kernel is cut off at, and output points per task */
+#define KDE_CUTOFF 4.0
+#define KDE_BLOCK 256
+
+static const std::size_t GRID = KDE_GRID;
+
+const char * bandwidth2str (int rule) {
+    switch (rule) {
+        case KDE_NONE: return "none";
+        case KDE_SILVERMAN: return "silverman";
+        case KDE_SCOTT: return "scott";
+        default: return "MISSING KDE CASE";
+    }
+}
+
+int str2bandwidth (const char *name) {
+    for (int rule = 0; rule < MAX_KDE; ++rule) {
+        if (0 == strcmp (name, bandwidth2str (rule))) { return rule; }
+    }
+    return -1;
+}
+
+KernelDensity::~KernelDensity () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+FloatType KernelDensity::Offset (FloatType v) const {
+    FloatType high = low_ + step_ * (GRID - 1);
+    if (! (v >= low_ && v <= high)) { return -1.0; }
+    if (! (step_ > 0.0)) { return 0.0; }
+    return std::min ((v - low_) / step_, static_cast< FloatType >(GRID - 1));
+}
+
+void KernelDensity::Spread (FloatType v, double w) {
+    FloatType at = Offset (v);
+    std::size_t i = std::min (static_cast< std::size_t >(at), GRID - 2);
+    FloatType f = at - i;
+    weights_[i] += w * (1.0 - f);
+    weights_[i + 1] += w * f;
+}
+
+bool KernelDensity::Grow (FloatType v) {
+    for (int g = 0; Offset (v) < 0.0; ++g) {
+        if (g == KDE_GROWTH || v != v || ! (step_ > 0.0)) { return false; }
+
+        /*
+         * every other grid point stays, shifted a whole grid towards
+         * [v] if it is below; the rest split between their neighbours
+         */
+        std::size_t shift = (v < low_) ? GRID - 1 : 0;
+        std::vector< double > merged (GRID, 0.0);
+        for (std::size_t i = 0; i < GRID; ++i) {
+            std::size_t at = i + shift;
+            if (0 == at % 2) {
+                merged[at / 2] += weights_[i];
+            } else {
+                merged[at / 2] += weights_[i] / 2.0;
+                merged[at / 2 + 1] += weights_[i] / 2.0;
+            }
+        }
+        weights_.swap (merged);
+        low_ -= shift * step_;
+        step_ *= 2.0;
+    }
+    return true;
+}
+
+const std::vector< FloatType >& KernelDensity::Update (const Dataset& data,
+        Axis axis, int rule) {
+
+    /* a grid grown far past a window's data resolves it too coarsely */
+    const Range& domain = (AXIS_X == axis) ? data.XDomain () : data.YDomain ();
+    if (KDE_LOOSE * domain.Distance () < step_ * (GRID - 1)) {
+        stale_ = true;
+    }
+
+    if (&data == data_ && axis == axis_ && ! stale_) {
+        cacheCounter ("kde").Hit ();
+        if (dirty_ || rule != rule_) {
+            rule_ = rule;
+            Convolve ();
+        }
+        return density_;
+    }
+
+    TRACE_SCOPE ("KernelDensity::Update");
+    cacheCounter ("kde").Miss ();
+    if (&data != data_) {
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+    }
+    axis_ = axis;
+    rule_ = rule;
+    stale_ = false;
+    Bin (data);
+    Convolve ();
+    return density_;
+}
+
+void KernelDensity::Bin (const Dataset& data) {
+
+    const Range& domain = (AXIS_X == axis_) ?
+        data.XDomain () : data.YDomain ();
+    low_ = domain.Low ();
+    step_ = domain.Distance () / (GRID - 1);
+    FloatType high = low_ + step_ * (GRID - 1);
+    FloatType scale = (step_ > 0.0) ? 1.0 / step_ : 0.0;
+
+    std::size_t n = data.Size ();
+    std::size_t shares = std::max (static_cast< std::size_t >(1),
+            std::min (parallelWorkers (), n / KDE_SHARE));
+
+    /* each share bins into its own grid, summed after */
+    std::vector< std::vector< double > > grids (shares - 1);
+    weights_.assign (GRID, 0.0);
+    parallelFor (shares, [&] (std::size_t s) {
+        std::vector< double >& grid = (0 == s) ? weights_ : grids[s - 1];
+        grid.resize (GRID, 0.0);
+        Dataset::const_iterator PIT = data.Begin () + (n * s / shares),
+            PEND = data.Begin () + (n * (s + 1) / shares);
+        for (; PIT != PEND; ++PIT) {
+            FloatType v = (AXIS_X == axis_) ? PIT->X () : PIT->Y ();
+            if (! (v >= low_ && v <= high)) { continue; }
+            FloatType at = (v - low_) * scale;
+            std::size_t i = std::min (static_cast< std::size_t >(at),
+                    GRID - 2);
+            FloatType f = at - i;
+            grid[i] += 1.0 - f;
+            grid[i + 1] += f;
+        }
+    });
+    for (std::size_t g = 0; g < grids.size (); ++g) {
+        for (std::size_t i = 0; i < GRID; ++i) { weights_[i] += grids[g][i]; }
+    }
+}
+
+/* The point of [weights] (cumulated in [below]) [q] of the way through */
+static FloatType quantile (const std::vector< double >& weights,
+        const std::vector< double >& below, double q) {
+    double target = q * below.back ();
+    std::size_t i = std::lower_bound (below.begin (), below.end (), target) -
+        below.begin ();
+    if (0 == i || ! (weights[i] > 0.0)) { return i; }
+    return (i - 1) + (target - below[i - 1]) / weights[i];
+}
+
+void KernelDensity::Convolve () {
+
+    TRACE_SCOPE ("KernelDensity::Convolve");
+    dirty_ = false;
+    density_.clear ();
+    bandwidth_ = 0.0;
+
+    /* the spread of the binned values, in grid steps */
+    std::vector< double > below (GRID);
+    double n = 0.0, sum = 0.0;
+    for (std::size_t i = 0; i < GRID; ++i) {
+        n += weights_[i];
+        sum += weights_[i] * i;
+        below[i] = n;
+    }
+    if (KDE_NONE == rule_ || n < 2.0 || ! (step_ > 0.0)) { return; }
+    double mean = sum / n, ss = 0.0;
+    for (std::size_t i = 0; i < GRID; ++i) {
+        ss += weights_[i] * (i - mean) * (i - mean);
+    }
+    double sd = sqrt (ss / (n - 1.0));
+    double spread = sd;
+    if (KDE_SILVERMAN == rule_) {
+        double iqr = quantile (weights_, below, 0.75) -
+            quantile (weights_, below, 0.25);
+        if (iqr > 0.0) { spread = std::min (sd, iqr / 1.34); }
+    }
+    double h = ((KDE_SCOTT == rule_) ? 1.06 : 0.9) * spread * pow (n, -0.2);
+    if (! (h > 0.0)) { return; }
+    bandwidth_ = h * step_;
+
+    /* the kernel at whole grid steps, and the estimate past either end */
+    std::size_t reach = static_cast< std::size_t >(ceil (KDE_CUTOFF * h));
+    std::size_t pad = std::min (reach, GRID);
+    reach = std::min (reach, GRID + pad);
+    std::vector< double > kernel (reach + 1);
+    for (std::size_t d = 0; d <= reach; ++d) {
+        kernel[d] = exp (-0.5 * (d / h) * (d / h)) /
+            (n * bandwidth_ * sqrt (2.0 * M_PI));
+    }
+    first_ = low_ - pad * step_;
+    density_.assign (GRID + 2 * pad, 0.0);
+
+    std::size_t m = density_.size ();
+    parallelFor ((m + KDE_BLOCK - 1) / KDE_BLOCK, [&] (std::size_t b) {
+        std::size_t end = std::min (m, (b + 1) * KDE_BLOCK);
+        for (std::size_t k = b * KDE_BLOCK; k < end; ++k) {
+            /* output k sits over grid point k - pad */
+            long at = static_cast< long >(k) - static_cast< long >(pad);
+            long j0 = std::max (0L, at - static_cast< long >(reach));
+            long j1 = std::min (static_cast< long >(GRID) - 1,
+                    at + static_cast< long >(reach));
+            double f = 0.0;
+            for (long j = j0; j <= j1; ++j) {
+                f += weights_[j] * kernel[std::abs (at - j)];
+            }
+            density_[k] = f;
+        }
+    });
+}
+
+void KernelDensity::Inserted (const Point& p) {
+    if (stale_ || weights_.empty ()) { return; }
+    FloatType v = (AXIS_X == axis_) ? p.X () : p.Y ();
+    if (v != v) { return; }
+    if (! Grow (v)) {
+        stale_ = true;
+        return;
+    }
+    Spread (v, 1.0);
+    dirty_ = true;
+}
+
+void KernelDensity::Evicted (const Point& p) {
+    if (stale_ || weights_.empty ()) { return; }
+    FloatType v = (AXIS_X == axis_) ? p.X () : p.Y ();
+    if (Offset (v) < 0.0) { return; }
+    Spread (v, -1.0);
+    dirty_ = true;
+}
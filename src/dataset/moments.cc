@@ -0,0 +1,201 @@
+
+#include <cmath>
+#include <algorithm>
+#include <dataset/moments.h>
+#include <dataset/parallel.h>
+#include <graph/exceptions.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+/* Fewest points each worker sums before the pass is split */
+#define MOMENTS_SHARE 65536
+
+void Moments::Add (FloatType x) {
+    double n1 = n_++, n = n_;
+    double delta = x - mean_, dn = delta / n, dn2 = dn * dn;
+    double term = delta * dn * n1;
+    mean_ += dn;
+    m4_ += term * dn2 * (n * n - 3.0 * n + 3.0) + 6.0 * dn2 * m2_ -
+        4.0 * dn * m3_;
+    m3_ += term * dn * (n - 2.0) - 3.0 * dn * m2_;
+    m2_ += term;
+}
+
+void Moments::Remove (FloatType x) {
+    if (n_ <= 1) {
+        *this = Moments ();
+        return;
+    }
+    /* Add () run backwards: the old mean first, then M2, M3, M4 */
+    double n = n_--;
+    mean_ = (n * mean_ - x) / (n - 1.0);
+    double delta = x - mean_, dn = delta / n, dn2 = dn * dn;
+    double term = delta * dn * (n - 1.0);
+    m2_ -= term;
+    m3_ -= term * dn * (n - 2.0) - 3.0 * dn * m2_;
+    m4_ -= term * dn2 * (n * n - 3.0 * n + 3.0) + 6.0 * dn2 * m2_ -
+        4.0 * dn * m3_;
+}
+
+void Moments::Merge (const Moments& other) {
+    if (0 == other.n_) { return; }
+    if (0 == n_) {
+        *this = other;
+        return;
+    }
+    double na = n_, nb = other.n_, n = na + nb;
+    double delta = other.mean_ - mean_, d2 = delta * delta;
+    m4_ += other.m4_ +
+        d2 * d2 * na * nb * (na * na - na * nb + nb * nb) / (n * n * n) +
+        6.0 * d2 * (na * na * other.m2_ + nb * nb * m2_) / (n * n) +
+        4.0 * delta * (na * other.m3_ - nb * m3_) / n;
+    m3_ += other.m3_ + d2 * delta * na * nb * (na - nb) / (n * n) +
+        3.0 * delta * (na * other.m2_ - nb * m2_) / n;
+    m2_ += other.m2_ + d2 * na * nb / n;
+    mean_ += delta * nb / n;
+    n_ += other.n_;
+}
+
+FloatType Moments::Variance () const {
+    return (n_ < 2) ? 0.0 : std::max (0.0, m2_ / (n_ - 1));
+}
+
+FloatType Moments::StdDev () const { return sqrt (Variance ()); }
+
+FloatType Moments::Skewness () const {
+    if (n_ < 2 || ! (m2_ > 0.0)) { return 0.0; }
+    return sqrt (static_cast< double >(n_)) * m3_ / pow (m2_, 1.5);
+}
+
+FloatType Moments::Kurtosis () const {
+    if (n_ < 2 || ! (m2_ > 0.0)) { return 0.0; }
+    return n_ * m4_ / (m2_ * m2_) - 3.0;
+}
+
+void Comoments::Add (FloatType x, FloatType y) {
+    double dx = x - x_.Mean ();
+    x_.Add (x);
+    y_.Add (y);
+    cxy_ += dx * (y - y_.Mean ());
+}
+
+void Comoments::Remove (FloatType x, FloatType y) {
+    double ymean = y_.Mean ();
+    x_.Remove (x);
+    y_.Remove (y);
+    cxy_ = (0 == Count ()) ? 0.0 : cxy_ - (x - x_.Mean ()) * (y - ymean);
+}
+
+void Comoments::Merge (const Comoments& other) {
+    if (0 == other.Count ()) { return; }
+    if (0 == Count ()) {
+        *this = other;
+        return;
+    }
+    double na = Count (), nb = other.Count ();
+    double dx = other.x_.Mean () - x_.Mean ();
+    double dy = other.y_.Mean () - y_.Mean ();
+    cxy_ += other.cxy_ + dx * dy * na * nb / (na + nb);
+    x_.Merge (other.x_);
+    y_.Merge (other.y_);
+}
+
+FloatType Comoments::Covariance () const {
+    return (Count () < 2) ? 0.0 : cxy_ / (Count () - 1);
+}
+
+FloatType Comoments::Correlation () const {
+    double sxx = x_.M2 (), syy = y_.M2 ();
+    if (! (sxx > 0.0 && syy > 0.0)) { return 0.0; }
+    return std::max (-1.0, std::min (1.0, cxy_ / sqrt (sxx * syy)));
+}
+
+void PointMoments::Add (const Point& p) {
+    FloatType x = p.X (), y = p.Y ();
+    bool xok = std::isfinite (x), yok = std::isfinite (y);
+    if (xok) { x_.Add (x); }
+    if (yok) { y_.Add (y); }
+    if (xok && yok) { xy_.Add (x, y); }
+}
+
+void PointMoments::Remove (const Point& p) {
+    FloatType x = p.X (), y = p.Y ();
+    bool xok = std::isfinite (x), yok = std::isfinite (y);
+    if (xok) { x_.Remove (x); }
+    if (yok) { y_.Remove (y); }
+    if (xok && yok) { xy_.Remove (x, y); }
+}
+
+void PointMoments::Merge (const PointMoments& other) {
+    x_.Merge (other.x_);
+    y_.Merge (other.y_);
+    xy_.Merge (other.xy_);
+}
+
+/* Sum the points of [data] [keep] accepts in parallel shares, then merge */
+template < typename Keep >
+static PointMoments sumMoments (const Dataset& data, Keep keep) {
+    std::size_t n = data.Size ();
+    std::size_t shares = std::max (static_cast< std::size_t >(1),
+            std::min (parallelWorkers (), n / MOMENTS_SHARE));
+    std::vector< PointMoments > parts (shares);
+    parallelFor (shares, [&] (std::size_t s) {
+        std::size_t row = n * s / shares, end = n * (s + 1) / shares;
+        Dataset::const_iterator PIT = data.Begin () + row;
+        for (; row < end; ++row, ++PIT) {
+            if (keep (row)) { parts[s].Add (*PIT); }
+        }
+    });
+    /* merged in order so the result is the same on any number of threads */
+    for (std::size_t s = 1; s < shares; ++s) { parts[0].Merge (parts[s]); }
+    return parts[0];
+}
+
+PointMoments pointMoments (const Dataset& data) {
+    TRACE_SCOPE ("pointMoments");
+    return sumMoments (data, [] (std::size_t) { return true; });
+}
+
+PointMoments pointMoments (const Dataset& data,
+        const std::vector< bool >& selected) {
+    TRACE_SCOPE ("pointMoments");
+    if (selected.size () != data.Size ()) {
+        throw GeneralException ("Selection and data differ in size", __FILE__,
+                __LINE__);
+    }
+    return sumMoments (data, [&] (std::size_t row) { return selected[row]; });
+}
+
+MomentsCache::~MomentsCache () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+const PointMoments& MomentsCache::Update (const Dataset& data) {
+
+    if (&data == data_ && ! stale_) {
+        cacheCounter ("moments").Hit ();
+        return moments_;
+    }
+
+    cacheCounter ("moments").Miss ();
+    if (&data != data_) {
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+    }
+    moments_ = pointMoments (data);
+    removed_ = 0;
+    stale_ = false;
+    return moments_;
+}
+
+void MomentsCache::Inserted (const Point& p) {
+    if (! stale_) { moments_.Add (p); }
+}
+
+void MomentsCache::Evicted (const Point& p) {
+    if (stale_) { return; }
+    moments_.Remove (p);
+    long left = std::max (moments_.X ().Count (), moments_.Y ().Count ());
+    if (++removed_ > left) { stale_ = true; }
+}
@@ -0,0 +1,146 @@
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <condition_variable>
+#include <dataset/parallel.h>
+
+/*
+ * Worker threads sleep until a batch is posted, then pull indices
+ * from [next_] until they run out. [generation_] tells a woken worker
+ * whether there is a batch it has not joined yet; the batch is only
+ * torn down once no worker is [busy_] with it.
+ */
+class WorkerPool {
+
+    std::vector< std::thread > threads_;
+    std::mutex lock_, batch_lock_;
+    std::condition_variable wake_, done_;
+    const std::function< void (std::size_t) > *task_;
+    std::size_t n_;
+    std::atomic< std::size_t > next_;
+    std::size_t busy_;
+    unsigned long generation_;
+    bool stopping_;
+    std::exception_ptr error_;
+
+    WorkerPool (const WorkerPool&);
+
+    void Work ();
+    void Drain (const std::function< void (std::size_t) > *task, std::size_t n);
+
+public:
+
+    WorkerPool ();
+    ~WorkerPool ();
+
+    std::size_t Size () const { return threads_.size () + 1; }
+
+    void Run (std::size_t n, const std::function< void (std::size_t) >& task);
+
+};
+
+WorkerPool::WorkerPool () : task_(NULL), n_(0), next_(0), busy_(0),
+    generation_(0), stopping_(false) {
+    unsigned int cores = std::thread::hardware_concurrency ();
+    for (unsigned int i = 1; i < cores; ++i) {
+        threads_.push_back (std::thread (&WorkerPool::Work, this));
+    }
+}
+
+WorkerPool::~WorkerPool () {
+    {
+        std::lock_guard< std::mutex > guard (lock_);
+        stopping_ = true;
+    }
+    wake_.notify_all ();
+    for (std::size_t i = 0; i < threads_.size (); ++i) {
+        threads_[i].join ();
+    }
+}
+
+/* Set on a thread while it runs tasks, so the tasks run nested batches inline */
+static thread_local bool draining = false;
+
+void WorkerPool::Drain (const std::function< void (std::size_t) > *task,
+        std::size_t n) {
+    std::size_t i = 0;
+    draining = true;
+    while ((i = next_++) < n) {
+        try {
+            (*task) (i);
+        } catch (...) {
+            std::lock_guard< std::mutex > guard (lock_);
+            if (! error_) { error_ = std::current_exception (); }
+        }
+    }
+    draining = false;
+}
+
+void WorkerPool::Work () {
+    unsigned long seen = 0;
+    std::unique_lock< std::mutex > guard (lock_);
+    for (;;) {
+        wake_.wait (guard, [&] () { return stopping_ || seen != generation_; });
+        if (stopping_) { return; }
+        seen = generation_;
+        /* a batch that already finished has [n_] cleared */
+        if (0 == n_) { continue; }
+        const std::function< void (std::size_t) > *task = task_;
+        std::size_t n = n_;
+        ++busy_;
+        guard.unlock ();
+        Drain (task, n);
+        guard.lock ();
+        if (0 == --busy_) { done_.notify_all (); }
+    }
+}
+
+void WorkerPool::Run (std::size_t n,
+        const std::function< void (std::size_t) >& task) {
+
+    /* one batch at a time */
+    std::lock_guard< std::mutex > batch (batch_lock_);
+    {
+        std::lock_guard< std::mutex > guard (lock_);
+        task_ = &task;
+        n_ = n;
+        next_ = 0;
+        error_ = std::exception_ptr ();
+        ++generation_;
+    }
+    wake_.notify_all ();
+
+    Drain (&task, n);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock< std::mutex > guard (lock_);
+        done_.wait (guard, [&] () { return 0 == busy_; });
+        /* late wakers find nothing left to take */
+        task_ = NULL;
+        n_ = 0;
+        error = error_;
+    }
+    if (error) { std::rethrow_exception (error); }
+}
+
+static WorkerPool& pool () {
+    static WorkerPool workers;
+    return workers;
+}
+
+void parallelFor (std::size_t n,
+        const std::function< void (std::size_t) >& task) {
+    if (n <= 1 || draining) {
+        for (std::size_t i = 0; i < n; ++i) { task (i); }
+        return;
+    }
+    pool ().Run (n, task);
+}
+
+std::size_t parallelWorkers () {
+    return pool ().Size ();
+}
@@ -0,0 +1,252 @@
+
+#include <cmath>
+#include <algorithm>
+#include <dataset/pyramid.h>
+#include <dataset/parallel.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+/* Fewest points each worker counts before the pass is split */
+#define PYRAMID_SHARE 65536
+
+PointPyramid::~PointPyramid () {
+    if (NULL != data_) { data_->Detach (this); }
+    Clear ();
+}
+
+void PointPyramid::Clear () {
+    for (std::size_t i = 0; i < levels_.size (); ++i) {
+        delete levels_[i];
+    }
+    levels_.clear ();
+}
+
+PointPyramid::Cell& PointPyramid::Slot (Level& level, std::size_t cx,
+        std::size_t cy) {
+    std::size_t id = cy * level.side + cx;
+    if (PYRAMID_EMPTY == level.slots[id]) {
+        level.slots[id] = static_cast< std::uint32_t >(level.cells.size ());
+        Cell cell = { 0.0, 0.0, 0.0, 0.0, id, 0 };
+        level.cells.push_back (cell);
+        level.tiled[(cy / PYRAMID_TILE) * level.tiles + cx / PYRAMID_TILE].
+            push_back (level.slots[id]);
+    }
+    return level.cells[level.slots[id]];
+}
+
+void PointPyramid::Add (Level& level, const Point& p) const {
+    std::size_t k = PYRAMID_MAX_SIDE / level.side;
+    Cell& cell = Slot (level, CellOf (p.X (), xdomain_) / k,
+            CellOf (p.Y (), ydomain_) / k);
+    if (0 == cell.count) {
+        /* boxes of evicted points go with the last of them */
+        cell.xlow = cell.xhigh = p.X ();
+        cell.ylow = cell.yhigh = p.Y ();
+        ++level.occupied;
+    } else {
+        cell.xlow = std::min (cell.xlow, p.X ());
+        cell.xhigh = std::max (cell.xhigh, p.X ());
+        cell.ylow = std::min (cell.ylow, p.Y ());
+        cell.yhigh = std::max (cell.yhigh, p.Y ());
+    }
+    level.max = std::max (level.max, ++cell.count);
+}
+
+void PointPyramid::Merge (Level& level, std::size_t cx, std::size_t cy,
+        const Cell& from) {
+    Cell& cell = Slot (level, cx, cy);
+    if (0 == cell.count) {
+        cell.xlow = from.xlow;
+        cell.xhigh = from.xhigh;
+        cell.ylow = from.ylow;
+        cell.yhigh = from.yhigh;
+        ++level.occupied;
+    } else {
+        cell.xlow = std::min (cell.xlow, from.xlow);
+        cell.xhigh = std::max (cell.xhigh, from.xhigh);
+        cell.ylow = std::min (cell.ylow, from.ylow);
+        cell.yhigh = std::max (cell.yhigh, from.yhigh);
+    }
+    cell.count += from.count;
+    level.max = std::max (level.max, cell.count);
+}
+
+/* Lay the cells of [level] out tile by tile, the order they are drawn in */
+static void pack (PointPyramid::Level& level) {
+    std::vector< PointPyramid::Cell > cells;
+    cells.reserve (level.cells.size ());
+    for (std::size_t t = 0; t < level.tiled.size (); ++t) {
+        std::vector< std::size_t >::iterator SIT = level.tiled[t].begin (),
+            SEND = level.tiled[t].end ();
+        for (; SIT != SEND; ++SIT) {
+            level.slots[level.cells[*SIT].id] =
+                static_cast< std::uint32_t >(cells.size ());
+            cells.push_back (level.cells[*SIT]);
+            *SIT = cells.size () - 1;
+        }
+    }
+    level.cells.swap (cells);
+}
+
+/* An empty level of [side] cells across [xdomain] x [ydomain] */
+static PointPyramid::Level * newLevel (std::size_t side,
+        const Range& xdomain, const Range& ydomain) {
+    PointPyramid::Level *level = new PointPyramid::Level ();
+    level->side = side;
+    level->tiles = (side + PYRAMID_TILE - 1) / PYRAMID_TILE;
+    level->xcell = xdomain.Distance () / side;
+    level->ycell = ydomain.Distance () / side;
+    level->slots.assign (side * side, PYRAMID_EMPTY);
+    level->tiled.resize (level->tiles * level->tiles);
+    level->occupied = 0;
+    level->max = 0;
+    return level;
+}
+
+PointPyramid::Level * PointPyramid::Fill (std::size_t side,
+        const Dataset& data) const {
+    TRACE_SCOPE ("PointPyramid::Fill");
+    std::size_t n = data.Size ();
+    std::size_t shares = std::max (static_cast< std::size_t >(1),
+            std::min (parallelWorkers (), n / PYRAMID_SHARE));
+
+    /* each share counts into its own level, merged into the first after */
+    std::vector< Level * > parts (shares, NULL);
+    parallelFor (shares, [&] (std::size_t s) {
+        Level *part = newLevel (side, xdomain_, ydomain_);
+        Dataset::const_iterator PIT = data.Begin () + (n * s / shares),
+            PEND = data.Begin () + (n * (s + 1) / shares);
+        for (; PIT != PEND; ++PIT) {
+            Point p = *PIT;
+            if (p.X () != p.X () || p.Y () != p.Y ()) { continue; }
+            Add (*part, p);
+        }
+        parts[s] = part;
+    });
+
+    Level *level = parts[0];
+    for (std::size_t s = 1; s < shares; ++s) {
+        std::vector< Cell >::const_iterator CIT = parts[s]->cells.begin (),
+            CEND = parts[s]->cells.end ();
+        for (; CIT != CEND; ++CIT) {
+            Merge (*level, CIT->id % side, CIT->id / side, *CIT);
+        }
+        delete parts[s];
+    }
+    return level;
+}
+
+void PointPyramid::Update (const Dataset& data) {
+
+    if (&data == data_ && ! stale_ && data.Size () < 2 * built_) {
+        cacheCounter ("pyramid").Hit ();
+        return;
+    }
+
+    TRACE_SCOPE ("PointPyramid::Update");
+    cacheCounter ("pyramid").Miss ();
+    Clear ();
+    if (&data != data_) {
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+        grown_ = false;
+    }
+    stale_ = false;
+
+    std::size_t n = data.Size ();
+    built_ = std::max (n, static_cast< std::size_t >(1));
+    if (n < PYRAMID_MIN_POINTS) { return; }
+
+    /* data that grew past the grid once is likely to again */
+    const Range& xd = data.XDomain ();
+    const Range& yd = data.YDomain ();
+    FloatType xpad = grown_ ? PYRAMID_SLACK * xd.Distance () : 0.0,
+              ypad = grown_ ? PYRAMID_SLACK * yd.Distance () : 0.0;
+    xdomain_.Reset (xd.Low () - xpad, xd.High () + xpad);
+    ydomain_.Reset (yd.Low () - ypad, yd.High () + ypad);
+
+    /* about a cell per point */
+    std::size_t side = PYRAMID_MIN_SIDE;
+    while (2 * side <= PYRAMID_MAX_SIDE && 4 * side * side <= n) {
+        side *= 2;
+    }
+    const std::size_t base = side;
+    for (side = PYRAMID_MIN_SIDE; side < base; side *= 2) {
+        levels_.push_back (newLevel (side, xdomain_, ydomain_));
+    }
+    levels_.push_back (Fill (base, data));
+
+    /*
+     * clustered data may leave finer levels thinner than the points
+     * (each has at least as many cells as the one before)
+     */
+    while (2 * side <= PYRAMID_MAX_SIDE && side * side <= n &&
+            4 * levels_.back ()->occupied <= n) {
+        side *= 2;
+        Level *finer = Fill (side, data);
+        if (2 * finer->occupied > n) {
+            delete finer;
+            break;
+        }
+        levels_.push_back (finer);
+    }
+
+    /* each coarser cell is the four below it */
+    for (std::size_t l = levels_.size () - 1; l > 0; --l) {
+        if (levels_[l - 1]->side >= base) { continue; }
+        const Level& fine = *levels_[l];
+        Level& coarse = *levels_[l - 1];
+        std::vector< Cell >::const_iterator CIT = fine.cells.begin (),
+            CEND = fine.cells.end ();
+        for (; CIT != CEND; ++CIT) {
+            Merge (coarse, (CIT->id % fine.side) / 2,
+                    (CIT->id / fine.side) / 2, *CIT);
+        }
+    }
+    for (std::size_t l = 0; l < levels_.size (); ++l) { pack (*levels_[l]); }
+}
+
+void PointPyramid::Inserted (const Point& p) {
+    if (stale_ || levels_.empty () || p.X () != p.X () || p.Y () != p.Y ()) {
+        return;
+    }
+    if (! Inside (p)) {
+        stale_ = grown_ = true;
+        return;
+    }
+    for (std::size_t l = 0; l < levels_.size (); ++l) {
+        Add (*levels_[l], p);
+    }
+}
+
+void PointPyramid::Evicted (const Point& p) {
+    if (stale_ || levels_.empty () || p.X () != p.X () || p.Y () != p.Y ()) {
+        return;
+    }
+    std::size_t cx = CellOf (p.X (), xdomain_), cy = CellOf (p.Y (), ydomain_);
+    for (std::size_t l = 0; l < levels_.size (); ++l) {
+        Level& level = *levels_[l];
+        std::size_t k = PYRAMID_MAX_SIDE / level.side;
+        std::uint32_t slot = level.slots[(cy / k) * level.side + cx / k];
+        if (PYRAMID_EMPTY == slot || 0 == level.cells[slot].count) {
+            /* not counted where it should be */
+            stale_ = true;
+            return;
+        }
+        if (0 == --level.cells[slot].count) { --level.occupied; }
+    }
+}
+
+const PointPyramid::Level * PointPyramid::Select (FloatType xres,
+        FloatType yres) const {
+    if (NULL == data_) { return NULL; }
+    for (std::size_t l = 0; l < levels_.size (); ++l) {
+        /* finer levels only have more cells */
+        if (2 * levels_[l]->occupied > data_->Size ()) { return NULL; }
+        if (levels_[l]->xcell <= xres && levels_[l]->ycell <= yres) {
+            return levels_[l];
+        }
+    }
+    return NULL;
+}
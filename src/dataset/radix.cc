@@ -0,0 +1,146 @@
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <dataset/radix.h>
+#include <dataset/parallel.h>
+#include <graph/exceptions.h>
+#include <perf/trace.h>
+
+/* Bits sorted per pass, and values counted and moved by one task */
+#define RADIX_BITS 11
+#define RADIX_CHUNK 65536
+
+static const std::size_t BUCKETS = static_cast< std::size_t >(1) << RADIX_BITS;
+
+template < typename Float > struct KeyOf;
+template <> struct KeyOf< float > { typedef uint32_t type; };
+template <> struct KeyOf< double > { typedef uint64_t type; };
+
+typedef KeyOf< FloatType >::type Key;
+
+static const Key SIGN = static_cast< Key >(1) << (8 * sizeof (Key) - 1);
+
+/* An unsigned key in the numeric order of [v]; every NaN maps to the largest */
+static inline Key toKey (FloatType v) {
+    if (v != v) { return ~static_cast< Key >(0); }
+    Key k;
+    memcpy (&k, &v, sizeof (k));
+    return (k & SIGN) ? ~k : (k | SIGN);
+}
+
+static inline FloatType fromKey (Key k) {
+    k = (k & SIGN) ? (k & ~SIGN) : ~k;
+    FloatType v;
+    memcpy (&v, &k, sizeof (v));
+    return v;
+}
+
+/* Run [task] (begin, end) over [n] items in chunks on the worker pool */
+template < typename Task >
+static void chunked (std::size_t n, Task task) {
+    parallelFor ((n + RADIX_CHUNK - 1) / RADIX_CHUNK, [&] (std::size_t c) {
+        task (c * RADIX_CHUNK, std::min (n, (c + 1) * RADIX_CHUNK));
+    });
+}
+
+/* Sort [keys], and [rows] along with them unless NULL */
+static void sortKeys (std::vector< Key >& keys, std::vector< std::size_t > *rows) {
+
+    std::size_t n = keys.size ();
+    if (n < RADIX_MIN) {
+        if (NULL == rows) {
+            std::sort (keys.begin (), keys.end ());
+            return;
+        }
+        std::vector< std::size_t > order (n);
+        for (std::size_t i = 0; i < n; ++i) { order[i] = i; }
+        std::stable_sort (order.begin (), order.end (),
+                [&] (std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+        std::vector< Key > k (n);
+        std::vector< std::size_t > r (n);
+        for (std::size_t i = 0; i < n; ++i) {
+            k[i] = keys[order[i]];
+            r[i] = (*rows)[order[i]];
+        }
+        keys.swap (k);
+        rows->swap (r);
+        return;
+    }
+
+    std::size_t chunks = (n + RADIX_CHUNK - 1) / RADIX_CHUNK;
+    std::vector< std::size_t > counts (chunks * BUCKETS);
+    std::vector< Key > kbuf (n);
+    std::vector< std::size_t > rbuf ((NULL != rows) ? n : 0);
+
+    for (unsigned shift = 0; shift < 8 * sizeof (Key); shift += RADIX_BITS) {
+
+        const Key *src = keys.data ();
+        std::fill (counts.begin (), counts.end (), 0);
+        chunked (n, [&] (std::size_t begin, std::size_t end) {
+            std::size_t *count = &counts[(begin / RADIX_CHUNK) * BUCKETS];
+            for (std::size_t i = begin; i < end; ++i) {
+                ++count[(src[i] >> shift) & (BUCKETS - 1)];
+            }
+        });
+
+        /* a digit every key shares (e.g. of the exponent) orders nothing */
+        std::size_t first = (src[0] >> shift) & (BUCKETS - 1), same = 0;
+        for (std::size_t c = 0; c < chunks; ++c) {
+            same += counts[c * BUCKETS + first];
+        }
+        if (same == n) { continue; }
+
+        /* where each chunk's run of each digit starts, digit by digit */
+        std::size_t at = 0;
+        for (std::size_t d = 0; d < BUCKETS; ++d) {
+            for (std::size_t c = 0; c < chunks; ++c) {
+                std::size_t count = counts[c * BUCKETS + d];
+                counts[c * BUCKETS + d] = at;
+                at += count;
+            }
+        }
+
+        Key *kdst = kbuf.data ();
+        const std::size_t *rsrc = (NULL != rows) ? rows->data () : NULL;
+        std::size_t *rdst = rbuf.data ();
+        chunked (n, [&] (std::size_t begin, std::size_t end) {
+            std::size_t *next = &counts[(begin / RADIX_CHUNK) * BUCKETS];
+            for (std::size_t i = begin; i < end; ++i) {
+                std::size_t to = next[(src[i] >> shift) & (BUCKETS - 1)]++;
+                kdst[to] = src[i];
+                if (NULL != rsrc) { rdst[to] = rsrc[i]; }
+            }
+        });
+
+        keys.swap (kbuf);
+        if (NULL != rows) { rows->swap (rbuf); }
+    }
+}
+
+static void sortValues (std::vector< FloatType >& values,
+        std::vector< std::size_t > *rows) {
+    std::size_t n = values.size ();
+    std::vector< Key > keys (n);
+    chunked (n, [&] (std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) { keys[i] = toKey (values[i]); }
+    });
+    sortKeys (keys, rows);
+    chunked (n, [&] (std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) { values[i] = fromKey (keys[i]); }
+    });
+}
+
+void radixSort (std::vector< FloatType >& values) {
+    TRACE_SCOPE ("radixSort");
+    sortValues (values, NULL);
+}
+
+void radixSort (std::vector< FloatType >& keys, std::vector< std::size_t >& rows) {
+    TRACE_SCOPE ("radixSort");
+    if (rows.size () != keys.size ()) {
+        throw GeneralException ("Keys and rows differ in size", __FILE__,
+                __LINE__);
+    }
+    sortValues (keys, &rows);
+}
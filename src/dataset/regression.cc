@@ -0,0 +1,490 @@
+
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <dataset/regression.h>
+#include <dataset/parallel.h>
+#include <dataset/radix.h>
+#include <graph/exceptions.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+/* Fewest rows each worker sums or ranks before a pass is split */
+#define REGRESSION_SHARE 65536
+
+/* Rows of every column pair summed before moving to the next block */
+#define CORR_BLOCK 4096
+
+/* Half widths of the data either side of the origin x may stray to */
+#define FIT_REACH 4.0
+
+const char * correlation2str (int method) {
+    switch (method) {
+        case CORR_PEARSON: return "pearson";
+        case CORR_SPEARMAN: return "spearman";
+        default: return "MISSING CORR CASE";
+    }
+}
+
+int str2correlation (const char *name) {
+    for (int method = 0; method < MAX_CORR; ++method) {
+        if (0 == strcmp (name, correlation2str (method))) { return method; }
+    }
+    return -1;
+}
+
+FloatType Polynomial::At (FloatType x) const {
+    double t = (x - origin_) / scale_, y = 0.0;
+    for (std::size_t k = coefs_.size (); k > 0; --k) {
+        y = y * t + coefs_[k - 1];
+    }
+    return y + offset_;
+}
+
+PowerSums::PowerSums (FloatType xorigin, FloatType xscale,
+        FloatType yorigin) : xorigin_(xorigin), xscale_(xscale),
+    yorigin_(yorigin), n_(0), uu_(0.0) {
+    std::fill (t_, t_ + 2 * FIT_MAX_DEGREE + 1, 0.0);
+    std::fill (tu_, tu_ + FIT_MAX_DEGREE + 1, 0.0);
+}
+
+void PowerSums::Accumulate (FloatType x, FloatType y, double w) {
+    if (! std::isfinite (x) || ! std::isfinite (y)) { return; }
+    double t = (x - xorigin_) / xscale_, u = y - yorigin_, p = w;
+    for (int k = 0; k <= 2 * FIT_MAX_DEGREE; ++k) {
+        t_[k] += p;
+        if (k <= FIT_MAX_DEGREE) { tu_[k] += p * u; }
+        p *= t;
+    }
+    uu_ += w * u * u;
+    n_ += (w > 0.0) ? 1 : -1;
+}
+
+void PowerSums::Merge (const PowerSums& other) {
+    if (other.xorigin_ != xorigin_ || other.xscale_ != xscale_ ||
+            other.yorigin_ != yorigin_) {
+        throw GeneralException ("Power sums about different origins",
+                __FILE__, __LINE__);
+    }
+    for (int k = 0; k <= 2 * FIT_MAX_DEGREE; ++k) { t_[k] += other.t_[k]; }
+    for (int k = 0; k <= FIT_MAX_DEGREE; ++k) { tu_[k] += other.tu_[k]; }
+    uu_ += other.uu_;
+    n_ += other.n_;
+}
+
+FloatType PowerSums::Correlation () const {
+    if (n_ < 2) { return 0.0; }
+    double stt = t_[2] - t_[1] * t_[1] / n_, suu = uu_ - tu_[0] * tu_[0] / n_;
+    double stu = tu_[1] - t_[1] * tu_[0] / n_;
+    if (! (stt > 0.0 && suu > 0.0)) { return 0.0; }
+    return std::max (-1.0, std::min (1.0, stu / sqrt (stt * suu)));
+}
+
+Polynomial PowerSums::Fit (int degree) const {
+
+    int m = std::max (1, std::min (degree, FIT_MAX_DEGREE)) + 1;
+    if (n_ < m) { return Polynomial (); }
+
+    /* the normal equations, solved with partial pivoting */
+    double a[FIT_MAX_DEGREE + 1][FIT_MAX_DEGREE + 2];
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < m; ++j) { a[i][j] = t_[i + j]; }
+        a[i][m] = tu_[i];
+    }
+    for (int c = 0; c < m; ++c) {
+        int pivot = c;
+        for (int r = c + 1; r < m; ++r) {
+            if (fabs (a[r][c]) > fabs (a[pivot][c])) { pivot = r; }
+        }
+        /* t is about -1..1, so next to n a vanishing pivot is no spread */
+        if (! (fabs (a[pivot][c]) > 1e-10 * n_)) { return Polynomial (); }
+        for (int j = 0; j <= m; ++j) { std::swap (a[c][j], a[pivot][j]); }
+        for (int r = c + 1; r < m; ++r) {
+            double f = a[r][c] / a[c][c];
+            for (int j = c; j <= m; ++j) { a[r][j] -= f * a[c][j]; }
+        }
+    }
+    std::vector< double > coefs (m);
+    for (int i = m - 1; i >= 0; --i) {
+        double v = a[i][m];
+        for (int j = i + 1; j < m; ++j) { v -= a[i][j] * coefs[j]; }
+        coefs[i] = v / a[i][i];
+    }
+
+    /* residual sum of squares u'u - c'T'u, against the spread of u */
+    double explained = 0.0;
+    for (int i = 0; i < m; ++i) { explained += coefs[i] * tu_[i]; }
+    double total = uu_ - tu_[0] * tu_[0] / n_;
+    double r2 = (total > 0.0) ?
+        std::max (0.0, std::min (1.0, 1.0 - (uu_ - explained) / total)) : 0.0;
+    return Polynomial (xorigin_, xscale_, yorigin_, coefs, r2);
+}
+
+PowerSums powerSums (const Dataset& data) {
+
+    TRACE_SCOPE ("powerSums");
+    const Range& xd = data.XDomain ();
+    const Range& yd = data.YDomain ();
+    FloatType xscale = xd.Distance () / 2.0;
+    PowerSums empty ((xd.Low () + xd.High ()) / 2.0,
+            (xscale > 0.0) ? xscale : 1.0, (yd.Low () + yd.High ()) / 2.0);
+
+    std::size_t n = data.Size ();
+    std::size_t shares = std::max (static_cast< std::size_t >(1),
+            std::min (parallelWorkers (), n / REGRESSION_SHARE));
+    std::vector< PowerSums > parts (shares, empty);
+    parallelFor (shares, [&] (std::size_t s) {
+        Dataset::const_iterator PIT = data.Begin () + (n * s / shares),
+            PEND = data.Begin () + (n * (s + 1) / shares);
+        for (; PIT != PEND; ++PIT) { parts[s].Add (PIT->X (), PIT->Y ()); }
+    });
+    for (std::size_t s = 1; s < shares; ++s) { parts[0].Merge (parts[s]); }
+    return parts[0];
+}
+
+RegressionCache::~RegressionCache () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+const PowerSums& RegressionCache::Update (const Dataset& data) {
+
+    if (&data == data_ && ! stale_) {
+        cacheCounter ("regression").Hit ();
+        return sums_;
+    }
+
+    cacheCounter ("regression").Miss ();
+    if (&data != data_) {
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+    }
+    sums_ = powerSums (data);
+    const Range& xd = data.XDomain ();
+    FloatType half = std::max (xd.Distance () / 2.0, 1.0);
+    FloatType mid = (xd.Low () + xd.High ()) / 2.0;
+    low_ = mid - FIT_REACH * half;
+    high_ = mid + FIT_REACH * half;
+    removed_ = 0;
+    stale_ = false;
+    return sums_;
+}
+
+void RegressionCache::Inserted (const Point& p) {
+    if (stale_) { return; }
+    if (p.X () < low_ || p.X () > high_) {
+        stale_ = true;
+        return;
+    }
+    sums_.Add (p.X (), p.Y ());
+}
+
+void RegressionCache::Evicted (const Point& p) {
+    if (stale_) { return; }
+    sums_.Remove (p.X (), p.Y ());
+    if (++removed_ > sums_.Count ()) { stale_ = true; }
+}
+
+/*
+ * Mean ranks (from 1) of the values of [xs] in the rows where it and
+ * [ys] are both finite, NaN for the rest; with [ys] NULL, of every
+ * finite value
+ */
+static void rankColumn (const std::vector< FloatType >& xs,
+        const std::vector< FloatType > *ys, std::vector< FloatType >& ranks) {
+    std::vector< FloatType > keys (xs);
+    if (NULL != ys) {
+        for (std::size_t i = 0; i < keys.size (); ++i) {
+            if (i >= ys->size () || ! std::isfinite ((*ys)[i])) {
+                keys[i] = NAN;
+            }
+        }
+    }
+    std::vector< std::size_t > rows (xs.size ());
+    for (std::size_t i = 0; i < rows.size (); ++i) { rows[i] = i; }
+    radixSort (keys, rows);
+
+    ranks.assign (xs.size (), NAN);
+    std::size_t i = 0, seen = 0;
+    while (i < keys.size ()) {
+        if (! std::isfinite (keys[i])) {
+            ++i;
+            continue;
+        }
+        std::size_t end = i + 1;
+        while (end < keys.size () && keys[end] == keys[i]) { ++end; }
+        FloatType rank = seen + (end - i + 1) / 2.0;
+        for (std::size_t j = i; j < end; ++j) { ranks[rows[j]] = rank; }
+        seen += end - i;
+        i = end;
+    }
+}
+
+/* Sums of a pair of columns about their shifts, over rows finite in both */
+struct PairSums {
+    double n, x, y, xx, yy, xy;
+};
+
+/*
+ * Add rows [begin, end) of [xs] and [ys], less [xo] and [yo], to [q];
+ * with [complete] columns every row counts, two at a time
+ */
+static void sumPair (const FloatType *xs, const FloatType *ys, FloatType xo,
+        FloatType yo, std::size_t begin, std::size_t end, bool complete,
+        PairSums& q) {
+    if (complete) {
+        double x[2] = { 0.0, 0.0 }, y[2] = { 0.0, 0.0 };
+        double xx[2] = { 0.0, 0.0 }, yy[2] = { 0.0, 0.0 };
+        double xy[2] = { 0.0, 0.0 };
+        std::size_t i = begin;
+        for (; i + 1 < end; i += 2) {
+            for (int u = 0; u < 2; ++u) {
+                double a = xs[i + u] - xo, b = ys[i + u] - yo;
+                x[u] += a;
+                y[u] += b;
+                xx[u] += a * a;
+                yy[u] += b * b;
+                xy[u] += a * b;
+            }
+        }
+        for (; i < end; ++i) {
+            double a = xs[i] - xo, b = ys[i] - yo;
+            x[0] += a;
+            y[0] += b;
+            xx[0] += a * a;
+            yy[0] += b * b;
+            xy[0] += a * b;
+        }
+        q.n += end - begin;
+        q.x += x[0] + x[1];
+        q.y += y[0] + y[1];
+        q.xx += xx[0] + xx[1];
+        q.yy += yy[0] + yy[1];
+        q.xy += xy[0] + xy[1];
+        return;
+    }
+    for (std::size_t i = begin; i < end; ++i) {
+        double a = xs[i] - xo, b = ys[i] - yo;
+        if (! std::isfinite (a) || ! std::isfinite (b)) { continue; }
+        q.n += 1.0;
+        q.x += a;
+        q.y += b;
+        q.xx += a * a;
+        q.yy += b * b;
+        q.xy += a * b;
+    }
+}
+
+static void mergePair (PairSums& q, const PairSums& o) {
+    q.n += o.n;
+    q.x += o.x;
+    q.y += o.y;
+    q.xx += o.xx;
+    q.yy += o.yy;
+    q.xy += o.xy;
+}
+
+/* Pearson's r from the sums, NaN if undefined */
+static FloatType pairCorrelation (const PairSums& q) {
+    if (q.n < 2.0) { return NAN; }
+    double sxx = q.xx - q.x * q.x / q.n, syy = q.yy - q.y * q.y / q.n;
+    double sxy = q.xy - q.x * q.y / q.n;
+    if (! (sxx > 0.0 && syy > 0.0)) { return NAN; }
+    return std::max (-1.0, std::min (1.0, sxy / sqrt (sxx * syy)));
+}
+
+/* The first finite value of [xs], or 0, and whether every one is finite */
+static FloatType firstFinite (const std::vector< FloatType >& xs,
+        std::size_t n, bool& complete) {
+    FloatType first = 0.0;
+    bool found = false;
+    complete = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (std::isfinite (xs[i])) {
+            if (! found) { first = xs[i]; }
+            found = true;
+        } else {
+            complete = false;
+        }
+    }
+    return first;
+}
+
+/* Spearman's rho of the first [n] rows of [xs] and [ys] finite in both */
+static FloatType rankPair (const std::vector< FloatType >& xs,
+        const std::vector< FloatType >& ys, std::size_t n) {
+    std::vector< FloatType > ranks[2];
+    parallelFor (2, [&] (std::size_t c) {
+        rankColumn ((0 == c) ? xs : ys, (0 == c) ? &ys : &xs, ranks[c]);
+    });
+
+    bool xcomplete = true, ycomplete = true;
+    firstFinite (ranks[0], n, xcomplete);
+    firstFinite (ranks[1], n, ycomplete);
+    /* ranks run 1..n, so sums about the middle keep their precision */
+    FloatType mid = (n + 1) / 2.0;
+    std::size_t shares = std::max (static_cast< std::size_t >(1),
+            std::min (parallelWorkers (), n / REGRESSION_SHARE));
+    std::vector< PairSums > parts (shares);
+    parallelFor (shares, [&] (std::size_t s) {
+        memset (&parts[s], 0, sizeof (PairSums));
+        sumPair (ranks[0].data (), ranks[1].data (), mid, mid, n * s / shares,
+                n * (s + 1) / shares, xcomplete && ycomplete, parts[s]);
+    });
+    for (std::size_t s = 1; s < shares; ++s) { mergePair (parts[0], parts[s]); }
+    return pairCorrelation (parts[0]);
+}
+
+FloatType spearman (const Dataset& data) {
+
+    TRACE_SCOPE ("spearman");
+    std::size_t n = data.Size ();
+    std::vector< FloatType > columns[2];
+    columns[0].reserve (n);
+    columns[1].reserve (n);
+    Dataset::const_iterator PIT = data.Begin (), PEND = data.End ();
+    for (; PIT != PEND; ++PIT) {
+        columns[0].push_back (PIT->X ());
+        columns[1].push_back (PIT->Y ());
+    }
+    return rankPair (columns[0], columns[1], n);
+}
+
+/* Seconds on the steady clock */
+static double now () {
+    typedef std::chrono::steady_clock Clock;
+    std::chrono::duration< double > d = Clock::now ().time_since_epoch ();
+    return d.count ();
+}
+
+RankCorrelation::~RankCorrelation () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+FloatType RankCorrelation::Update (const Dataset& data) {
+
+    if (&data == data_ && 0 == changed_) {
+        cacheCounter ("spearman").Hit ();
+        return rho_;
+    }
+    if (&data == data_ && moving_) {
+        /* still streaming: wait for it to settle or the budget to run out */
+        moving_ = false;
+        if (changed_ < RANK_BATCH * data.Size () &&
+                now () - ranked_ < RANK_SECONDS) {
+            return rho_;
+        }
+    }
+
+    cacheCounter ("spearman").Miss ();
+    if (&data != data_) {
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+    }
+    rho_ = spearman (data);
+    ranked_ = now ();
+    changed_ = 0;
+    moving_ = false;
+    return rho_;
+}
+
+void CorrelationMatrix::Update (
+        const std::vector< const std::vector< FloatType > * >& columns,
+        int method) {
+
+    std::vector< std::size_t > sizes (columns.size ());
+    for (std::size_t c = 0; c < columns.size (); ++c) {
+        sizes[c] = columns[c]->size ();
+    }
+    if (method == method_ && columns == columns_ && sizes == sizes_) {
+        cacheCounter ("correlation").Hit ();
+        return;
+    }
+
+    TRACE_SCOPE ("CorrelationMatrix::Update");
+    cacheCounter ("correlation").Miss ();
+    columns_ = columns;
+    sizes_ = sizes;
+    method_ = method;
+
+    int k = Columns ();
+    std::size_t n = sizes.empty () ? 0 :
+        *std::min_element (sizes.begin (), sizes.end ());
+
+    /* the values, or their ranks, each about its first finite one */
+    std::vector< std::vector< FloatType > > ranks (
+            (CORR_SPEARMAN == method) ? k : 0);
+    parallelFor (ranks.size (), [&] (std::size_t c) {
+        rankColumn (*columns[c], NULL, ranks[c]);
+    });
+    std::vector< const FloatType * > data (k);
+    std::vector< FloatType > shift (k, 0.0);
+    std::vector< char > complete (k, 1);
+    parallelFor (k, [&] (std::size_t c) {
+        const std::vector< FloatType >& xs = ranks.empty () ?
+            *columns[c] : ranks[c];
+        bool whole = true;
+        data[c] = xs.data ();
+        shift[c] = firstFinite (xs, n, whole);
+        complete[c] = whole;
+    });
+
+    /* every pair (with itself too) over blocks of each share of the rows */
+    std::size_t pairs = k * (k + 1) / 2;
+
+    /*
+     * ranks over a whole column only serve pairs with nothing missing;
+     * the others are ranked again over the rows finite in both
+     */
+    std::vector< char > ragged (pairs, 0);
+    std::vector< std::pair< int, int > > reranked;
+    if (CORR_SPEARMAN == method) {
+        std::size_t p = 0;
+        for (int a = 0; a < k; ++a) {
+            for (int b = a; b < k; ++b, ++p) {
+                if (a == b || (complete[a] && complete[b])) { continue; }
+                ragged[p] = 1;
+                reranked.push_back (std::make_pair (a, b));
+            }
+        }
+    }
+
+    std::size_t shares = std::max (static_cast< std::size_t >(1),
+            std::min (parallelWorkers (), n / REGRESSION_SHARE));
+    std::vector< std::vector< PairSums > > parts (shares,
+            std::vector< PairSums > (pairs));
+    parallelFor (shares, [&] (std::size_t s) {
+        std::vector< PairSums >& sums = parts[s];
+        memset (sums.data (), 0, sizeof (PairSums) * pairs);
+        std::size_t row = n * s / shares, end = n * (s + 1) / shares;
+        for (; row < end; row += CORR_BLOCK) {
+            std::size_t stop = std::min (end, row + CORR_BLOCK);
+            std::size_t p = 0;
+            for (int a = 0; a < k; ++a) {
+                for (int b = a; b < k; ++b, ++p) {
+                    if (ragged[p]) { continue; }
+                    sumPair (data[a], data[b], shift[a], shift[b], row, stop,
+                            complete[a] && complete[b], sums[p]);
+                }
+            }
+        }
+    });
+
+    r_.assign (k * k, NAN);
+    std::size_t p = 0;
+    for (int a = 0; a < k; ++a) {
+        for (int b = a; b < k; ++b, ++p) {
+            for (std::size_t s = 1; s < shares; ++s) {
+                mergePair (parts[0][p], parts[s][p]);
+            }
+            r_[a * k + b] = r_[b * k + a] = pairCorrelation (parts[0][p]);
+        }
+    }
+
+    parallelFor (reranked.size (), [&] (std::size_t i) {
+        int a = reranked[i].first, b = reranked[i].second;
+        r_[a * k + b] = r_[b * k + a] = rankPair (*columns[a], *columns[b], n);
+    });
+}
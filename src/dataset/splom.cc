@@ -0,0 +1,100 @@
+
+#include <algorithm>
+#include <dataset/splom.h>
+#include <dataset/binning.h>
+#include <dataset/parallel.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+static bool sameRange (const Range& a, const Range& b) {
+    return a.X () == b.X () && a.Y () == b.Y ();
+}
+
+std::size_t SplomCache::Pair (int a, int b) const {
+    std::size_t k = columns_.size ();
+    return a * k - a * (a + 1) / 2 + (b - a - 1);
+}
+
+void SplomCache::Invalidate () {
+    columns_.clear ();
+}
+
+void SplomCache::Update (const std::vector< SplomColumn >& columns,
+        int cells, int nbins) {
+
+    TRACE_SCOPE ("SplomCache::Update");
+
+    std::size_t k = columns.size (), rows = 0;
+    cells = std::max (1, std::min (cells, SPLOM_MAX_CELLS));
+    for (std::size_t c = 0; c < k; ++c) {
+        rows = (0 == c) ? columns[c].size : std::min (rows, columns[c].size);
+    }
+
+    if (cells != cells_ || nbins != nbins_ || rows != rows_ ||
+            k != columns_.size ()) {
+        columns_.assign (k, Coded ());
+        panels_.assign (k * (k - 1) / 2, std::vector< unsigned int >());
+        panel_max_.assign (panels_.size (), 0);
+        cells_ = cells;
+        nbins_ = nbins;
+        rows_ = rows;
+    }
+
+    std::vector< int > stale;
+    std::vector< bool > changed (k, false);
+    for (std::size_t c = 0; c < k; ++c) {
+        Coded& col = columns_[c];
+        if (columns[c].data == col.data && columns[c].size == col.size &&
+                sameRange (columns[c].domain, col.domain)) {
+            cacheCounter ("splom").Hit ();
+            continue;
+        }
+        cacheCounter ("splom").Miss ();
+        col.data = columns[c].data;
+        col.size = columns[c].size;
+        col.domain.Reset (columns[c].domain.X (), columns[c].domain.Y ());
+        stale.push_back (c);
+        changed[c] = true;
+    }
+
+    /* one pass per column: panel cell and histogram bin of each row */
+    parallelFor (stale.size (), [&] (std::size_t s) {
+        Coded& col = columns_[stale[s]];
+        col.codes.resize (rows_);
+        col.hist.assign (std::max (nbins_, 0), 0);
+        for (std::size_t r = 0; r < rows_; ++r) {
+            FloatType v = col.data[r];
+            int cell = binIndex (v, col.domain, cells_);
+            col.codes[r] = (cell < 0) ? SPLOM_MISSING :
+                static_cast< unsigned char >(cell);
+            int bin = binIndex (v, col.domain, nbins_);
+            if (bin >= 0) { col.hist[bin]++; }
+        }
+        col.hist_max = col.hist.empty () ? 0 :
+            *std::max_element (col.hist.begin (), col.hist.end ());
+    });
+
+    std::vector< std::pair< int, int > > pairs;
+    for (std::size_t a = 0; a < k; ++a) {
+        for (std::size_t b = a + 1; b < k; ++b) {
+            if (changed[a] || changed[b]) {
+                pairs.push_back (std::make_pair (a, b));
+            }
+        }
+    }
+
+    /* one pass per panel over two byte arrays */
+    parallelFor (pairs.size (), [&] (std::size_t p) {
+        int a = pairs[p].first, b = pairs[p].second;
+        const unsigned char *xs = columns_[a].codes.data (),
+              *ys = columns_[b].codes.data ();
+        std::vector< unsigned int >& grid = panels_[Pair (a, b)];
+        grid.assign (cells_ * cells_, 0);
+        for (std::size_t r = 0; r < rows_; ++r) {
+            if (SPLOM_MISSING == xs[r] || SPLOM_MISSING == ys[r]) { continue; }
+            grid[xs[r] * cells_ + ys[r]]++;
+        }
+        panel_max_[Pair (a, b)] = grid.empty () ? 0 :
+            *std::max_element (grid.begin (), grid.end ());
+    });
+}
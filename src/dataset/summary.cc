@@ -2,6 +2,7 @@
 #include <vector>
 #include <algorithm>
 #include <dataset/summary.h>
+#include <dataset/radix.h>
 #include <graph/exceptions.h> /* TODO: move to general include level */
 
 /*
@@ -19,6 +20,17 @@ static FloatType median (const std::vector< FloatType >& xs,
 }
 
 BoxPlotSummary::BoxPlotSummary (std::vector< FloatType >& xs) {
+    if (! std::is_sorted (xs.begin (), xs.end ())) {
+        radixSort (xs);
+    }
+    Summarize (xs);
+}
+
+BoxPlotSummary::BoxPlotSummary (const std::vector< FloatType >& xs, bool) {
+    Summarize (xs);
+}
+
+void BoxPlotSummary::Summarize (const std::vector< FloatType >& xs) {
 
     if (xs.empty ()) {
         throw GeneralException ("Empty dataset", __FILE__, __LINE__);
@@ -32,13 +44,12 @@ BoxPlotSummary::BoxPlotSummary (std::vector< FloatType >& xs) {
 
     std::size_t mid = xs.size () / 2;
 
-    std::sort (xs.begin (), xs.end ());
-
     min_ = xs[0];
     max_ = xs[xs.size () - 1];
     median_ = median (xs, 0, xs.size ());
     lq_ = median (xs, 0, mid);
-    if (0 == mid % 2) {
+    /* odd sized data leaves the median out of both halves */
+    if (0 == xs.size () % 2) {
         uq_ = median (xs, mid, xs.size ());
     } else {
         uq_ = median (xs, mid + 1, xs.size ());
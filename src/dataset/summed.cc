@@ -0,0 +1,256 @@
+
+#include <cmath>
+#include <algorithm>
+#include <dataset/summed.h>
+#include <dataset/parallel.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+/* Fewest points each worker counts before the pass is split */
+#define SAT_SHARE 65536
+
+static const std::size_t SIDE = SAT_SIDE;
+
+SummedAreaTable::~SummedAreaTable () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+long SummedAreaTable::Cell (const Point& p) const {
+    FloatType x = p.X (), y = p.Y ();
+    if (! (x >= xdomain_.Low () && x <= xdomain_.High () &&
+                y >= ydomain_.Low () && y <= ydomain_.High ())) {
+        return -1;
+    }
+    long last = static_cast< long >(SIDE) - 1;
+    long col = (xdomain_.Distance () > 0.0) ?
+        std::min (static_cast< long >(Offset (x, xdomain_)), last) : 0;
+    long row = (ydomain_.Distance () > 0.0) ?
+        std::min (static_cast< long >(Offset (y, ydomain_)), last) : 0;
+    return row * SIDE + col;
+}
+
+FloatType SummedAreaTable::Offset (FloatType v, const Range& domain) const {
+    FloatType width = domain.Distance ();
+    /* single valued: everything sits in the first cell */
+    if (! (width > 0.0)) { return (v < domain.Low ()) ? 0.0 : 1.0; }
+    FloatType u = (v - domain.Low ()) / width * SIDE;
+    return std::max (static_cast< FloatType >(0.0),
+            std::min (u, static_cast< FloatType >(SIDE)));
+}
+
+FloatType SummedAreaTable::Sum (FloatType u, FloatType v) const {
+    std::size_t i = std::min (static_cast< std::size_t >(u), SIDE - 1);
+    std::size_t j = std::min (static_cast< std::size_t >(v), SIDE - 1);
+    FloatType fu = u - i, fv = v - j;
+    const long *lo = &sums_[j * (SIDE + 1) + i], *hi = lo + SIDE + 1;
+    return (lo[0] * (1.0 - fu) + lo[1] * fu) * (1.0 - fv) +
+        (hi[0] * (1.0 - fu) + hi[1] * fu) * fv;
+}
+
+bool SummedAreaTable::Grow (const Point& p) {
+    for (int axis = 0; axis < 2; ++axis) {
+        Range& domain = (0 == axis) ? xdomain_ : ydomain_;
+        FloatType v = (0 == axis) ? p.X () : p.Y ();
+        for (int g = 0; ! (v >= domain.Low () && v <= domain.High ()); ++g) {
+            if (g == SAT_GROWTH || v != v || ! (domain.Distance () > 0.0)) {
+                return false;
+            }
+
+            /*
+             * cells 2 i and 2 i + 1 along [axis] make cell i, with the
+             * grid shifted a whole grid up first if [v] is below it
+             */
+            std::size_t shift = (v < domain.Low ()) ? SIDE : 0;
+            std::vector< long > merged (SIDE * SIDE, 0);
+            parallelFor (SIDE, [&] (std::size_t r) {
+                long *into = &merged[r * SIDE];
+                if (0 == axis) {
+                    const long *row = &counts_[r * SIDE];
+                    for (std::size_t c = 0; c < SIDE; ++c) {
+                        into[(c + shift) / 2] += row[c];
+                    }
+                    return;
+                }
+                for (std::size_t k = 2 * r; k < 2 * r + 2; ++k) {
+                    if (k < shift || k >= shift + SIDE) { continue; }
+                    const long *row = &counts_[(k - shift) * SIDE];
+                    for (std::size_t c = 0; c < SIDE; ++c) { into[c] += row[c]; }
+                }
+            });
+            counts_.swap (merged);
+
+            FloatType width = domain.Distance ();
+            if (shift > 0) {
+                domain.Reset (domain.Low () - width, domain.High ());
+            } else {
+                domain.Reset (domain.Low (), domain.High () + width);
+            }
+        }
+    }
+    return true;
+}
+
+const SummedAreaTable& SummedAreaTable::Update (const Dataset& data) {
+
+    /* a grid grown far past a window's data resolves it too coarsely */
+    if (SAT_LOOSE * data.XDomain ().Distance () < xdomain_.Distance () ||
+            SAT_LOOSE * data.YDomain ().Distance () < ydomain_.Distance ()) {
+        stale_ = true;
+    }
+
+    if (&data == data_ && ! stale_) {
+        cacheCounter ("summed").Hit ();
+        if (dirty_) { Accumulate (); }
+        return *this;
+    }
+
+    TRACE_SCOPE ("SummedAreaTable::Update");
+    cacheCounter ("summed").Miss ();
+    if (&data != data_) {
+        if (NULL != data_) { data_->Detach (this); }
+        data_ = &data;
+        data_->Attach (this);
+    }
+    stale_ = false;
+
+    xdomain_.Reset (data.XDomain ().X (), data.XDomain ().Y ());
+    ydomain_.Reset (data.YDomain ().X (), data.YDomain ().Y ());
+    Count (data);
+    Accumulate ();
+    return *this;
+}
+
+void SummedAreaTable::Count (const Dataset& data) {
+
+    std::size_t n = data.Size ();
+    std::size_t shares = std::max (static_cast< std::size_t >(1),
+            std::min (parallelWorkers (), n / SAT_SHARE));
+
+    /* each share counts into its own grid, summed row by row after */
+    std::vector< std::vector< long > > grids (shares - 1);
+    counts_.assign (SIDE * SIDE, 0);
+    parallelFor (shares, [&] (std::size_t s) {
+        std::vector< long >& grid = (0 == s) ? counts_ : grids[s - 1];
+        grid.resize (SIDE * SIDE, 0);
+        Dataset::const_iterator PIT = data.Begin () + (n * s / shares),
+            PEND = data.Begin () + (n * (s + 1) / shares);
+        for (; PIT != PEND; ++PIT) {
+            long cell = Cell (*PIT);
+            if (cell >= 0) { ++grid[cell]; }
+        }
+    });
+
+    if (grids.empty ()) { return; }
+    parallelFor (SIDE, [&] (std::size_t r) {
+        long *row = &counts_[r * SIDE];
+        for (std::size_t g = 0; g < grids.size (); ++g) {
+            const long *add = &grids[g][r * SIDE];
+            for (std::size_t c = 0; c < SIDE; ++c) { row[c] += add[c]; }
+        }
+    });
+}
+
+void SummedAreaTable::Accumulate () {
+
+    TRACE_SCOPE ("SummedAreaTable::Accumulate");
+    sums_.assign ((SIDE + 1) * (SIDE + 1), 0);
+
+    /* prefix sums along each row, then down each column */
+    parallelFor (SIDE, [&] (std::size_t r) {
+        const long *count = &counts_[r * SIDE];
+        long *sum = &sums_[(r + 1) * (SIDE + 1) + 1];
+        long running = 0;
+        for (std::size_t c = 0; c < SIDE; ++c) {
+            running += count[c];
+            sum[c] = running;
+        }
+    });
+    std::size_t block = 64;
+    parallelFor ((SIDE + block) / block, [&] (std::size_t b) {
+        std::size_t c0 = b * block, c1 = std::min (SIDE + 1, c0 + block);
+        for (std::size_t r = 2; r <= SIDE; ++r) {
+            long *sum = &sums_[r * (SIDE + 1)];
+            const long *above = sum - (SIDE + 1);
+            for (std::size_t c = c0; c < c1; ++c) { sum[c] += above[c]; }
+        }
+    });
+    dirty_ = false;
+}
+
+long SummedAreaTable::Count (int col0, int row0, int col1, int row1) const {
+    if (sums_.empty ()) { return 0; }
+    int side = static_cast< int >(SIDE);
+    col0 = std::max (0, std::min (col0, side));
+    col1 = std::max (col0, std::min (col1, side));
+    row0 = std::max (0, std::min (row0, side));
+    row1 = std::max (row0, std::min (row1, side));
+    const long *lo = &sums_[row0 * (SIDE + 1)], *hi = &sums_[row1 * (SIDE + 1)];
+    return hi[col1] - hi[col0] - lo[col1] + lo[col0];
+}
+
+FloatType SummedAreaTable::Count (const Range& xlim, const Range& ylim) const {
+    if (sums_.empty ()) { return 0.0; }
+    FloatType u0 = Offset (xlim.Low (), xdomain_), u1 = Offset (xlim.High (), xdomain_);
+    FloatType v0 = Offset (ylim.Low (), ydomain_), v1 = Offset (ylim.High (), ydomain_);
+    return Sum (u1, v1) - Sum (u0, v1) - Sum (u1, v0) + Sum (u0, v0);
+}
+
+FloatType SummedAreaTable::Bins (const Range& xlim, const Range& ylim,
+        int ncols, int nrows, std::vector< FloatType >& bins) const {
+
+    bins.assign (std::max (0, ncols) * std::max (0, nrows), 0.0);
+    if (sums_.empty () || ncols <= 0 || nrows <= 0) { return 0.0; }
+
+    /* the table at every bin corner, then each bin from its four */
+    std::vector< FloatType > us (ncols + 1), vs (nrows + 1);
+    for (int c = 0; c <= ncols; ++c) {
+        us[c] = Offset (xlim.Low () + xlim.Distance () * c / ncols, xdomain_);
+    }
+    for (int r = 0; r <= nrows; ++r) {
+        vs[r] = Offset (ylim.Low () + ylim.Distance () * r / nrows, ydomain_);
+    }
+    std::vector< FloatType > corners ((ncols + 1) * (nrows + 1));
+    for (int r = 0; r <= nrows; ++r) {
+        for (int c = 0; c <= ncols; ++c) {
+            corners[r * (ncols + 1) + c] = Sum (us[c], vs[r]);
+        }
+    }
+
+    FloatType most = 0.0;
+    for (int r = 0; r < nrows; ++r) {
+        const FloatType *lo = &corners[r * (ncols + 1)], *hi = lo + ncols + 1;
+        for (int c = 0; c < ncols; ++c) {
+            /* rounding can leave an empty bin a hair below zero */
+            FloatType count = std::max (static_cast< FloatType >(0.0),
+                    hi[c + 1] - hi[c] - lo[c + 1] + lo[c]);
+            bins[r * ncols + c] = count;
+            most = std::max (most, count);
+        }
+    }
+    return most;
+}
+
+void SummedAreaTable::Inserted (const Point& p) {
+    if (stale_ || counts_.empty ()) { return; }
+    if (p.X () != p.X () || p.Y () != p.Y ()) { return; }
+    long cell = Grow (p) ? Cell (p) : -1;
+    if (cell < 0) {
+        stale_ = true;
+        return;
+    }
+    ++counts_[cell];
+    dirty_ = true;
+}
+
+void SummedAreaTable::Evicted (const Point& p) {
+    if (stale_ || counts_.empty ()) { return; }
+    long cell = Cell (p);
+    if (cell < 0) { return; }
+    if (0 == counts_[cell]) {
+        /* not counted where it should be */
+        stale_ = true;
+        return;
+    }
+    --counts_[cell];
+    dirty_ = true;
+}
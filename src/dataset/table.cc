@@ -0,0 +1,319 @@
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <dataset/table.h>
+#include <perf/trace.h>
+
+#define TABLE_CHUNK (1 << 20)
+
+static const FloatType MISSING = std::numeric_limits< FloatType >::quiet_NaN ();
+
+static bool blank (const char *p, const char *end) {
+    for (; p < end; ++p) {
+        if (! isspace (static_cast< unsigned char >(*p))) { return false; }
+    }
+    return true;
+}
+
+/*
+ * The number in the field [p, end), NaN if it is not one. strtod may
+ * skip whitespace past [end] so anything it consumes there is refused.
+ */
+static FloatType field (const char *p, const char *end, bool& ok) {
+    char *next = NULL;
+    FloatType v = strtod (p, &next);
+    ok = next != p && next <= end && blank (next, end);
+    return ok ? v : MISSING;
+}
+
+static std::string trim (const char *p, const char *end) {
+    while (p < end && isspace (static_cast< unsigned char >(*p))) { ++p; }
+    while (end > p && isspace (static_cast< unsigned char >(end[-1]))) { --end; }
+    if (end - p >= 2 && '"' == *p && '"' == end[-1]) { ++p; --end; }
+    return std::string (p, end);
+}
+
+/* The next line of [fin] that is not blank into [line]; false if none */
+static bool nextLine (FILE *fin, std::string& line) {
+    char buff[4096];
+    line.clear ();
+    while (NULL != fgets (buff, sizeof (buff), fin)) {
+        line += buff;
+        if ('\n' == line[line.size () - 1]) {
+            if (! blank (line.c_str (), line.c_str () + line.size ())) {
+                return true;
+            }
+            line.clear ();
+        }
+    }
+    return ! blank (line.c_str (), line.c_str () + line.size ());
+}
+
+/* The fields of [line], trimmed, and which of them are numbers */
+static void split (const std::string& line, std::vector< std::string >& fields,
+        std::vector< bool >& numbers) {
+    const char *p = line.c_str (), *eol = p + line.size ();
+    fields.clear ();
+    numbers.clear ();
+    while (p <= eol) {
+        const char *comma = static_cast< const char * >(
+                memchr (p, ',', eol - p));
+        const char *end = (NULL == comma) ? eol : comma;
+        bool ok = false;
+        field (p, end, ok);
+        numbers.push_back (ok);
+        fields.push_back (trim (p, end));
+        if (NULL == comma) { break; }
+        p = comma + 1;
+    }
+}
+
+Table::Table (const char *path) : path_(path), header_(false), rows_(0) {}
+
+bool Table::Open () {
+
+    FILE *fin = fopen (path_.c_str (), "rb");
+    if (NULL == fin) { return false; }
+
+    std::string line;
+    std::vector< std::string > names;
+    std::vector< bool > numbers;
+    if (nextLine (fin, line)) { split (line, names, numbers); }
+    bool numeric = numbers.end () ==
+        std::find (numbers.begin (), numbers.end (), false);
+    header_ = ! names.empty () && ! numeric;
+
+    /* a column whose first value is text holds categories */
+    std::vector< std::string > values (names);
+    if (header_) {
+        values.clear ();
+        if (nextLine (fin, line)) { split (line, values, numbers); }
+    }
+    fclose (fin);
+
+    names_.clear ();
+    kinds_.clear ();
+    for (std::size_t i = 0; i < names.size (); ++i) {
+        char name[32];
+        snprintf (name, sizeof (name), "V%zu", i + 1);
+        names_.push_back (header_ ? names[i] : std::string (name));
+        bool text = i < values.size () && ! numbers[i] && ! values[i].empty ();
+        kinds_.push_back (text ? COLUMN_CATEGORY : COLUMN_NUMBER);
+    }
+
+    columns_.assign (names_.size (), std::vector< FloatType >());
+    codes_.assign (names_.size (), std::vector< std::uint32_t >());
+    categories_.assign (names_.size (), std::vector< std::string >());
+    loaded_.assign (names_.size (), false);
+    domains_.assign (names_.size (), Range ());
+    have_domain_.assign (names_.size (), false);
+    rows_ = 0;
+    return true;
+}
+
+int Table::Find (const std::string& name) const {
+    for (std::size_t i = 0; i < names_.size (); ++i) {
+        if (name == names_[i]) { return i; }
+    }
+    char *end = NULL;
+    long n = strtol (name.c_str (), &end, 10);
+    if (! name.empty () && '\0' == *end && n >= 1 &&
+            n <= static_cast< long >(names_.size ())) {
+        return n - 1;
+    }
+    return -1;
+}
+
+void Table::Append (int c, const char *p, const char *end, Dictionary& dict) {
+    if (COLUMN_NUMBER == kinds_[c]) {
+        bool ok = false;
+        columns_[c].push_back (field (p, end, ok));
+        return;
+    }
+    std::string name = trim (p, end);
+    if (name.empty ()) {
+        codes_[c].push_back (TABLE_NO_CODE);
+        return;
+    }
+    std::uint32_t code = static_cast< std::uint32_t >(dict.size ());
+    codes_[c].push_back (dict.insert (std::make_pair (name, code)).first->second);
+}
+
+Table::size_type Table::Filled (int c) const {
+    return (COLUMN_NUMBER == kinds_[c]) ? columns_[c].size () : codes_[c].size ();
+}
+
+void Table::ParseLine (const char *line, const char *eol,
+        const std::vector< int >& slots, int last,
+        const std::vector< int >& dest, std::vector< Dictionary >& dicts) {
+
+    std::size_t filled = 0;
+    const char *p = line;
+    for (int f = 0; f <= last; ++f) {
+        const char *comma = static_cast< const char * >(
+                memchr (p, ',', eol - p));
+        const char *end = (NULL == comma) ? eol : comma;
+        if (slots[f] >= 0) {
+            Append (f, p, end, dicts[slots[f]]);
+            ++filled;
+        }
+        if (NULL == comma) { break; }
+        p = comma + 1;
+    }
+
+    /* short line; the missing fields are empty */
+    for (std::size_t i = 0; filled < dest.size () && i < dest.size (); ++i) {
+        if (Filled (dest[i]) == rows_) {
+            Append (dest[i], eol, eol, dicts[i]);
+            ++filled;
+        }
+    }
+}
+
+bool Table::Load (const std::vector< int >& columns) {
+
+    TRACE_SCOPE ("Table::Load");
+
+    /* field index -> position in [dest], -1 for fields to skip */
+    std::vector< int > slots (names_.size (), -1);
+    std::vector< int > dest;
+    int last = -1;
+    for (std::size_t i = 0; i < columns.size (); ++i) {
+        int c = columns[i];
+        if (c < 0 || c >= static_cast< int >(names_.size ())) { return false; }
+        if (loaded_[c] || slots[c] >= 0) { continue; }
+        slots[c] = dest.size ();
+        dest.push_back (c);
+        last = std::max (last, c);
+    }
+    if (dest.empty ()) { return true; }
+    std::vector< Dictionary > dicts (dest.size ());
+
+    FILE *fin = fopen (path_.c_str (), "rb");
+    if (NULL == fin) { return false; }
+
+    std::size_t before = rows_, rows = 0;
+    bool first = true;
+    rows_ = 0;
+    std::string buff;
+    std::vector< char > chunk (TABLE_CHUNK);
+    std::size_t n = 0;
+    bool done = false;
+    while (! done) {
+        n = fread (chunk.data (), 1, chunk.size (), fin);
+        buff.append (chunk.data (), n);
+        if (n < chunk.size ()) {
+            /* finish a last line without a newline */
+            done = true;
+            if (! buff.empty () && '\n' != buff[buff.size () - 1]) {
+                buff += '\n';
+            }
+        }
+
+        const char *line = buff.c_str (), *end = line + buff.size ();
+        const char *nl = NULL;
+        while (NULL != (nl = static_cast< const char * >(
+                        memchr (line, '\n', end - line)))) {
+            if (! blank (line, nl)) {
+                if (! (first && header_)) {
+                    ParseLine (line, nl, slots, last, dest, dicts);
+                    rows_ = ++rows;
+                }
+                first = false;
+            }
+            line = nl + 1;
+        }
+        buff.erase (0, line - buff.c_str ());
+    }
+    fclose (fin);
+
+    /* the file changed since the other columns were read; keep them in step */
+    if (before > 0 && before != rows) {
+        for (std::size_t i = 0; i < dest.size (); ++i) {
+            columns_[dest[i]].resize (before, MISSING);
+            codes_[dest[i]].resize (before, TABLE_NO_CODE);
+        }
+        rows = before;
+    }
+    rows_ = rows;
+
+    for (std::size_t i = 0; i < dest.size (); ++i) {
+        int c = dest[i];
+        if (COLUMN_CATEGORY == kinds_[c]) {
+            columns_[c].clear ();
+            Sort (c, dicts[i]);
+        } else {
+            codes_[c].clear ();
+        }
+        loaded_[c] = true;
+        have_domain_[c] = false;
+    }
+    return true;
+}
+
+void Table::Sort (int c, const Dictionary& dict) {
+
+    /* names by code as met, then the codes they get in name order */
+    std::vector< std::string >& names = categories_[c];
+    names.assign (dict.size (), std::string ());
+    Dictionary::const_iterator DIT = dict.begin (), DEND = dict.end ();
+    for (; DIT != DEND; ++DIT) { names[DIT->second] = DIT->first; }
+    std::vector< std::uint32_t > order (names.size ());
+    for (std::size_t i = 0; i < order.size (); ++i) {
+        order[i] = static_cast< std::uint32_t >(i);
+    }
+    std::sort (order.begin (), order.end (),
+            [&] (std::uint32_t a, std::uint32_t b) {
+                return names[a] < names[b];
+            });
+    std::vector< std::uint32_t > recode (order.size ());
+    std::vector< std::string > sorted (order.size ());
+    for (std::size_t i = 0; i < order.size (); ++i) {
+        recode[order[i]] = static_cast< std::uint32_t >(i);
+        sorted[i].swap (names[order[i]]);
+    }
+    names.swap (sorted);
+
+    std::vector< std::uint32_t >& codes = codes_[c];
+    for (std::size_t r = 0; r < codes.size (); ++r) {
+        if (TABLE_NO_CODE != codes[r]) { codes[r] = recode[codes[r]]; }
+    }
+}
+
+const std::vector< FloatType >& Table::Column (int c) const {
+    std::vector< FloatType >& xs = columns_[c];
+    if (COLUMN_CATEGORY == kinds_[c] && xs.size () != codes_[c].size ()) {
+        const std::vector< std::uint32_t >& codes = codes_[c];
+        xs.resize (codes.size ());
+        for (std::size_t r = 0; r < codes.size (); ++r) {
+            xs[r] = (TABLE_NO_CODE == codes[r]) ? MISSING : codes[r];
+        }
+    }
+    return xs;
+}
+
+const Range& Table::Domain (int c) const {
+
+    if (! have_domain_[c]) {
+        const std::vector< FloatType >& xs = Column (c);
+        FloatType low = 0.0, high = 0.0;
+        bool any = false;
+        for (std::size_t i = 0; i < xs.size (); ++i) {
+            if (! std::isfinite (xs[i])) { continue; }
+            if (! any) {
+                low = high = xs[i];
+                any = true;
+            }
+            low = std::min (low, xs[i]);
+            high = std::max (high, xs[i]);
+        }
+        domains_[c].Reset (low, high);
+        have_domain_[c] = true;
+    }
+    return domains_[c];
+}
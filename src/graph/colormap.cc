@@ -0,0 +1,195 @@
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <graph/colormap.h>
+#include <graph/util.h>
+#include <dataset/radix.h>
+#include <perf/trace.h>
+
+/* Evenly spaced stops of each map, as 0xRRGGBB */
+static const unsigned int VIRIDIS[] = {
+    0x440154, 0x482878, 0x3e4989, 0x31688e, 0x26828e,
+    0x1f9e89, 0x35b779, 0x6ece58, 0xfde725
+};
+static const unsigned int MAGMA[] = {
+    0x000004, 0x1c1044, 0x4f127b, 0x812581, 0xb5367a,
+    0xe55064, 0xfb8861, 0xfec287, 0xfcfdbf
+};
+static const unsigned int GRAY[] = { 0x000000, 0xffffff };
+static const unsigned int DIVERGING[] = {
+    0x2166ac, 0x67a9cf, 0xd1e5f0, 0xf7f7f7, 0xfddbc7, 0xef8a62, 0xb2182b
+};
+
+#define NSTOPS(stops) (sizeof (stops) / sizeof (stops[0]))
+
+const char * colormap2str (int name) {
+    switch (name) {
+        case CMAP_WHITE: return "white";
+        case CMAP_VIRIDIS: return "viridis";
+        case CMAP_MAGMA: return "magma";
+        case CMAP_GRAY: return "gray";
+        case CMAP_DIVERGING: return "diverging";
+        default: return "MISSING COLORMAP CASE";
+    }
+}
+
+const char * colorscale2str (int scale) {
+    switch (scale) {
+        case SCALE_LINEAR: return "linear";
+        case SCALE_LOG: return "log";
+        case SCALE_EQUALIZED: return "equalized";
+        default: return "MISSING SCALE CASE";
+    }
+}
+
+int str2colormap (const char *name) {
+    for (int c = 0; c < MAX_CMAP; ++c) {
+        if (0 == strcmp (name, colormap2str (c))) { return c; }
+    }
+    return -1;
+}
+
+int str2colorscale (const char *name) {
+    for (int s = 0; s < MAX_SCALE; ++s) {
+        if (0 == strcmp (name, colorscale2str (s))) { return s; }
+    }
+    return -1;
+}
+
+/* Fill [lut] by interpolating linearly between [n] evenly spaced [stops] */
+static void ramp (const unsigned int *stops, std::size_t n, ColorType *lut) {
+    for (int i = 0; i < CMAP_SIZE; ++i) {
+        FloatType at = static_cast< FloatType >(i) * (n - 1) / (CMAP_SIZE - 1);
+        std::size_t k = std::min (static_cast< std::size_t >(at), n - 2);
+        FloatType f = at - k;
+        int rgb[3];
+        for (int c = 0; c < 3; ++c) {
+            int lo = (stops[k] >> (16 - 8 * c)) & 0xff;
+            int hi = (stops[k + 1] >> (16 - 8 * c)) & 0xff;
+            rgb[c] = static_cast< int >(lo + (hi - lo) * f + 0.5);
+        }
+        lut[i] = mkcol (rgb[0], rgb[1], rgb[2], 255);
+    }
+}
+
+Colormap::Colormap (int name) {
+    switch (name) {
+        case CMAP_VIRIDIS: ramp (VIRIDIS, NSTOPS (VIRIDIS), lut_); break;
+        case CMAP_MAGMA: ramp (MAGMA, NSTOPS (MAGMA), lut_); break;
+        case CMAP_GRAY: ramp (GRAY, NSTOPS (GRAY), lut_); break;
+        case CMAP_DIVERGING: ramp (DIVERGING, NSTOPS (DIVERGING), lut_); break;
+        default: {
+            /* the ramp the density plots always drew */
+            ColorType cool = mkcol (255, 255, 255, 8);
+            ColorType hot = mkcol (255, 255, 255, 255);
+            for (int i = 0; i < CMAP_SIZE; ++i) {
+                lut_[i] = gradient (cool, hot,
+                        static_cast< FloatType >(i) / (CMAP_SIZE - 1));
+            }
+        }
+    }
+}
+
+const Colormap& Colormap::Get (int name) {
+    static const Colormap white (CMAP_WHITE), viridis (CMAP_VIRIDIS),
+        magma (CMAP_MAGMA), gray (CMAP_GRAY), diverging (CMAP_DIVERGING);
+    switch (name) {
+        case CMAP_VIRIDIS: return viridis;
+        case CMAP_MAGMA: return magma;
+        case CMAP_GRAY: return gray;
+        case CMAP_DIVERGING: return diverging;
+        default: return white;
+    }
+}
+
+/* Table entry of the fraction [t] of the way along */
+static inline int level (FloatType t) {
+    return std::max (0, std::min (CMAP_SIZE - 1,
+                static_cast< int >(t * (CMAP_SIZE - 1) + 0.5)));
+}
+
+void Colormap::Map (const std::vector< FloatType >& counts, FloatType most,
+        int scale, std::vector< ColorType >& colors) const {
+
+    TRACE_SCOPE ("Colormap::Map");
+    std::size_t n = counts.size ();
+    colors.assign (n, lut_[0]);
+    if (! (most > 0.0)) { return; }
+
+    if (SCALE_EQUALIZED == scale) {
+        /* nonzero counts sorted with their cells; ties share the top rank */
+        std::vector< FloatType > sorted;
+        std::vector< std::size_t > cells;
+        sorted.reserve (n);
+        cells.reserve (n);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (counts[i] > 0.0) {
+                sorted.push_back (counts[i]);
+                cells.push_back (i);
+            }
+        }
+        radixSort (sorted, cells);
+        std::size_t m = sorted.size ();
+        for (std::size_t lo = 0, hi = 0; lo < m; lo = hi) {
+            while (hi < m && sorted[hi] == sorted[lo]) { ++hi; }
+            ColorType col = lut_[level (static_cast< FloatType >(hi) / m)];
+            for (std::size_t r = lo; r < hi; ++r) { colors[cells[r]] = col; }
+        }
+    } else if (SCALE_LOG == scale) {
+        FloatType k = 1.0 / log1p (most);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (counts[i] > 0.0) {
+                colors[i] = lut_[level (log1p (counts[i]) * k)];
+            }
+        }
+    } else {
+        FloatType k = 1.0 / most;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (counts[i] > 0.0) { colors[i] = lut_[level (counts[i] * k)]; }
+        }
+    }
+}
+
+void Colormap::Map (const std::vector< unsigned int >& counts,
+        unsigned int most, int scale, std::vector< ColorType >& colors) const {
+
+    if (most >= CMAP_DIRECT) {
+        std::vector< FloatType > fs (counts.begin (), counts.end ());
+        Map (fs, static_cast< FloatType >(most), scale, colors);
+        return;
+    }
+
+    TRACE_SCOPE ("Colormap::Map");
+    std::size_t n = counts.size ();
+    colors.assign (n, lut_[0]);
+    if (0 == most) { return; }
+
+    /* normalize each count that can occur once, then look cells up */
+    std::vector< unsigned char > levels (most + 1, 0);
+    if (SCALE_EQUALIZED == scale) {
+        std::vector< std::size_t > below (most + 1, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            ++below[std::min (counts[i], most)];
+        }
+        below[0] = 0;
+        for (unsigned int c = 1; c <= most; ++c) { below[c] += below[c - 1]; }
+        FloatType m = static_cast< FloatType >(below[most]);
+        for (unsigned int c = 1; m > 0.0 && c <= most; ++c) {
+            levels[c] = level (below[c] / m);
+        }
+    } else if (SCALE_LOG == scale) {
+        FloatType k = 1.0 / log1p (static_cast< FloatType >(most));
+        for (unsigned int c = 1; c <= most; ++c) {
+            levels[c] = level (log1p (c) * k);
+        }
+    } else {
+        for (unsigned int c = 1; c <= most; ++c) {
+            levels[c] = level (static_cast< FloatType >(c) / most);
+        }
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        colors[i] = lut_[levels[std::min (counts[i], most)]];
+    }
+}
@@ -1,13 +1,266 @@
 
-
+#include <chrono>
 #include <graph/dataset.h> /* TODO: move to new location */
+#include <graph/exceptions.h>
+
+/* the ring is walked as x and y arrays interleaved in its Points */
+static_assert (sizeof (Point) == 2 * sizeof (FloatType), 
+        "Point must be a packed x/y pair");
+
+/* Arrival times for time windows */
+static double now () {
+    typedef std::chrono::steady_clock Clock;
+    std::chrono::duration< double > d = Clock::now ().time_since_epoch ();
+    return d.count ();
+}
+
+Dataset::Dataset (const std::vector< Point >& pts) : points_(pts), 
+    xview_(NULL), yview_(NULL), head_(0),
+    size_(pts.size ()), capacity_(0), seconds_(0.0), seq_(pts.size ()) {
+    std::vector< Point >::const_iterator PIT = pts.begin (),
+        PEND = pts.end ();
+    if (pts.empty ()) { return; }
+    FloatType xmin, xmax, ymin, ymax;
+    xmin = xmax = PIT->X ();
+    ymin = ymax = PIT->Y ();
+    for (; PIT != PEND; ++PIT) {
+        xmin = std::min (xmin, PIT->X ());
+        xmax = std::max (xmax, PIT->X ());
+        ymin = std::min (ymin, PIT->Y ());
+        ymax = std::max (ymax, PIT->Y ());
+    }
+    xdomain_.Reset (xmin, xmax);
+    ydomain_.Reset (ymin, ymax);
+}
+
+Dataset::Dataset (const std::vector< FloatType >& xs, 
+        const std::vector< FloatType >& ys,
+        const Range& xdomain, const Range& ydomain) : 
+    xview_(xs.data ()), yview_(ys.data ()), head_(0), 
+    size_(std::min (xs.size (), ys.size ())), capacity_(0), seconds_(0.0),
+    seq_(size_), xdomain_(xdomain), ydomain_(ydomain) {}
+
+Dataset::~Dataset () {
+    Reset ();
+}
+
+void Dataset::Reset () {
+    std::vector< DatasetObserver * > observers;
+    observers.swap (observers_);
+    std::vector< DatasetObserver * >::iterator OIT = observers.begin (),
+        OEND = observers.end ();
+    for (; OIT != OEND; ++OIT) {
+        (*OIT)->Detached ();
+    }
+
+    points_.clear ();
+    times_.clear ();
+    head_ = size_ = 0;
+    xmin_.clear ();
+    xmax_.clear ();
+    ymin_.clear ();
+    ymax_.clear ();
+}
+
+Dataset::const_iterator Dataset::Iterator (std::ptrdiff_t pos) const {
+    if (View ()) {
+        return const_iterator (xview_, yview_, 1, size_, 0, pos);
+    }
+    const FloatType *xs = reinterpret_cast< const FloatType * >(points_.data ());
+    return const_iterator (xs, xs + 1, 2, points_.size (), head_, pos);
+}
+
+/* Grow [domain] to hold [v]; a NaN domain (from a NaN first point) restarts */
+static void extend (Range& domain, FloatType v) {
+    if (v != v) { return; }
+    if (domain.Low () != domain.Low ()) {
+        domain.Reset (v, v);
+    } else {
+        domain.Reset (std::min (domain.Low (), v), std::max (domain.High (), v));
+    }
+}
+
+void Dataset::Window (size_type capacity, double seconds) {
+
+    if (View ()) {
+        throw GeneralException ("Cannot window a column view", 
+                __FILE__, __LINE__);
+    }
+
+    std::vector< Point > pts (Begin (), End ());
+    std::vector< double > times;
+    for (size_type i = 0; i < size_ && ! times_.empty (); ++i) {
+        times.push_back (times_[(head_ + i) % times_.size ()]);
+    }
+
+    Reset ();
+    capacity_ = capacity;
+    seconds_ = seconds;
+    if (capacity_ > 0) {
+        points_.reserve (capacity_);
+    }
+
+    double t = now ();
+    for (size_type i = 0; i < pts.size (); ++i) {
+        Insert (pts[i], i < times.size () ? times[i] : t);
+    }
+}
+
+void Dataset::Add (const Point& p) {
+    if (View ()) {
+        throw GeneralException ("Cannot add to a column view", 
+                __FILE__, __LINE__);
+    }
+    Insert (p, seconds_ > 0.0 ? now () : 0.0);
+}
+
+void Dataset::Insert (const Point& p, double t) {
+
+    if (seconds_ > 0.0) {
+        ExpireBefore (t - seconds_);
+    }
+    if (capacity_ > 0 && size_ == capacity_) {
+        EvictOldest ();
+    }
+
+    size_type n = points_.size ();
+    if (size_ < n) {
+        size_type i = (head_ + size_) % n;
+        points_[i] = p;
+        if (seconds_ > 0.0) { times_[i] = t; }
+    } else if (0 != head_) {
+        /* 
+         * storage is full and wrapped; unwrap it into twice the room
+         * so a growing time window copies O(1) per point amortized
+         */
+        size_type room = 2 * n;
+        if (capacity_ > 0) { room = std::min (room, capacity_); }
+        std::vector< Point > points (room);
+        std::rotate_copy (points_.begin (), points_.begin () + head_,
+                points_.end (), points.begin ());
+        points_.swap (points);
+        points_[size_] = p;
+        if (seconds_ > 0.0) {
+            std::vector< double > times (room);
+            std::rotate_copy (times_.begin (), times_.begin () + head_,
+                    times_.end (), times.begin ());
+            times_.swap (times);
+            times_[size_] = t;
+        }
+        head_ = 0;
+    } else {
+        points_.push_back (p);
+        if (seconds_ > 0.0) { times_.push_back (t); }
+    }
+    ++size_;
+
+    unsigned long long seq = seq_++;
+    if (Windowed ()) {
+        /* NaN never bounds a domain, so it is left out of the deques */
+        if (p.X () == p.X ()) {
+            while (! xmin_.empty () && xmin_.back ().value >= p.X ()) {
+                xmin_.pop_back ();
+            }
+            while (! xmax_.empty () && xmax_.back ().value <= p.X ()) {
+                xmax_.pop_back ();
+            }
+            xmin_.push_back (Extreme (seq, p.X ()));
+            xmax_.push_back (Extreme (seq, p.X ()));
+        }
+        if (p.Y () == p.Y ()) {
+            while (! ymin_.empty () && ymin_.back ().value >= p.Y ()) {
+                ymin_.pop_back ();
+            }
+            while (! ymax_.empty () && ymax_.back ().value <= p.Y ()) {
+                ymax_.pop_back ();
+            }
+            ymin_.push_back (Extreme (seq, p.Y ()));
+            ymax_.push_back (Extreme (seq, p.Y ()));
+        }
+        Extremes ();
+    } else if (1 == size_) {
+        xdomain_.Reset (p.X (), p.X ());
+        ydomain_.Reset (p.Y (), p.Y ());
+    } else {
+        extend (xdomain_, p.X ());
+        extend (ydomain_, p.Y ());
+    }
+
+    std::vector< DatasetObserver * >::const_iterator OIT = observers_.begin (),
+        OEND = observers_.end ();
+    for (; OIT != OEND; ++OIT) {
+        (*OIT)->Inserted (p);
+    }
+}
+
+void Dataset::Extremes () {
+    /* an axis without a number keeps its last domain */
+    if (! xmin_.empty ()) {
+        xdomain_.Reset (xmin_.front ().value, xmax_.front ().value);
+    }
+    if (! ymin_.empty ()) {
+        ydomain_.Reset (ymin_.front ().value, ymax_.front ().value);
+    }
+}
+
+void Dataset::EvictOldest () {
+
+    if (0 == size_) { return; }
+
+    Point p (points_[head_]);
+    unsigned long long seq = seq_ - size_;
+
+    if (! xmin_.empty () && seq == xmin_.front ().seq) { xmin_.pop_front (); }
+    if (! xmax_.empty () && seq == xmax_.front ().seq) { xmax_.pop_front (); }
+    if (! ymin_.empty () && seq == ymin_.front ().seq) { ymin_.pop_front (); }
+    if (! ymax_.empty () && seq == ymax_.front ().seq) { ymax_.pop_front (); }
+
+    head_ = (head_ + 1) % points_.size ();
+    --size_;
+
+    /* an empty window keeps its last domains */
+    if (size_ > 0) { Extremes (); }
+
+    std::vector< DatasetObserver * >::const_iterator OIT = observers_.begin (),
+        OEND = observers_.end ();
+    for (; OIT != OEND; ++OIT) {
+        (*OIT)->Evicted (p);
+    }
+}
+
+Dataset::size_type Dataset::ExpireBefore (double t) {
+    size_type n = 0;
+    while (size_ > 0 && times_[head_] < t) {
+        EvictOldest ();
+        ++n;
+    }
+    return n;
+}
+
+Dataset::size_type Dataset::Expire () {
+    if (seconds_ <= 0.0) { return 0; }
+    return ExpireBefore (now () - seconds_);
+}
+
+void Dataset::Attach (DatasetObserver *observer) const {
+    if (observers_.end () == std::find (observers_.begin (), 
+                observers_.end (), observer)) {
+        observers_.push_back (observer);
+    }
+}
+
+void Dataset::Detach (DatasetObserver *observer) const {
+    observers_.erase (std::remove (observers_.begin (), observers_.end (), 
+                observer), observers_.end ());
+}
 
 void Dataset::XData (std::vector< FloatType >& dest) const {
     const_iterator PIT = Begin (), PEND = End ();
     dest.clear ();
     dest.reserve (Size ());
     for (; PIT != PEND; ++PIT) {
-        dest.push_back (PIT->X ());
+        FloatType v = PIT->X ();
+        if (v == v) { dest.push_back (v); }
     }
 }
 
@@ -16,7 +269,7 @@ void Dataset::YData (std::vector< FloatType >& dest) const {
     dest.clear ();
     dest.reserve (Size ());
     for (; PIT != PEND; ++PIT) {
-        dest.push_back (PIT->Y ());
+        FloatType v = PIT->Y ();
+        if (v == v) { dest.push_back (v); }
     }
 }
-
@@ -0,0 +1,215 @@
+
+#include <cmath>
+#include <algorithm>
+#include <graph/facets.h>
+#include <graph/views.h>
+#include <dataset/parallel.h>
+#include <perf/trace.h>
+
+/* Lines of margin around each panel; the top one holds its label */
+#define FACET_MARGIN 0.25
+#define FACET_LABEL 1.25
+
+/*
+ * Limits and orientation of a panel of [type] as draw_plot () sets
+ * them up, from the shared limits in [par]
+ */
+static Parameters panelPar (BasicPlot *panel, int type, const Parameters& par) {
+    const Range& xd = par.xdomain;
+    const Range& yd = par.ydomain;
+
+    switch (type) {
+        case PLOT_HIST_L:
+            panel->Xlim (0.0, 1.0);
+            panel->Ylim (yd.X (), yd.Y ());
+            break;
+        case PLOT_HIST_R:
+            panel->Xlim (1.0, 0.0);
+            panel->Ylim (yd.X (), yd.Y ());
+            break;
+        case PLOT_HIST_T:
+            panel->Xlim (xd.X (), xd.Y ());
+            panel->Ylim (1.0, 0.0);
+            break;
+        case PLOT_HIST_B:
+            panel->Xlim (xd.X (), xd.Y ());
+            panel->Ylim (0.0, 1.0);
+            break;
+        case PLOT_ECDF_H:
+            panel->Xlim (yd.X (), yd.Y ());
+            break;
+        case PLOT_ECDF_V:
+            panel->Ylim (xd.X (), xd.Y ());
+            break;
+        default:
+            panel->Xlim (xd.X (), xd.Y ());
+            panel->Ylim (yd.X (), yd.Y ());
+            break;
+    }
+
+    Parameters p = panel->Par ();
+    switch (type) {
+        case PLOT_BOX_H: p.side = HORIZONTAL; break;
+        case PLOT_BOX_V: p.side = VERTICAL; break;
+        case PLOT_ECDF_V: p.side = VERTICAL; break;
+        case PLOT_HIST_L: p.side = SIDE_LEFT; break;
+        case PLOT_HIST_R: p.side = SIDE_RIGHT; break;
+        case PLOT_HIST_T: p.side = SIDE_TOP; break;
+        case PLOT_HIST_B: p.side = SIDE_BOTTOM; break;
+        default: break;
+    }
+    p.nbins = par.nbins;
+    p.cmap = par.cmap;
+    p.cscale = par.cscale;
+    p.nsd = par.nsd;
+    p.kde = par.kde;
+    p.contours = par.contours;
+    p.fit = par.fit;
+    p.corr = par.corr;
+    return p;
+}
+
+FacetPlot::~FacetPlot () {
+    DeletePanels ();
+}
+
+void FacetPlot::DeletePanels () {
+    for (std::size_t i = 0; i < panels_.size (); ++i) {
+        delete panels_[i];
+    }
+    panels_.clear ();
+}
+
+void FacetPlot::Facets (int type, const std::vector< const Dataset * >& data,
+        const std::vector< std::string >& labels) {
+    if (PLOT_SPLOM == type || PLOT_FACETS == type ||
+            PLOT_CORRELATION == type || type < 0 || type >= MAX_PLOT) {
+        throw GeneralException ("Plot type cannot be faceted",
+                __FILE__, __LINE__);
+    }
+    if (type != type_) { DeletePanels (); }
+    type_ = type;
+    data_ = data;
+    labels_ = labels;
+}
+
+void FacetPlot::Layout (std::size_t n, std::size_t& cols, FloatType& left,
+        FloatType& top, FloatType& width, FloatType& height) const {
+    /* near square grid filled row by row */
+    cols = static_cast< std::size_t >(ceil (sqrt (n)));
+    std::size_t rows = (n + cols - 1) / cols;
+    left = XRange ().Low ();
+    top = std::min (YRange ().Low (), YRange ().High ());
+    width = XRange ().Distance () / cols;
+    height = YRange ().Distance () / rows;
+}
+
+Point FacetPlot::Locate (FloatType x, FloatType y) const {
+    std::size_t n = panels_.size (), cols = 0;
+    if (0 == n) { return BasicPlot::Locate (x, y); }
+    FloatType left = 0.0, top = 0.0, width = 0.0, height = 0.0;
+    Layout (n, cols, left, top, width, height);
+    FloatType c = floor ((x - left) / width), r = floor ((y - top) / height);
+    std::size_t col = (c > 0.0) ? static_cast< std::size_t >(c) : 0,
+                row = (r > 0.0) ? static_cast< std::size_t >(r) : 0;
+    std::size_t i = std::min (row * cols + std::min (col, cols - 1), n - 1);
+
+    /*
+     * where the pixel falls across the panel's own limits, which may be
+     * from its last draw, carried over to the limits of the grid
+     */
+    Point at = panels_[i]->Locate (x, y);
+    const Range& px = panels_[i]->Par ().xdomain;
+    const Range& py = panels_[i]->Par ().ydomain;
+    return Point (transform (at.X (), px, Par ().xdomain),
+            transform (at.Y (), py, Par ().ydomain));
+}
+
+void FacetPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
+void FacetPlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("FacetPlot::Plot");
+
+    std::vector< const Dataset * > sets (data_);
+    std::vector< std::string > labels (labels_);
+    if (sets.empty ()) {
+        sets.push_back (&data);
+        labels.push_back ("");
+    }
+
+    std::size_t n = sets.size (), points = 0;
+    for (std::size_t i = 0; i < n; ++i) { points += sets[i]->Size (); }
+    Stats ().Points (points);
+
+    std::size_t cols = 0;
+    FloatType left = 0.0, top = 0.0, width = 0.0, height = 0.0;
+    Layout (n, cols, left, top, width, height);
+
+    while (panels_.size () > n) {
+        delete panels_.back ();
+        panels_.pop_back ();
+    }
+    while (panels_.size () < n) {
+        BasicPlot *panel = (NULL != win_) ? new_plot (type_, win_) :
+            new_plot (type_, bmp_);
+        Parameters p = panel->Par ();
+        p.oma.left = p.oma.right = p.oma.bottom = FACET_MARGIN;
+        p.oma.top = FACET_LABEL;
+        panel->Par (p);
+        panels_.push_back (panel);
+    }
+
+    std::vector< Parameters > pars;
+    for (std::size_t i = 0; i < n; ++i) {
+        FloatType x = left + (i % cols) * width, y = top + (i / cols) * height;
+        panels_[i]->Region (x, y, x + width, y + height);
+        pars.push_back (panelPar (panels_[i], type_, par));
+    }
+
+    {
+        ScopedTimer compute (Stats (), STAGE_COMPUTE);
+        parallelFor (n, [&] (std::size_t i) {
+            /* a group that cannot be prepared is noted when drawn */
+            try {
+                panels_[i]->Prepare (*sets[i], pars[i]);
+            } catch (const std::exception&) {}
+        });
+    }
+
+    ScopedTimer draw (Stats (), STAGE_DRAW);
+
+    for (std::size_t i = 0; i < n; ++i) {
+        BasicPlot *panel = panels_[i];
+        FloatType x = left + (i % cols) * width, y = top + (i / cols) * height;
+
+        /*
+         * the panels differ only in their data, so a group the plot
+         * refuses (e.g. all NaN) gets a note in place of the plot
+         */
+        const char *note = NULL;
+        if (0 == sets[i]->Size ()) {
+            note = "No data";
+        } else {
+            try {
+                panel->Plot (*sets[i], pars[i]);
+            } catch (const std::exception&) {
+                note = "Not enough data";
+            }
+        }
+
+        /* shared axes: ticks on the outer panels only */
+        Parameters p = panel->Par ();
+        p.side = pars[i].side;
+        if (i + cols >= n) { panel->XTicks (p); }
+        if (0 == i % cols) { panel->YTicks (p); }
+        panel->Box ();
+
+        GrabFocus ();
+        al_draw_text (par.font, par.font_col, x + width / 2.0,
+                y + (FACET_LABEL - 1.0) * par.font_px, ALIGN_CENTER,
+                labels[i].c_str ());
+        if (NULL != note) {
+            al_draw_text (par.font, par.font_col, x + width / 2.0,
+                    y + (height - par.font_px) / 2.0, ALIGN_CENTER, note);
+        }
+    }
+}
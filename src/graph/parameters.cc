@@ -1,14 +1,33 @@
 
+#include <map>
 #include <graph/parameters.h>
 #include <graph/exceptions.h>
 #include <graph/util.h>
+#include <graph/colormap.h>
+#include <dataset/kde.h>
+#include <dataset/regression.h>
+#include <perf/stats.h>
+
+/*
+ * Every Parameters instance used to load its own copy of the font;
+ * fonts are immutable once loaded so share one per size
+ */
+static std::map< int, ALLEGRO_FONT * > font_cache;
 
 void Parameters::LoadFont (FloatType cex) {
     int sz = static_cast< int >(floor (cex * DEFAULT_FONT_SIZE));
     if (sz <= 0) { sz = 1; }
-    font = al_load_font ("fonts/FreeMono.ttf", sz, 0);
-    if (NULL == font) { 
-        throw GeneralException ("Failed to load font", __FILE__, __LINE__);
+    std::map< int, ALLEGRO_FONT * >::const_iterator FIT = font_cache.find (sz);
+    if (font_cache.end () != FIT) {
+        cacheCounter ("font").Hit ();
+        font = FIT->second;
+    } else {
+        cacheCounter ("font").Miss ();
+        font = al_load_font ("fonts/FreeMono.ttf", sz, 0);
+        if (NULL == font) { 
+            throw GeneralException ("Failed to load font", __FILE__, __LINE__);
+        }
+        font_cache[sz] = font;
     }
     font_px = al_get_font_line_height (font);
 }
@@ -41,6 +60,15 @@ void Parameters::Reset () {
 
     nbins = 20;
 
+    cmap = CMAP_WHITE;
+    cscale = SCALE_LINEAR;
+
+    nsd = 2.0;
+    kde = KDE_NONE;
+    contours.clear ();
+    fit = 0;
+    corr = CORR_PEARSON;
+
     align = ALIGN_CENTER;
 
     col = mkcol (50, 50, 255, 255);
@@ -5,31 +5,45 @@
 
 #include <graph/plot.h>
 #include <graph/util.h>
+#include <graph/colormap.h>
 #include <dataset/summary.h>
+#include <dataset/binning.h>
+#include <perf/trace.h>
 
 void BasicPlot::Initialize () {
+    Region (0.0, 0.0, DisplayWidth (), DisplayHeight ());
+}
+
+void BasicPlot::Region (FloatType x1, FloatType y1, FloatType x2, 
+        FloatType y2) {
     FloatType off_left = par_.oma.left * par_.font_px,
               off_right = par_.oma.right * par_.font_px,
               off_top = par_.oma.top * par_.font_px,
               off_bottom = par_.oma.bottom * par_.font_px;
 
-    view_.SetXRange (0.0 + off_left, DisplayWidth () - off_right);
-    view_.SetYRange (DisplayHeight () - off_bottom, 0.0 + off_top);
+    view_.SetXRange (x1 + off_left, x2 - off_right);
+    view_.SetYRange (y2 - off_bottom, y1 + off_top);
+}
+
+Point BasicPlot::Locate (FloatType x, FloatType y) const {
+    return Point (transform (x, XRange (), par_.xdomain),
+            transform (y, YRange (), par_.ydomain));
 }
 
 void BasicPlot::GrabFocus () const {
-    if (Display () != al_get_current_display ()) {
-        al_set_target_bitmap (al_get_backbuffer (Display ()));
+    if (Target () != al_get_target_bitmap ()) {
+        al_set_target_bitmap (Target ());
     }
 }
 
 bool BasicPlot::Selected () const {
-    return Display () == al_get_current_display ();
+    return NULL != Display () && Display () == al_get_current_display ();
 }
 
 void BasicPlot::Clear () const {
     /* TODO: make these colors configrable */
     if (Selected ()) {
+        GrabFocus ();
         al_clear_to_color (al_map_rgb (20, 20, 20));
     } else {
         GrabFocus ();
@@ -38,7 +52,10 @@ void BasicPlot::Clear () const {
 }
 
 void BasicPlot::Update () const {
+    if (NULL == Display ()) { return; }
+    ScopedTimer timer (Stats (), STAGE_FLIP);
     GrabFocus ();
+    TRACE_SCOPE ("al_flip_display");
     al_flip_display ();
 }
 
@@ -114,8 +131,9 @@ void BasicPlot::Lines (const std::vector< Line >& lines,
     GrabFocus ();
 
     for (; LIT != LEND; ++LIT) {
+        Line clipped (*LIT);
+        if (! lineclip (par.xdomain, par.ydomain, clipped)) { continue; }
         /* transform from dataset domain to plot range */
-        Line clipped = lineclip (par.xdomain, par.ydomain, *LIT);
         FloatType x1 = transform (clipped.Start ().X (), 
                 par.xdomain, XRange ());
         FloatType y1 = transform (clipped.Start ().Y (), 
@@ -124,8 +142,44 @@ void BasicPlot::Lines (const std::vector< Line >& lines,
                 par.xdomain, XRange ());
         FloatType y2 = transform (clipped.End ().Y (), 
                 par.ydomain, YRange ());
-        al_draw_line (x1, y1, x2, y2, Par ().col, Par ().lwd);
+        al_draw_line (x1, y1, x2, y2, par.col, par.lwd);
+    }
+}
+
+void BasicPlot::Fit (const Polynomial& fit, FloatType r,
+        const Parameters& par) const {
+
+    if (fit.Empty ()) { return; }
+
+    /* short enough segments for a cubic to look smooth */
+    const int segments = 64;
+    const Range& xd = par.xdomain;
+    const Range& yd = par.ydomain;
+    std::vector< Line > lines;
+    for (int i = 0; i < segments; ++i) {
+        FloatType x0 = xd.Low () + xd.Distance () * i / segments;
+        FloatType x1 = xd.Low () + xd.Distance () * (i + 1) / segments;
+        FloatType y0 = fit.At (x0), y1 = fit.At (x1);
+        /* the segment is inside the x limits, so it shows if its y do */
+        if (std::max (y0, y1) < yd.Low () || std::min (y0, y1) > yd.High ()) {
+            continue;
+        }
+        lines.push_back (Line (Point (x0, y0), Point (x1, y1)));
+    }
+    Parameters lpar = par;
+    lpar.col = par.font_col;
+    Lines (lines, lpar);
+
+    char label[64];
+    if (r == r) {
+        snprintf (label, sizeof (label), "%s = %.3f  R^2 = %.3f",
+                (CORR_SPEARMAN == par.corr) ? "rho" : "r", r, fit.R2 ());
+    } else {
+        snprintf (label, sizeof (label), "R^2 = %.3f", fit.R2 ());
     }
+    al_draw_text (par.font, par.font_col, XRange ().High () - par.font_px,
+            std::min (YRange ().Low (), YRange ().High ()) + par.font_px / 2.0,
+            ALIGN_RIGHT, label);
 }
 
 void BasicPlot::Xlim (FloatType xmin, FloatType xmax) {
@@ -306,12 +360,46 @@ void BasicPlot::Text (const Point& at, const std::string& text,
             "%s", text.c_str ());
 }
 
+void BasicPlot::Overlay (const std::vector< std::string >& lines) const { 
+    Overlay (lines, Par ()); 
+}
+void BasicPlot::Overlay (const std::vector< std::string >& lines, 
+        const Parameters& par) const { 
+
+    FloatType width = 0.0;
+    FloatType x = par.font_px, y = par.font_px;
+    std::vector< std::string >::const_iterator LIT = lines.begin (),
+        LEND = lines.end ();
+
+    for (; LIT != LEND; ++LIT) {
+        width = std::max (width, 
+                static_cast< FloatType >(al_get_text_width (par.font, 
+                        LIT->c_str ())));
+    }
+
+    GrabFocus ();
+
+    /* TODO: make configurable */
+    al_draw_filled_rectangle (x - 0.5 * par.font_px, y - 0.5 * par.font_px,
+            x + width + 0.5 * par.font_px, 
+            y + (lines.size () + 0.5) * par.font_px, 
+            mkcol (0, 0, 0, 200));
+
+    for (LIT = lines.begin (); LIT != LEND; ++LIT) {
+        al_draw_textf (par.font, par.font_col, x, y, ALIGN_LEFT, 
+                "%s", LIT->c_str ());
+        y += par.font_px;
+    }
+}
+
 void ECDFPlot::Plot (const Dataset& data) { 
     Parameters par(Par ());
     par.side = HORIZONTAL;
     Plot (data, par);
 }
 void ECDFPlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("ECDFPlot::Plot");
+    Stats ().Points (data.Size ());
     if (HORIZONTAL == par.side) {
         ECDFHorizontal (data, par);
     } else {
@@ -319,20 +407,35 @@ void ECDFPlot::Plot (const Dataset& data, const Parameters& par) {
     }
 }
 
+void ECDFPlot::Prepare (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("ECDFPlot::Prepare");
+    ScopedTimer timer (Stats (), STAGE_COMPUTE);
+    Sorted ().Update (data, (HORIZONTAL == par.side) ? AXIS_Y : AXIS_X);
+}
+
 void ECDFPlot::ECDFHorizontal (const Dataset& data, const Parameters& par) {
-    Dataset::size_type n = data.Size (), i = 1;
-    std::vector< FloatType > samples; 
+    Dataset::size_type n = 0, i = 1;
+    const std::vector< FloatType > *sorted = NULL;
+
+    {
+        ScopedTimer timer (Stats (), STAGE_COMPUTE);
+        sorted = &Sorted ().Update (data, AXIS_Y);
+        n = sorted->size ();
+    }
+    const std::vector< FloatType >& samples = *sorted;
+
+    ScopedTimer timer (Stats (), STAGE_DRAW);
 
     GrabFocus ();
 
+    /* y values run along the x limits */
     Parameters mod(Par ());
     mod.SetYDomain (-0.1, 1.10);
-    mod.SetXDomain (data.YDomain ().Low (), data.YDomain ().High ());
-    data.YData (samples);
+    mod.SetXDomain (par.xdomain.X (), par.xdomain.Y ());
     Par(mod);
 
     /* Draw the boundary lines @ 0.0 and 1.0 */
-    FloatType x1 = data.YDomain ().Low (), x2 = data.YDomain ().High ();
+    FloatType x1 = mod.xdomain.Low (), x2 = mod.xdomain.High ();
     FloatType y1 = 1.0, y2 = 0.0;
     x1 = transform (x1, mod.xdomain, XRange ());
     x2 = transform (x2, mod.xdomain, XRange ());
@@ -341,9 +444,11 @@ void ECDFPlot::ECDFHorizontal (const Dataset& data, const Parameters& par) {
     al_draw_line (x1, y1, x2, y1, par.col, 1.0);
     al_draw_line (x1, y2, x2, y2, par.col, 1.0);
 
-    std::sort (samples.begin (), samples.end ());
-    std::vector< FloatType >::const_iterator SIT = samples.begin (),
-        SEND = samples.end ();
+    /* the samples inside the limits, keeping their ranks */
+    std::vector< FloatType >::const_iterator SIT = std::lower_bound (
+            samples.begin (), samples.end (), mod.xdomain.Low ()),
+        SEND = std::upper_bound (SIT, samples.end (), mod.xdomain.High ());
+    i += SIT - samples.begin ();
     for (; SIT != SEND; ++SIT, ++i) {
         FloatType y = static_cast< FloatType >(i) / static_cast< FloatType >(n);
         FloatType x = *SIT;
@@ -354,19 +459,28 @@ void ECDFPlot::ECDFHorizontal (const Dataset& data, const Parameters& par) {
 }
 
 void ECDFPlot::ECDFVertical (const Dataset& data, const Parameters& par) {
-    Dataset::size_type n = data.Size (), i = 1;
-    std::vector< FloatType > samples; 
+    Dataset::size_type n = 0, i = 1;
+    const std::vector< FloatType > *sorted = NULL;
+
+    {
+        ScopedTimer timer (Stats (), STAGE_COMPUTE);
+        sorted = &Sorted ().Update (data, AXIS_X);
+        n = sorted->size ();
+    }
+    const std::vector< FloatType >& samples = *sorted;
+
+    ScopedTimer timer (Stats (), STAGE_DRAW);
 
     GrabFocus ();
 
+    /* x values run along the y limits */
     Parameters mod(Par ());
     mod.SetXDomain (-0.1, 1.10);
-    mod.SetYDomain (data.XDomain ().Low (), data.XDomain ().High ());
-    data.XData (samples);
+    mod.SetYDomain (par.ydomain.X (), par.ydomain.Y ());
     Par(mod);
 
     /* Draw the boundary lines @ 0.0 and 1.0 */
-    FloatType y1 = data.XDomain ().Low (), y2 = data.XDomain ().High ();
+    FloatType y1 = mod.ydomain.Low (), y2 = mod.ydomain.High ();
     FloatType x1 = 1.0, x2 = 0.0;
     x1 = transform (x1, mod.xdomain, XRange ());
     x2 = transform (x2, mod.xdomain, XRange ());
@@ -375,9 +489,11 @@ void ECDFPlot::ECDFVertical (const Dataset& data, const Parameters& par) {
     al_draw_line (x1, y1, x1, y2, par.col, 1.0);
     al_draw_line (x2, y1, x2, y2, par.col, 1.0);
 
-    std::sort (samples.begin (), samples.end ());
-    std::vector< FloatType >::const_iterator SIT = samples.begin (),
-        SEND = samples.end ();
+    /* the samples inside the limits, keeping their ranks */
+    std::vector< FloatType >::const_iterator SIT = std::lower_bound (
+            samples.begin (), samples.end (), mod.ydomain.Low ()),
+        SEND = std::upper_bound (SIT, samples.end (), mod.ydomain.High ());
+    i += SIT - samples.begin ();
     for (; SIT != SEND; ++SIT, ++i) {
         FloatType x = static_cast< FloatType >(i) / static_cast< FloatType >(n);
         FloatType y = *SIT;
@@ -388,27 +504,209 @@ void ECDFPlot::ECDFVertical (const Dataset& data, const Parameters& par) {
 }
 
 void ScatterPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
+const PointPyramid::Level * ScatterPlot::Detail (const Dataset& data,
+        const Parameters& par) {
+    pyramid_.Update (data);
+    /* data units per pixel at the current limits */
+    FloatType xres = par.xdomain.Distance () / XRange ().Distance ();
+    FloatType yres = par.ydomain.Distance () / YRange ().Distance ();
+    const PointPyramid::Level *level = pyramid_.Select (xres, yres);
+    if (NULL == level) { index_.Update (data); }
+    return level;
+}
+
+void ScatterPlot::Prepare (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("ScatterPlot::Prepare");
+    ScopedTimer timer (Stats (), STAGE_COMPUTE);
+    Detail (data, par);
+    if (par.nsd > 0.0 || ! par.contours.empty ()) { Spread ().Update (data); }
+    if (! par.contours.empty ()) { Areas ().Update (data); }
+    if (par.fit > 0) { Regression ().Update (data); }
+    if (par.fit > 0 && CORR_SPEARMAN == par.corr) { ranks_.Update (data); }
+}
+
+/* Pixels across each cell density contours are traced over, and most cells */
+#define CONTOUR_PX 4
+#define CONTOUR_CELLS 256
+
+/*
+ * Density contours of [table] over the limits in [par] drawn over
+ * [xrng] x [yrng], smoothed by Scott's rule (sd n^-1/6 in 2D) from the
+ * spread in [xy]. Cells are a fixed size on screen so the cost of a
+ * pan or zoom does not depend on the data.
+ */
+static const std::vector< Line >& densityContours (DensityContours& contours,
+        const SummedAreaTable& table, const Comoments& xy, const Range& xrng,
+        const Range& yrng, const Parameters& par) {
+    int ncols = std::min (CONTOUR_CELLS, static_cast< int >(
+                xrng.Distance () / CONTOUR_PX));
+    int nrows = std::min (CONTOUR_CELLS, static_cast< int >(
+                yrng.Distance () / CONTOUR_PX));
+    FloatType shrink = (xy.Count () < 2) ? 0.0 : pow (xy.Count (), -1.0 / 6.0);
+    return contours.Update (table, par.xdomain, par.ydomain, ncols, nrows,
+            xy.X ().StdDev () * shrink, xy.Y ().StdDev () * shrink,
+            par.contours);
+}
+
+/* Mark [x], [y] (in pixels) with a cross [size] px across */
+static void markMean (FloatType x, FloatType y, FloatType size, ColorType col,
+        FloatType lwd) {
+    FloatType h = size / 2.0;
+    al_draw_line (x - h, y - h, x + h, y + h, col, lwd);
+    al_draw_line (x - h, y + h, x + h, y - h, col, lwd);
+}
+
+void ScatterPlot::Ellipse (const Comoments& xy, const Parameters& par) {
+
+    if (xy.Count () < 2) { return; }
+
+    /* half axes along the eigenvectors of the covariance matrix */
+    FloatType sxx = xy.X ().Variance (), syy = xy.Y ().Variance ();
+    FloatType sxy = xy.Covariance ();
+    FloatType mid = (sxx + syy) / 2.0;
+    FloatType root = sqrt ((sxx - syy) * (sxx - syy) / 4.0 + sxy * sxy);
+    FloatType a = par.nsd * sqrt (mid + root);
+    FloatType b = par.nsd * sqrt (std::max (static_cast< FloatType >(0.0),
+                mid - root));
+    FloatType theta = 0.5 * atan2 (2.0 * sxy, sxx - syy);
+    FloatType mx = xy.X ().Mean (), my = xy.Y ().Mean ();
+
+    const int segments = 96;
+    std::vector< Point > rim;
+    for (int i = 0; i <= segments; ++i) {
+        FloatType t = 2.0 * M_PI * i / segments;
+        FloatType u = a * cos (t), v = b * sin (t);
+        rim.push_back (Point (mx + u * cos (theta) - v * sin (theta),
+                    my + u * sin (theta) + v * cos (theta)));
+    }
+
+    const Range& xd = par.xdomain;
+    const Range& yd = par.ydomain;
+    for (int i = 0; i < segments; ++i) {
+        /* a segment may cut across a corner with neither end showing */
+        Line seg (rim[i], rim[i + 1]);
+        if (! lineclip (xd, yd, seg)) { continue; }
+        al_draw_line (transform (seg.Start ().X (), xd, XRange ()),
+                transform (seg.Start ().Y (), yd, YRange ()),
+                transform (seg.End ().X (), xd, XRange ()),
+                transform (seg.End ().Y (), yd, YRange ()),
+                par.font_col, par.lwd);
+    }
+    if (xd.Contains (mx) && yd.Contains (my)) {
+        markMean (transform (mx, xd, XRange ()), transform (my, yd, YRange ()),
+                4.0 * par.rad, par.font_col, par.lwd);
+    }
+}
+
+/*
+ * Alpha of a level-of-detail cell holding a single point, and the
+ * counts shaded apart on the way to full
+ */
+#define LOD_FAINT 0.35
+#define LOD_SHADES 1024
+
 void ScatterPlot::Plot (const Dataset& data, const Parameters& par) {
-    Dataset::const_iterator DIT = data.Begin (), DEND = data.End ();
+    TRACE_SCOPE ("ScatterPlot::Plot");
+
+    Stats ().Points (data.Size ());
+    const PointPyramid::Level *level = NULL;
+    const PointMoments *moments = NULL;
+    const std::vector< Line > *contours = NULL;
+    Polynomial fit;
+    FloatType r = NAN;
+    {
+        ScopedTimer timer (Stats (), STAGE_COMPUTE);
+        level = Detail (data, par);
+        if (par.nsd > 0.0 || ! par.contours.empty ()) {
+            moments = &Spread ().Update (data);
+        }
+        if (! par.contours.empty ()) {
+            contours = &densityContours (contours_, Areas ().Update (data),
+                    moments->XY (), XRange (), YRange (), par);
+        }
+        if (par.fit > 0) {
+            const PowerSums& sums = Regression ().Update (data);
+            fit = sums.Fit (par.fit);
+            r = (CORR_SPEARMAN == par.corr) ?
+                ranks_.Update (data) : sums.Correlation ();
+        }
+    }
+
+    ScopedTimer timer (Stats (), STAGE_DRAW);
 
     GrabFocus ();
 
-    for (; DIT != DEND; ++DIT) {
+    auto dot = [&] (FloatType x, FloatType y, const ColorType& col) {
         /* transform from dataset domain to plot range */
-        FloatType x = transform (DIT->X (), par.xdomain, XRange ());
-        FloatType y = transform (DIT->Y (), par.ydomain, YRange ());
-        if (XRange ().Contains (x) && YRange ().Contains (y)) {
-            if (par.cex < 1.0) {
-                al_draw_pixel (x, y, par.col);
-            } else {
-                al_draw_circle (x, y, par.cex * par.rad, par.col, par.lwd);
-            }
+        FloatType tx = transform (x, par.xdomain, XRange ());
+        FloatType ty = transform (y, par.ydomain, YRange ());
+        if (par.cex < 1.0) {
+            al_draw_pixel (tx, ty, col);
+        } else {
+            al_draw_circle (tx, ty, par.cex * par.rad, col, par.lwd);
         }
+    };
+
+    /*
+     * zoomed in, the points off the plot are never visited; zoomed
+     * out, only about one per pixel is, shaded by the points it holds
+     */
+    if (NULL == level) {
+        index_.Visible (par.xdomain, par.ydomain,
+                [&] (FloatType x, FloatType y) { dot (x, y, par.col); });
+    } else {
+        /* shades by count, the fullest ones past LOD_SHADES all alike */
+        FloatType top = log1p (static_cast< FloatType >(level->max));
+        std::vector< ColorType > shades (std::min (level->max,
+                    static_cast< long >(LOD_SHADES)) + 1);
+        for (std::size_t i = 1; i < shades.size (); ++i) {
+            FloatType a = (i + 1 < shades.size ()) ? LOD_FAINT +
+                (1.0 - LOD_FAINT) * log1p (static_cast< FloatType >(i)) / top :
+                1.0;
+            /* colors are premultiplied, so every channel fades */
+            shades[i] = par.col;
+            shades[i].r *= a;
+            shades[i].g *= a;
+            shades[i].b *= a;
+            shades[i].a *= a;
+        }
+        pyramid_.Visible (*level, par.xdomain, par.ydomain,
+                [&] (FloatType x, FloatType y, long count) {
+            dot (x, y, shades[std::min (count,
+                        static_cast< long >(shades.size ()) - 1)]);
+        });
+    }
+
+    if (NULL != contours) {
+        Parameters lines = par;
+        lines.col = par.font_col;
+        Lines (*contours, lines);
+    }
+    if (NULL != moments && par.nsd > 0.0) { Ellipse (moments->XY (), par); }
+    Fit (fit, r, par);
+}
+
+BinCache& HistogramPlot::Cache (Axis axis, int nbins) {
+    return (NULL == pool_) ? bins_ : pool_->Get (axis, nbins);
+}
+
+void HistogramPlot::Prepare (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("HistogramPlot::Prepare");
+    ScopedTimer timer (Stats (), STAGE_COMPUTE);
+    if (SIDE_BOTTOM == par.side || SIDE_TOP == par.side) {
+        Cache (AXIS_X, par.nbins).Update (data, AXIS_X, par.xdomain, 
+                par.nbins, sorted_);
+        if (KDE_NONE != par.kde) { kde_.Update (data, AXIS_X, par.kde); }
+    } else {
+        Cache (AXIS_Y, par.nbins).Update (data, AXIS_Y, par.ydomain, 
+                par.nbins, sorted_);
+        if (KDE_NONE != par.kde) { kde_.Update (data, AXIS_Y, par.kde); }
     }
 }
 
 void HistogramPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
 void HistogramPlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("HistogramPlot::Plot");
     /*
      * TODO: The only difference between TOP/BOTTOM or LEFT/RIGHT
      * is the Range settings. Roll up the common parts here (i.e.
@@ -416,6 +714,7 @@ void HistogramPlot::Plot (const Dataset& data, const Parameters& par) {
      * ratio) then pass the results onto a common method to handle
      * the plotting
      */
+    Stats ().Points (data.Size ());
     switch (par.side) {
         case SIDE_BOTTOM:
             HistBottom (data, par);
@@ -434,28 +733,67 @@ void HistogramPlot::Plot (const Dataset& data, const Parameters& par) {
     }
 }
 
-void HistogramPlot::HistBottom (const Dataset& data, const Parameters& par) {
+void HistogramPlot::Curve (Axis axis, FloatType bin_width, const Range& along,
+        const Range& across, const Parameters& par) {
+
+    if (KDE_NONE == par.kde) { return; }
+    const std::vector< FloatType >& density = kde_.Density ();
+    if (density.size () < 2) { return; }
+
+    const Range& pos = (AXIS_X == axis) ? XRange () : YRange ();
+    const Range& val = (AXIS_X == axis) ? YRange () : XRange ();
+    FloatType top = across.High ();
+
+    /* about a point per pixel along the axis */
+    FloatType px = kde_.Step () * pos.Distance () / along.Distance ();
+    std::size_t stride = std::max (static_cast< std::size_t >(1),
+            static_cast< std::size_t >(1.0 / px));
+
+    FloatType u0 = 0.0, v0 = 0.0;
+    bool drawn = false;
+    for (std::size_t k = 0; k < density.size (); k += stride) {
+        FloatType at = kde_.First () + k * kde_.Step ();
+        if (! along.Contains (at)) {
+            drawn = false;
+            continue;
+        }
+        FloatType u = transform (at, along, pos);
+        FloatType v = transform (std::min (density[k] * bin_width, top),
+                across, val);
+        if (drawn) {
+            if (AXIS_X == axis) {
+                al_draw_line (u0, v0, u, v, par.col, par.lwd);
+            } else {
+                al_draw_line (v0, u0, v, u, par.col, par.lwd);
+            }
+        }
+        u0 = u;
+        v0 = v;
+        drawn = true;
+    }
+}
 
-    Dataset::const_iterator DIT = data.Begin (),
-        DEND = data.End ();
+void HistogramPlot::HistBottom (const Dataset& data, const Parameters& par) {
 
     int nbins = par.nbins;
     const Range& xdomain = par.xdomain;
-    FloatType lowx = data.XDomain ().Low ();
-    FloatType bin_width = data.XDomain ().Distance () / nbins;
-    std::vector< long > bins(nbins);
     long bin_max = 0;
     ColorType col = mkcol (0, 0, 0, 255);
+    BinCache& cache = Cache (AXIS_X, nbins);
 
-    GrabFocus ();
-
-    for (; DIT != DEND; ++DIT) {
-        int bin = static_cast< int >(floor ((DIT->X () - lowx) / bin_width));
-        /* anything on the border gets placed in the final bin */
-        if (bin == nbins) { --bin; }
-        bins[bin]++;
-        bin_max = std::max (bin_max, bins[bin]);
+    {
+        ScopedTimer timer (Stats (), STAGE_COMPUTE);
+        bin_max = cache.Update (data, AXIS_X, xdomain, nbins,
+                sorted_);
+        if (KDE_NONE != par.kde) { kde_.Update (data, AXIS_X, par.kde); }
     }
+    const std::vector< long >& bins = cache.Bins ();
+    FloatType lowx = cache.Domain ().Low ();
+    FloatType bin_width = cache.Domain ().Distance () / nbins;
+
+    ScopedTimer timer (Stats (), STAGE_DRAW);
+
+    GrabFocus ();
 
     /* TODO: 
      * FIXME:
@@ -471,9 +809,10 @@ void HistogramPlot::HistBottom (const Dataset& data, const Parameters& par) {
     const Range& ydomain = p.ydomain;
 
     for (int n = 0; n < nbins; ++n) {
-        FloatType a = lowx + n * bin_width, b = lowx + (n + 1) * bin_width;
-        /* Only if the results fit in the selected xlimits */
-        if (xdomain.Contains (a) && xdomain.Contains (b)) {
+        /* cut at the selected xlimits */
+        FloatType a = std::max (lowx + n * bin_width, xdomain.Low ());
+        FloatType b = std::min (lowx + (n + 1) * bin_width, xdomain.High ());
+        if (a < b) {
             FloatType x1 = transform (a, xdomain, XRange ());
             FloatType x2 = transform (b, xdomain, XRange ());
             FloatType ratio = static_cast< FloatType >(bins[n]) / 
@@ -485,30 +824,31 @@ void HistogramPlot::HistBottom (const Dataset& data, const Parameters& par) {
             al_draw_rectangle (x1, y1, x2, y2, col, 1.0);
         }
     }
+
+    Curve (AXIS_X, bin_width, xdomain, ydomain, par);
 }
 
 void HistogramPlot::HistRight (const Dataset& data, const Parameters& par) {
 
-    Dataset::const_iterator DIT = data.Begin (),
-        DEND = data.End ();
-
     int nbins = par.nbins;
     const Range& ydomain = par.ydomain;
-    FloatType lowy = data.YDomain ().Low ();
-    FloatType bin_width = data.YDomain ().Distance () / nbins;
-    std::vector< long > bins(nbins);
     long bin_max = 0;
     ColorType col = mkcol (0, 0, 0, 255);
+    BinCache& cache = Cache (AXIS_Y, nbins);
 
-    GrabFocus ();
-
-    for (; DIT != DEND; ++DIT) {
-        int bin = static_cast< int >(floor ((DIT->Y () - lowy) / bin_width));
-        /* anything on the border gets placed in the final bin */
-        if (bin == nbins) { --bin; }
-        bins[bin]++;
-        bin_max = std::max (bin_max, bins[bin]);
+    {
+        ScopedTimer timer (Stats (), STAGE_COMPUTE);
+        bin_max = cache.Update (data, AXIS_Y, ydomain, nbins,
+                sorted_);
+        if (KDE_NONE != par.kde) { kde_.Update (data, AXIS_Y, par.kde); }
     }
+    const std::vector< long >& bins = cache.Bins ();
+    FloatType lowy = cache.Domain ().Low ();
+    FloatType bin_width = cache.Domain ().Distance () / nbins;
+
+    ScopedTimer timer (Stats (), STAGE_DRAW);
+
+    GrabFocus ();
 
     /* TODO: 
      * FIXME:
@@ -523,9 +863,10 @@ void HistogramPlot::HistRight (const Dataset& data, const Parameters& par) {
     const Range& xdomain = p.xdomain;
 
     for (int n = 0; n < nbins; ++n) {
-        FloatType a = lowy + n * bin_width, b = lowy + (n + 1) * bin_width;
-        /* Only if the results fit in the selected ylimits */
-        if (ydomain.Contains (a) && ydomain.Contains (b)) {
+        /* cut at the selected ylimits */
+        FloatType a = std::max (lowy + n * bin_width, ydomain.Low ());
+        FloatType b = std::min (lowy + (n + 1) * bin_width, ydomain.High ());
+        if (a < b) {
             FloatType ratio = static_cast< FloatType >(bins[n]) / 
                 static_cast< FloatType >(data.Size ());
             FloatType x1 = transform (ratio, xdomain, XRange ());
@@ -537,30 +878,31 @@ void HistogramPlot::HistRight (const Dataset& data, const Parameters& par) {
             al_draw_rectangle (x1, y1, x2, y2, col, 1.0);
         }
     }
+
+    Curve (AXIS_Y, bin_width, ydomain, xdomain, par);
 }
 
 void HistogramPlot::HistTop (const Dataset& data, const Parameters& par) {
 
-    Dataset::const_iterator DIT = data.Begin (),
-        DEND = data.End ();
-
     int nbins = par.nbins;
     const Range& xdomain = par.xdomain;
-    FloatType lowx = data.XDomain ().Low ();
-    FloatType bin_width = data.XDomain ().Distance () / nbins;
-    std::vector< long > bins(nbins);
     long bin_max = 0;
     ColorType col = mkcol (0, 0, 0, 255);
+    BinCache& cache = Cache (AXIS_X, nbins);
 
-    GrabFocus ();
-
-    for (; DIT != DEND; ++DIT) {
-        int bin = static_cast< int >(floor ((DIT->X () - lowx) / bin_width));
-        /* anything on the border gets placed in the final bin */
-        if (bin == nbins) { --bin; }
-        bins[bin]++;
-        bin_max = std::max (bin_max, bins[bin]);
+    {
+        ScopedTimer timer (Stats (), STAGE_COMPUTE);
+        bin_max = cache.Update (data, AXIS_X, xdomain, nbins,
+                sorted_);
+        if (KDE_NONE != par.kde) { kde_.Update (data, AXIS_X, par.kde); }
     }
+    const std::vector< long >& bins = cache.Bins ();
+    FloatType lowx = cache.Domain ().Low ();
+    FloatType bin_width = cache.Domain ().Distance () / nbins;
+
+    ScopedTimer timer (Stats (), STAGE_DRAW);
+
+    GrabFocus ();
 
     /* TODO: 
      * FIXME:
@@ -575,9 +917,10 @@ void HistogramPlot::HistTop (const Dataset& data, const Parameters& par) {
     const Range& ydomain = p.ydomain;
 
     for (int n = 0; n < nbins; ++n) {
-        FloatType a = lowx + n * bin_width, b = lowx + (n + 1) * bin_width;
-        /* Only if the results fit in the selected xlimits */
-        if (xdomain.Contains (a) && xdomain.Contains (b)) {
+        /* cut at the selected xlimits */
+        FloatType a = std::max (lowx + n * bin_width, xdomain.Low ());
+        FloatType b = std::min (lowx + (n + 1) * bin_width, xdomain.High ());
+        if (a < b) {
             FloatType x1 = transform (a, xdomain, XRange ());
             FloatType x2 = transform (b, xdomain, XRange ());
             FloatType ratio = static_cast< FloatType >(bins[n]) / 
@@ -589,30 +932,31 @@ void HistogramPlot::HistTop (const Dataset& data, const Parameters& par) {
             al_draw_rectangle (x1, y1, x2, y2, col, 1.0);
         }
     }
+
+    Curve (AXIS_X, bin_width, xdomain, ydomain, par);
 }
 
 void HistogramPlot::HistLeft (const Dataset& data, const Parameters& par) {
 
-    Dataset::const_iterator DIT = data.Begin (),
-        DEND = data.End ();
-
     int nbins = par.nbins;
     const Range& ydomain = par.ydomain;
-    FloatType lowy = data.YDomain ().Low ();
-    FloatType bin_width = data.YDomain ().Distance () / nbins;
-    std::vector< long > bins(nbins);
     long bin_max = 0;
     ColorType col = mkcol (0, 0, 0, 255);
+    BinCache& cache = Cache (AXIS_Y, nbins);
 
-    GrabFocus ();
-
-    for (; DIT != DEND; ++DIT) {
-        int bin = static_cast< int >(floor ((DIT->Y () - lowy) / bin_width));
-        /* anything on the border gets placed in the final bin */
-        if (bin == nbins) { --bin; }
-        bins[bin]++;
-        bin_max = std::max (bin_max, bins[bin]);
+    {
+        ScopedTimer timer (Stats (), STAGE_COMPUTE);
+        bin_max = cache.Update (data, AXIS_Y, ydomain, nbins,
+                sorted_);
+        if (KDE_NONE != par.kde) { kde_.Update (data, AXIS_Y, par.kde); }
     }
+    const std::vector< long >& bins = cache.Bins ();
+    FloatType lowy = cache.Domain ().Low ();
+    FloatType bin_width = cache.Domain ().Distance () / nbins;
+
+    ScopedTimer timer (Stats (), STAGE_DRAW);
+
+    GrabFocus ();
 
     /* TODO: 
      * FIXME:
@@ -628,9 +972,10 @@ void HistogramPlot::HistLeft (const Dataset& data, const Parameters& par) {
     const Range& xdomain = p.xdomain;
 
     for (int n = 0; n < nbins; ++n) {
-        FloatType a = lowy + n * bin_width, b = lowy + (n + 1) * bin_width;
-        /* Only if the results fit in the selected ylimits */
-        if (ydomain.Contains (a) && ydomain.Contains (b)) {
+        /* cut at the selected ylimits */
+        FloatType a = std::max (lowy + n * bin_width, ydomain.Low ());
+        FloatType b = std::min (lowy + (n + 1) * bin_width, ydomain.High ());
+        if (a < b) {
             FloatType ratio = static_cast< FloatType >(bins[n]) / 
                 static_cast< FloatType >(data.Size ());
             FloatType x1 = transform (ratio, xdomain, XRange ());
@@ -642,10 +987,22 @@ void HistogramPlot::HistLeft (const Dataset& data, const Parameters& par) {
             al_draw_rectangle (x1, y1, x2, y2, col, 1.0);
         }
     }
+
+    Curve (AXIS_Y, bin_width, ydomain, xdomain, par);
+}
+
+void BoxPlot::Prepare (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("BoxPlot::Prepare");
+    ScopedTimer timer (Stats (), STAGE_COMPUTE);
+    Sorted ().Update (data, (VERTICAL == par.side) ? AXIS_Y : AXIS_X);
+    Spread ().Update (data);
 }
 
 void BoxPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
 void BoxPlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("BoxPlot::Plot");
+
+    Stats ().Points (data.Size ());
 
     switch (par.side) {
         case VERTICAL:
@@ -661,10 +1018,13 @@ void BoxPlot::Plot (const Dataset& data, const Parameters& par) {
 
 void BoxPlot::Vertical (const Dataset& data, const Parameters& par) {
 
-    std::vector< FloatType > ys;
+    ScopedTimer compute (Stats (), STAGE_COMPUTE);
+    const std::vector< FloatType >& ys = Sorted ().Update (data, AXIS_Y);
+    BoxPlotSummary bp(ys, true);
+    const Moments& moments = Spread ().Update (data).Y ();
+    compute.Stop ();
 
-    data.YData (ys);
-    BoxPlotSummary bp(ys);
+    ScopedTimer draw (Stats (), STAGE_DRAW);
 
     /*
      * Center on the viewport x-axis and have data dictate where
@@ -673,9 +1033,9 @@ void BoxPlot::Vertical (const Dataset& data, const Parameters& par) {
     FloatType clx = XRange ().Low () + XRange ().Distance () / 2.0;
     FloatType boxwidth = XRange ().Distance () / 20.0;
 
-    FloatType m = transform (bp.Median (), data.YDomain (), YRange ()),
-              uq = transform (bp.UpperQ (), data.YDomain (), YRange ()),
-              lq = transform (bp.LowerQ (), data.YDomain (), YRange ());
+    FloatType m = transform (bp.Median (), par.ydomain, YRange ()),
+              uq = transform (bp.UpperQ (), par.ydomain, YRange ()),
+              lq = transform (bp.LowerQ (), par.ydomain, YRange ());
 
     FloatType x1 = clx - boxwidth, x2 = clx + boxwidth;
 
@@ -689,28 +1049,39 @@ void BoxPlot::Vertical (const Dataset& data, const Parameters& par) {
      */
     al_draw_line (x1, m, x2,  m, par.col, 1.0);
 
+    if (0 < moments.Count ()) {
+        markMean (clx, transform (moments.Mean (), par.ydomain, YRange ()),
+                boxwidth / 2.0, par.col, 1.0);
+    }
+
     FloatType y = transform (bp.LowerBound (), par.ydomain, YRange ());
     al_draw_line (clx, y, clx, lq, par.col, 1.0);
     y = transform (bp.UpperBound (), par.ydomain, YRange ());
     al_draw_line (clx, uq, clx, y, par.col, 1.0);
 
-    /* Plot outliers */
+    /* Plot outliers, which being sorted are at either end */
     std::vector< FloatType >::const_iterator FIT = ys.begin (), 
         FEND = ys.end ();
+    for (; FIT != FEND && *FIT < bp.LowerBound (); ++FIT) {
+        y = transform (*FIT, par.ydomain, YRange ());
+        al_draw_circle (clx, y, 1.5 * par.rad, par.col, par.lwd);
+    }
+    FIT = std::upper_bound (FIT, FEND, bp.UpperBound ());
     for (; FIT != FEND; ++FIT) {
-        if (bp.Outlier (*FIT)) {
-            y = transform (*FIT, par.ydomain, YRange ());
-            al_draw_circle (clx, y, 1.5 * par.rad, par.col, par.lwd);
-        }
+        y = transform (*FIT, par.ydomain, YRange ());
+        al_draw_circle (clx, y, 1.5 * par.rad, par.col, par.lwd);
     }
 }
 
 void BoxPlot::Horizontal (const Dataset& data, const Parameters& par) {
 
-    std::vector< FloatType > xs;
+    ScopedTimer compute (Stats (), STAGE_COMPUTE);
+    const std::vector< FloatType >& xs = Sorted ().Update (data, AXIS_X);
+    BoxPlotSummary bp(xs, true);
+    const Moments& moments = Spread ().Update (data).X ();
+    compute.Stop ();
 
-    data.XData (xs);
-    BoxPlotSummary bp(xs);
+    ScopedTimer draw (Stats (), STAGE_DRAW);
 
     /*
      * Center on the viewport y-axis and have data dictate where
@@ -735,19 +1106,27 @@ void BoxPlot::Horizontal (const Dataset& data, const Parameters& par) {
      */
     al_draw_line (m, y1, m, y2, par.col, 1.0);
 
+    if (0 < moments.Count ()) {
+        markMean (transform (moments.Mean (), par.xdomain, XRange ()), cly,
+                boxheight / 2.0, par.col, 1.0);
+    }
+
     FloatType x = transform (bp.LowerBound (), par.xdomain, XRange ());
     al_draw_line (x, cly, lq, cly, par.col, 1.0);
     x = transform (bp.UpperBound (), par.xdomain, XRange ());
     al_draw_line (uq, cly, x, cly, par.col, 1.0);
 
-    /* Plot outliers */
+    /* Plot outliers, which being sorted are at either end */
     std::vector< FloatType >::const_iterator FIT = xs.begin (), 
         FEND = xs.end ();
+    for (; FIT != FEND && *FIT < bp.LowerBound (); ++FIT) {
+        x = transform (*FIT, par.xdomain, XRange ());
+        al_draw_circle (x, cly, 1.5 * par.rad, par.col, par.lwd);
+    }
+    FIT = std::upper_bound (FIT, FEND, bp.UpperBound ());
     for (; FIT != FEND; ++FIT) {
-        if (bp.Outlier (*FIT)) {
-            x = transform (*FIT, par.xdomain, XRange ());
-            al_draw_circle (x, cly, 1.5 * par.rad, par.col, par.lwd);
-        }
+        x = transform (*FIT, par.xdomain, XRange ());
+        al_draw_circle (x, cly, 1.5 * par.rad, par.col, par.lwd);
     }
 }
 
@@ -764,65 +1143,82 @@ HexBinPlot::AllValid (const std::vector< FloatType > &vs, RangeType which) {
     return true;
 }
 
-void HexBinPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
-void HexBinPlot::Plot (const Dataset& data, const Parameters& par) {
-
-    Range xrng = XRange (), yrng = YRange ();
-    FloatType dist = yrng.Distance ();
-    FloatType minx = xrng.Low (), maxx = xrng.High ();
-    FloatType miny = yrng.Low (), maxy = yrng.High ();
-    
+/* Size [hex] of the hexagons spanning [yrng] and half their width [b] */
+static void hexGeometry (const Range& yrng, FloatType& hex, FloatType& b) {
     /* TODO: for now, just use fixed number of bins */
     FloatType nbins = 30.0;
+    hex = yrng.Distance () / nbins;
+    b = sin (60.0 * M_PI / 180.0) * hex;
+}
 
-    FloatType hex = dist / nbins;
-    
-    FloatType xstep = 2 * sin (60.0 * M_PI / 180.0) * hex;
-    FloatType ystep = 1.5 * hex;
-    FloatType a = 0.5 * hex, b = sin (60.0 * M_PI / 180.0) * hex;
-    int z = 0;
-
-    FloatType width = 2 * b;
-    FloatType height = hex + a;
-
-    int nxbins = static_cast< int >(ceil (xrng.Distance () / width));
-    int nybins = static_cast< int >(ceil (yrng.Distance () / height));
-
-    std::vector< std::vector< int > > grid (nybins);
-    for (int i = 0; i < nybins; ++i) {
-        grid[i].resize (nxbins);
+void HexBinPlot::Prepare (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("HexBinPlot::Prepare");
+    ScopedTimer timer (Stats (), STAGE_COMPUTE);
+    FloatType hex = 0.0, b = 0.0;
+    hexGeometry (YRange (), hex, b);
+    cells_.Update (data, par.xdomain, par.ydomain, XRange (), YRange (), 
+            2 * b, 1.5 * hex, b);
+    if (! par.contours.empty ()) {
+        Spread ().Update (data);
+        Areas ().Update (data);
     }
+}
 
-    Dataset::const_iterator DIT = data.Begin (), DEND = data.End ();
-    int yidx = 0, xidx = 0, maxbin = 0;
-    for (; DIT != DEND; ++DIT) {
-        FloatType tx = transform (DIT->X (), par.xdomain, xrng);
-        FloatType ty = transform (DIT->Y (), par.ydomain, yrng);
+void HexBinPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
+void HexBinPlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("HexBinPlot::Plot");
 
-        /* Adjust for border offset surrounding viewport */
-        tx -= minx;
-        ty -= miny;
+    Stats ().Points (data.Size ());
+    ScopedTimer compute (Stats (), STAGE_COMPUTE);
 
-        yidx = static_cast< int >(ty / height);
-        if (0 == yidx % 2) {
-            if (tx > b) {
-                xidx = static_cast< int >((tx - b) / width);
-            } else {
-                xidx = 0;
-            }
-        } else {
-            xidx = static_cast< int >(tx / width);
-        }
+    Range xrng = XRange (), yrng = YRange ();
+    FloatType maxx = xrng.High ();
+    FloatType miny = yrng.Low (), maxy = yrng.High ();
+
+    FloatType hex = 0.0, b = 0.0;
+    hexGeometry (yrng, hex, b);
+
+    int maxbin = cells_.Update (data, par.xdomain, par.ydomain, xrng, yrng, 
+            2 * b, 1.5 * hex, b);
+    const std::vector< std::vector< int > >& grid = cells_.Grid ();
+    int yidx = 0, xidx = 0, z = 0;
+
+    /* the cells as counted, placed and scaled in the viewport as it is now */
+    FloatType x0 = 0.0, y0 = 0.0, xspan = 0.0, yspan = 0.0;
+    cells_.Place (par.xdomain, par.ydomain, xrng, yrng, x0, y0, xspan, yspan);
+    FloatType xstep = cells_.Width () * xspan;
+    FloatType ystep = cells_.Height () * yspan;
+    b = cells_.Offset () * xspan;
+    hex = ystep / 1.5;
+    FloatType a = 0.5 * hex;
+
+    /* every cell colored in one pass, rows laid end to end */
+    std::vector< std::size_t > rows (grid.size () + 1, 0);
+    for (std::size_t r = 0; r < grid.size (); ++r) {
+        rows[r + 1] = rows[r] + grid[r].size ();
+    }
+    counts_.resize (rows.back ());
+    for (std::size_t r = 0; r < grid.size (); ++r) {
+        std::copy (grid[r].begin (), grid[r].end (), counts_.begin () + rows[r]);
+    }
+    Colormap::Get (par.cmap).Map (counts_, std::max (maxbin, 0), par.cscale,
+            colors_);
 
-        grid[yidx][xidx] += 1;
-        maxbin = std::max (maxbin, grid[yidx][xidx]);
+    const std::vector< Line > *contours = NULL;
+    if (! par.contours.empty ()) {
+        contours = &densityContours (contours_, Areas ().Update (data),
+                Spread ().Update (data).XY (), xrng, yrng, par);
     }
 
-    ColorType cool = mkcol (255, 255, 255, 8);
-    ColorType hot = mkcol (255, 255, 255, 255);
+    compute.Stop ();
+    ScopedTimer draw (Stats (), STAGE_DRAW);
 
     xidx = yidx = 0;
-    for (FloatType y = miny + a; y < maxy; y += ystep, ++z, ++yidx) {
+    for (FloatType y = y0 + a; y < maxy && yidx < static_cast< int >(
+                grid.size ()); y += ystep, ++z, ++yidx) {
+
+        /* rows of the padding above the viewport */
+        if (y + hex + a < miny) { continue; }
 
         FloatType xoff = ((1 == z % 2) ? b : 0.0);
         std::vector< FloatType > ys = { y, y + hex, y + hex + a, y - a };
@@ -830,7 +1226,8 @@ void HexBinPlot::Plot (const Dataset& data, const Parameters& par) {
         if (! AllValid (ys, RANGE_Y)) { continue; }
 
         xidx = 0;
-        for (FloatType x = minx + xoff; x < maxx - xstep; x += xstep, ++xidx) {
+        for (FloatType x = x0 + xoff; x < maxx - xstep && xidx < 
+                static_cast< int >(grid[yidx].size ()); x += xstep, ++xidx) {
 
             std::vector< FloatType > xs = { x, x + b, x + xstep };
             int cnt = grid[yidx][xidx];
@@ -841,9 +1238,7 @@ void HexBinPlot::Plot (const Dataset& data, const Parameters& par) {
             if (AllValid (xs, RANGE_X)) {
 
                 ALLEGRO_VERTEX v[7];
-                FloatType alpha = static_cast< FloatType >(cnt) / 
-                        static_cast< FloatType >(maxbin);
-                ColorType col = gradient (cool, hot, alpha);
+                ColorType col = colors_[rows[yidx] + xidx];
 
                 memset (v, 0, sizeof (ALLEGRO_VERTEX) * 7);
 
@@ -877,15 +1272,80 @@ void HexBinPlot::Plot (const Dataset& data, const Parameters& par) {
             }
         }
     }
+
+    if (NULL != contours) {
+        Parameters lines = par;
+        lines.col = par.font_col;
+        Lines (*contours, lines);
+    }
+}
+
+void HeatmapPlot::Prepare (const Dataset& data, const Parameters&) {
+    TRACE_SCOPE ("HeatmapPlot::Prepare");
+    ScopedTimer timer (Stats (), STAGE_COMPUTE);
+    Table ().Update (data);
+}
+
+void HeatmapPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
+void HeatmapPlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("HeatmapPlot::Plot");
+
+    Stats ().Points (data.Size ());
+    ScopedTimer compute (Stats (), STAGE_COMPUTE);
+
+    Range xrng = XRange (), yrng = YRange ();
+    int ncols = std::max (1, par.nbins);
+    FloatType side = xrng.Distance () / ncols;
+    int nrows = std::max (1, static_cast< int >(
+                floor (yrng.Distance () / side + 0.5)));
+
+    FloatType most = Table ().Update (data).Bins (par.xdomain, par.ydomain,
+            ncols, nrows, bins_);
+    Colormap::Get (par.cmap).Map (bins_, most, par.cscale, colors_);
+
+    compute.Stop ();
+    ScopedTimer draw (Stats (), STAGE_DRAW);
+
+    if (! (most > 0.0)) { return; }
+
+    const Range& xd = par.xdomain;
+    const Range& yd = par.ydomain;
+    FloatType dx = xd.Distance () / ncols, dy = yd.Distance () / nrows;
+
+    GrabFocus ();
+
+    /* bins run from the low corner of the limits */
+    for (int r = 0; r < nrows; ++r) {
+        FloatType y1 = transform (yd.Low () + r * dy, yd, yrng);
+        FloatType y2 = transform (yd.Low () + (r + 1) * dy, yd, yrng);
+        for (int c = 0; c < ncols; ++c) {
+            FloatType cnt = bins_[r * ncols + c];
+            if (! (cnt > 0.0)) { continue; }
+            FloatType x1 = transform (xd.Low () + c * dx, xd, xrng);
+            FloatType x2 = transform (xd.Low () + (c + 1) * dx, xd, xrng);
+            al_draw_filled_rectangle (x1, y1, x2, y2, colors_[r * ncols + c]);
+        }
+    }
+}
+
+void LinePlot::Prepare (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("LinePlot::Prepare");
+    ScopedTimer timer (Stats (), STAGE_COMPUTE);
+    if (par.fit > 0) { Regression ().Update (data); }
+    if (par.fit > 0 && CORR_SPEARMAN == par.corr) { ranks_.Update (data); }
 }
 
 void LinePlot::Plot (const Dataset& data) { Plot (data, Par ()); }
 void LinePlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("LinePlot::Plot");
 
     if (data.Size () < 2) { 
         throw NotEnoughData ("LinePlot needs at least two points");
     }
 
+    Stats ().Points (data.Size ());
+    ScopedTimer compute (Stats (), STAGE_COMPUTE);
+
     std::vector< Line > lines;
     Dataset::const_iterator DIT = data.Begin (), DEND = data.End ();
     FloatType x1 = DIT->X (), y1 = DIT->Y ();
@@ -898,6 +1358,279 @@ void LinePlot::Plot (const Dataset& data, const Parameters& par) {
         x1 = x2;
         y1 = y2;
     }
+
+    Polynomial fit;
+    FloatType r = NAN;
+    if (par.fit > 0) {
+        const PowerSums& sums = Regression ().Update (data);
+        fit = sums.Fit (par.fit);
+        r = (CORR_SPEARMAN == par.corr) ?
+            ranks_.Update (data) : sums.Correlation ();
+    }
+
+    compute.Stop ();
+    ScopedTimer draw (Stats (), STAGE_DRAW);
     Lines (lines, par);
+    Fit (fit, r, par);
 }
 
+
+/* Two triangles covering [x1, x2] x [y1, y2] */
+static void quad (std::vector< ALLEGRO_VERTEX >& v, FloatType x1, FloatType y1,
+        FloatType x2, FloatType y2, ColorType col) {
+    FloatType xs[6] = { x1, x2, x2, x1, x2, x1 };
+    FloatType ys[6] = { y1, y1, y2, y1, y2, y2 };
+    for (int i = 0; i < 6; ++i) {
+        ALLEGRO_VERTEX p;
+        memset (&p, 0, sizeof (p));
+        p.x = static_cast< float >(xs[i]);
+        p.y = static_cast< float >(ys[i]);
+        p.color = col;
+        v.push_back (p);
+    }
+}
+
+SplomPlot::~SplomPlot () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+void SplomPlot::Columns (const Table *table, const std::vector< int >& columns) {
+    table_ = table;
+    columns_ = columns;
+}
+
+void SplomPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
+void SplomPlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("SplomPlot::Plot");
+
+    ScopedTimer compute (Stats (), STAGE_COMPUTE);
+
+    std::vector< SplomColumn > columns;
+    std::vector< std::string > names;
+    if (NULL != table_ && ! columns_.empty ()) {
+        std::vector< int >::const_iterator CIT = columns_.begin (),
+            CEND = columns_.end ();
+        for (; CIT != CEND; ++CIT) {
+            if (! table_->Loaded (*CIT)) { continue; }
+            const std::vector< FloatType >& xs = table_->Column (*CIT);
+            columns.push_back (SplomColumn (xs.data (), xs.size (), 
+                        table_->Domain (*CIT)));
+            names.push_back (table_->Name (*CIT));
+        }
+    } else {
+        if (&data != data_ || stale_) {
+            if (&data != data_) {
+                if (NULL != data_) { data_->Detach (this); }
+                data_ = &data;
+                data_->Attach (this);
+            }
+            stale_ = false;
+
+            /* the ring is not stored by column; NaN is kept to pair rows */
+            Dataset::const_iterator DIT = data.Begin (), DEND = data.End ();
+            xs_.clear ();
+            ys_.clear ();
+            xs_.reserve (data.Size ());
+            ys_.reserve (data.Size ());
+            for (; DIT != DEND; ++DIT) {
+                xs_.push_back (DIT->X ());
+                ys_.push_back (DIT->Y ());
+            }
+            splom_.Invalidate ();
+        }
+        columns.push_back (SplomColumn (xs_.data (), xs_.size (), data.XDomain ()));
+        columns.push_back (SplomColumn (ys_.data (), ys_.size (), data.YDomain ()));
+        names.push_back ("X");
+        names.push_back ("Y");
+    }
+
+    int k = static_cast< int >(columns.size ());
+    FloatType gap = 4.0;
+    FloatType left = XRange ().Low ();
+    FloatType top = std::min (YRange ().Low (), YRange ().High ());
+    FloatType width = (XRange ().Distance () - gap * (k - 1)) / k;
+    FloatType height = (YRange ().Distance () - gap * (k - 1)) / k;
+    if (0 == k || width < 1.0 || height < 1.0) { return; }
+
+    /*
+     * a cell per pixel of the smaller panel side, though a resize that
+     * keeps within a factor of 1.5 of that draws the cells it has
+     */
+    int cells = splom_.Cells ();
+    int want = static_cast< int >(std::min (width, height));
+    if (0 == cells || 2 * want > 3 * cells || 3 * want < 2 * cells) {
+        cells = want;
+    }
+    splom_.Update (columns, cells, par.nbins);
+    cells = splom_.Cells ();
+    Stats ().Points (splom_.Rows ());
+
+    compute.Stop ();
+    ScopedTimer draw (Stats (), STAGE_DRAW);
+
+    GrabFocus ();
+
+    FloatType cw = width / cells, ch = height / cells;
+    bool dots = cw <= 1.5 && ch <= 1.5;
+    std::vector< ALLEGRO_VERTEX > points, tris;
+    std::vector< ColorType > colors;
+    const Colormap& cmap = Colormap::Get (par.cmap);
+
+    for (int i = 0; i < k; ++i) {
+        FloatType y0 = top + i * (height + gap);
+        for (int j = 0; j < k; ++j) {
+            FloatType x0 = left + j * (width + gap);
+
+            if (i == j) {
+                const std::vector< long >& hist = splom_.Histogram (i);
+                FloatType hmax = std::max (splom_.HistogramMax (i), 1L);
+                FloatType bw = width / std::max (hist.size (), std::size_t (1));
+                for (std::size_t b = 0; b < hist.size (); ++b) {
+                    if (0 == hist[b]) { continue; }
+                    FloatType h = (height - 1.0) * hist[b] / hmax;
+                    quad (tris, x0 + b * bw, y0 + height - h, 
+                            x0 + (b + 1) * bw, y0 + height, par.fill);
+                }
+                continue;
+            }
+
+            /* row i has column i up, column j across */
+            int a = std::min (i, j), b = std::max (i, j);
+            const std::vector< unsigned int >& grid = splom_.Panel (a, b);
+            /* panels mix sparse and dense pairs: always on a log scale */
+            cmap.Map (grid, splom_.PanelMax (a, b), SCALE_LOG, colors);
+            for (std::size_t g = 0; g < grid.size (); ++g) {
+                if (0 == grid[g]) { continue; }
+                int u = g / cells, v = g % cells;
+                int xc = (j < i) ? u : v, yc = (j < i) ? v : u;
+                FloatType x = x0 + xc * cw, y = y0 + height - (yc + 1) * ch;
+                ColorType col = colors[g];
+                if (dots) {
+                    ALLEGRO_VERTEX p;
+                    memset (&p, 0, sizeof (p));
+                    p.x = static_cast< float >(x + 0.5);
+                    p.y = static_cast< float >(y + 0.5);
+                    p.color = col;
+                    points.push_back (p);
+                } else {
+                    quad (tris, x, y, x + cw, y + ch, col);
+                }
+            }
+        }
+    }
+
+    if (! points.empty ()) {
+        al_draw_prim (points.data (), NULL, NULL, 0, points.size (), 
+                ALLEGRO_PRIM_POINT_LIST);
+    }
+    if (! tris.empty ()) {
+        al_draw_prim (tris.data (), NULL, NULL, 0, tris.size (), 
+                ALLEGRO_PRIM_TRIANGLE_LIST);
+    }
+
+    for (int i = 0; i < k; ++i) {
+        FloatType y0 = top + i * (height + gap);
+        for (int j = 0; j < k; ++j) {
+            FloatType x0 = left + j * (width + gap);
+            al_draw_rectangle (x0, y0, x0 + width, y0 + height, par.col, 
+                    par.lwd);
+        }
+        al_draw_text (par.font, par.font_col, left + i * (width + gap) + 2.0,
+                y0 + 2.0, ALIGN_LEFT, names[i].c_str ());
+    }
+}
+
+CorrelationPlot::~CorrelationPlot () {
+    if (NULL != data_) { data_->Detach (this); }
+}
+
+void CorrelationPlot::Columns (const Table *table,
+        const std::vector< int >& columns) {
+    table_ = table;
+    columns_ = columns;
+}
+
+void CorrelationPlot::Plot (const Dataset& data) { Plot (data, Par ()); }
+void CorrelationPlot::Plot (const Dataset& data, const Parameters& par) {
+    TRACE_SCOPE ("CorrelationPlot::Plot");
+
+    ScopedTimer compute (Stats (), STAGE_COMPUTE);
+
+    std::vector< const std::vector< FloatType > * > columns;
+    std::vector< std::string > names;
+    if (NULL != table_ && ! columns_.empty ()) {
+        std::vector< int >::const_iterator CIT = columns_.begin (),
+            CEND = columns_.end ();
+        for (; CIT != CEND; ++CIT) {
+            if (! table_->Loaded (*CIT)) { continue; }
+            columns.push_back (&table_->Column (*CIT));
+            names.push_back (table_->Name (*CIT));
+        }
+        Stats ().Points (table_->Rows ());
+    } else {
+        if (&data != data_ || stale_) {
+            if (&data != data_) {
+                if (NULL != data_) { data_->Detach (this); }
+                data_ = &data;
+                data_->Attach (this);
+            }
+            stale_ = false;
+
+            /* the ring is not stored by column; NaN is kept to pair rows */
+            Dataset::const_iterator DIT = data.Begin (), DEND = data.End ();
+            xs_.clear ();
+            ys_.clear ();
+            xs_.reserve (data.Size ());
+            ys_.reserve (data.Size ());
+            for (; DIT != DEND; ++DIT) {
+                xs_.push_back (DIT->X ());
+                ys_.push_back (DIT->Y ());
+            }
+            matrix_.Invalidate ();
+        }
+        columns.push_back (&xs_);
+        columns.push_back (&ys_);
+        names.push_back ("X");
+        names.push_back ("Y");
+        Stats ().Points (data.Size ());
+    }
+    matrix_.Update (columns, par.corr);
+
+    compute.Stop ();
+    ScopedTimer draw (Stats (), STAGE_DRAW);
+
+    int k = matrix_.Columns ();
+    FloatType gap = 2.0;
+    FloatType left = XRange ().Low ();
+    FloatType top = std::min (YRange ().Low (), YRange ().High ());
+    FloatType width = (XRange ().Distance () - gap * (k - 1)) / k;
+    FloatType height = (YRange ().Distance () - gap * (k - 1)) / k;
+    if (0 == k || width < 1.0 || height < 1.0) { return; }
+
+    GrabFocus ();
+
+    /* a signed measure, so always on the diverging map */
+    const Colormap& cmap = Colormap::Get (CMAP_DIVERGING);
+    char label[16];
+    for (int i = 0; i < k; ++i) {
+        FloatType y0 = top + i * (height + gap);
+        for (int j = 0; j < k; ++j) {
+            FloatType x0 = left + j * (width + gap);
+            FloatType r = matrix_.At (i, j);
+            if (r == r) {
+                al_draw_filled_rectangle (x0, y0, x0 + width, y0 + height,
+                        cmap.At ((r + 1.0) / 2.0));
+                snprintf (label, sizeof (label), "%.2f", r);
+                if (al_get_text_width (par.font, label) < width) {
+                    al_draw_text (par.font, par.font_col, x0 + width / 2.0,
+                            y0 + (height - par.font_px) / 2.0, ALIGN_CENTER,
+                            label);
+                }
+            }
+            al_draw_rectangle (x0, y0, x0 + width, y0 + height, par.col,
+                    par.lwd);
+        }
+        al_draw_text (par.font, par.font_col, left + i * (width + gap) + 2.0,
+                y0 + 2.0, ALIGN_LEFT, names[i].c_str ());
+    }
+}
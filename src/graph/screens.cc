@@ -0,0 +1,144 @@
+
+#include <graph/screens.h>
+#include <graph/exceptions.h>
+
+/* Offset of each round of windows tiled over the last */
+#define SCREEN_CASCADE 32
+
+Screens::~Screens () {
+    for (int i = Slots () - 1; i >= 0; --i) {
+        Close (i);
+    }
+}
+
+void Screens::Displays (int width, int height, int right, int bottom) {
+    width_ = width;
+    height_ = height;
+    right_ = right;
+    bottom_ = bottom;
+    offscreen_ = false;
+}
+
+void Screens::Offscreen (int width, int height) {
+    width_ = width;
+    height_ = height;
+    offscreen_ = true;
+}
+
+void Screens::Listen (ALLEGRO_EVENT_QUEUE *queue) {
+    for (int i = 0; i < Slots (); ++i) {
+        if (! Valid (i) || NULL == views_[i]->display) { continue; }
+        ALLEGRO_EVENT_SOURCE *source = 
+            al_get_display_event_source (views_[i]->display);
+        if (NULL != queue_) { al_unregister_event_source (queue_, source); }
+        if (NULL != queue) { al_register_event_source (queue, source); }
+    }
+    queue_ = queue;
+}
+
+/*
+ * Windows go in the quarters of the monitor clockwise from the top
+ * right, then the next four likewise a little up and to the left
+ */
+void Screens::Place (int i) {
+    static const int cols[] = { 1, 1, 2, 2 };
+    static const int rows[] = { 2, 1, 1, 2 };
+    int shift = (i / 4) * SCREEN_CASCADE;
+    al_set_window_position (views_[i]->display,
+            right_ - cols[i % 4] * width_ - shift,
+            bottom_ - rows[i % 4] * height_ - shift);
+}
+
+int Screens::Open () {
+
+    int i = 0;
+    while (i < Slots () && NULL != views_[i]) { ++i; }
+
+    View view = { NULL, NULL, NULL, 0, false };
+    if (offscreen_) {
+        int flags = al_get_new_bitmap_flags ();
+        al_set_new_bitmap_flags (ALLEGRO_MEMORY_BITMAP);
+        view.target = al_create_bitmap (width_, height_);
+        al_set_new_bitmap_flags (flags);
+        if (NULL == view.target) {
+            throw GeneralException ("Failed to create offscreen target",
+                    __FILE__, __LINE__);
+        }
+    } else {
+        view.display = al_create_display (width_, height_);
+        if (NULL == view.display) {
+            throw GeneralException ("Failed to create display",
+                    __FILE__, __LINE__);
+        }
+        index_[view.display] = i;
+        if (NULL != queue_) {
+            al_register_event_source (queue_,
+                    al_get_display_event_source (view.display));
+        }
+    }
+
+    if (i == Slots ()) {
+        views_.push_back (NULL);
+    }
+    views_[i] = new View (view);
+    ++open_;
+    if (NULL != view.display) { Place (i); }
+    return i;
+}
+
+void Screens::Close (int i) {
+
+    if (! Valid (i)) { return; }
+
+    View *view = views_[i];
+    views_[i] = NULL;
+    --open_;
+    while (! views_.empty () && NULL == views_.back ()) {
+        views_.pop_back ();
+    }
+
+    delete view->plot;
+    if (NULL != view->display) {
+        index_.erase (view->display);
+        if (NULL != queue_) {
+            al_unregister_event_source (queue_,
+                    al_get_display_event_source (view->display));
+        }
+        al_destroy_display (view->display);
+    }
+    if (NULL != view->target) {
+        al_destroy_bitmap (view->target);
+    }
+    delete view;
+}
+
+void Screens::Resize (int i) {
+    if (! Valid (i)) { return; }
+    View& view = *views_[i];
+    if (NULL != view.display) {
+        al_acknowledge_resize (view.display);
+    }
+    if (NULL != view.plot) {
+        view.plot->Resize ();
+    }
+    view.stale = true;
+}
+
+int Screens::Find (ALLEGRO_DISPLAY *display) const {
+    if (NULL == display) { return -1; }
+    std::unordered_map< ALLEGRO_DISPLAY *, int >::const_iterator IIT =
+        index_.find (display);
+    return (index_.end () == IIT) ? -1 : IIT->second;
+}
+
+int Screens::Width (int i) const {
+    const View& view = *views_[i];
+    return (NULL != view.display) ? al_get_display_width (view.display) :
+        al_get_bitmap_width (view.target);
+}
+
+int Screens::Height (int i) const {
+    const View& view = *views_[i];
+    return (NULL != view.display) ? al_get_display_height (view.display) :
+        al_get_bitmap_height (view.target);
+}
@@ -141,70 +141,37 @@ std::vector< FloatType > prettyTicks (const Range& range, int ndiv) {
 }
 
 
-Line lineclip (const Range& xlim, const Range& ylim, const Line& line) {
+bool lineclip (const Range& xlim, const Range& ylim, Line& line) {
 
     /* Liang-Barsky Clipping */
-    FloatType xmin = xlim.X (),
-              xmax = xlim.Y (),
-              ymin = ylim.X (),
-              ymax = ylim.Y ();
     FloatType x1 = line.Start ().X (),
               y1 = line.Start ().Y (),
               x2 = line.End ().X (),
               y2 = line.End ().Y ();
-    FloatType p1 = -(x2 - x1),
-              p2 = -p1,
-              p3 = -(y2 - y1),
-              p4 = -p3;
-    FloatType q1 = x1 - xmin,
-              q2 = xmax - x1,
-              q3 = y1 - ymin,
-              q4 = ymax - y1;
-
-    FloatType posarr[5] = {0.0}, negarr[5] = {0.0};
-    int posind = 1, negind = 1;
-
-    posarr[0] = 1.0;
-    negarr[0] = 0.0;
-
-    /* Parallel to window boundary */
-    if ((p1 == 0 && q1 < 0) || (p3 == 0 && q3 < 0)) { 
-        return line;  /* TODO: fix this */
-    }
-
-    if (p1 != 0) {
-        FloatType r1 = q1 / p1;
-        FloatType r2 = q2 / p2;
-        if (p1 < 0) {
-            negarr[negind++] = r1; 
-            posarr[posind++] = r2;
-        } else {
-            negarr[negind++] = r2;
-            posarr[posind++] = r1;
+    if (x1 != x1 || y1 != y1 || x2 != x2 || y2 != y2) { return false; }
+
+    FloatType dx = x2 - x1, dy = y2 - y1;
+    FloatType p[4] = { -dx, dx, -dy, dy };
+    FloatType q[4] = { x1 - xlim.Low (), xlim.High () - x1,
+                       y1 - ylim.Low (), ylim.High () - y1 };
+    FloatType t1 = 0.0, t2 = 1.0;
+
+    for (int i = 0; i < 4; ++i) {
+        if (0.0 == p[i]) {
+            /* parallel to this boundary and outside it */
+            if (q[i] < 0.0) { return false; }
+            continue;
         }
-    }
-
-    if (p3 != 0) {
-        FloatType r3 = q3 / p3;
-        FloatType r4 = q4 / p4;
-        if (p3 < 0) {
-            negarr[negind++] = r3;
-            posarr[posind++] = r4;
+        FloatType r = q[i] / p[i];
+        if (p[i] < 0.0) {
+            t1 = std::max (t1, r);
         } else {
-            negarr[negind++] = r4;
-            posarr[posind++] = r3;
+            t2 = std::min (t2, r);
         }
     }
+    if (t1 > t2) { return false; }
 
-    FloatType rn1 = *std::max_element (negarr, negarr + negind);
-    FloatType rn2 = *std::min_element (posarr, posarr + posind);
-
-    FloatType xn1 = x1 + p2 * rn1;
-    FloatType yn1 = y1 + p4 * rn1; 
-    FloatType xn2 = x1 + p2 * rn2;
-    FloatType yn2 = y1 + p4 * rn2;
-
-    Point a(xn1, yn1);
-    Point b(xn2, yn2);
-    return Line(a,b);
+    line = Line (Point (x1 + t1 * dx, y1 + t1 * dy),
+            Point (x1 + t2 * dx, y1 + t2 * dy));
+    return true;
 }
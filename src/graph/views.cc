@@ -0,0 +1,259 @@
+
+#include <cstring>
+#include <graph/views.h>
+#include <graph/facets.h>
+#include <graph/util.h>
+#include <perf/hud.h>
+
+const char * plottype2str (int type) {
+    switch (type) {
+        case PLOT_SCATTER: return "scatter";
+        case PLOT_BOX_H: return "box_h";
+        case PLOT_BOX_V: return "box_v";
+        case PLOT_HIST_L: return "hist_l";
+        case PLOT_HIST_R: return "hist_r";
+        case PLOT_HIST_B: return "hist_b";
+        case PLOT_HIST_T: return "hist_t";
+        case PLOT_HEXBIN: return "hexbin";
+        case PLOT_LINE: return "line";
+        case PLOT_ECDF_H: return "ecdf_h";
+        case PLOT_ECDF_V: return "ecdf_v";
+        case PLOT_SPLOM: return "splom";
+        case PLOT_FACETS: return "facets";
+        case PLOT_HEATMAP: return "heatmap";
+        case PLOT_CORRELATION: return "correlation";
+        default: return "MISSING PLOT CASE";
+    }
+    return "PLOT SWITCH FAIL";
+}
+
+int str2plottype (const char *name) {
+    for (int type = 0; type < MAX_PLOT; ++type) {
+        if (0 == strcmp (name, plottype2str (type))) {
+            return type;
+        }
+    }
+    return -1;
+}
+
+template < typename TargetType >
+static BasicPlot * make_plot (int type, TargetType *target) {
+    switch (type) {
+        case PLOT_SCATTER: return new ScatterPlot (target);
+        case PLOT_BOX_H: return new BoxPlot (target);
+        case PLOT_BOX_V: return new BoxPlot (target);
+        case PLOT_HIST_L: return new HistogramPlot (target);
+        case PLOT_HIST_R: return new HistogramPlot (target);
+        case PLOT_HIST_T: return new HistogramPlot (target);
+        case PLOT_HIST_B: return new HistogramPlot (target);
+        case PLOT_HEXBIN: return new HexBinPlot (target);
+        case PLOT_LINE: return new LinePlot (target);
+        case PLOT_ECDF_H: return new ECDFPlot (target);
+        case PLOT_ECDF_V: return new ECDFPlot (target);
+        case PLOT_SPLOM: return new SplomPlot (target);
+        case PLOT_FACETS: return new FacetPlot (target);
+        case PLOT_HEATMAP: return new HeatmapPlot (target);
+        case PLOT_CORRELATION: return new CorrelationPlot (target);
+        default:
+            throw GeneralException("Unknown plot type", __FILE__, __LINE__);
+    }
+    return NULL;
+}
+
+BasicPlot * new_plot (int type, ALLEGRO_DISPLAY *win) {
+    return make_plot (type, win);
+}
+
+BasicPlot * new_plot (int type, ALLEGRO_BITMAP *bmp) {
+    return make_plot (type, bmp);
+}
+
+void draw_plot (BasicPlot *plot, int type, const Dataset& data,
+        FloatType minx, FloatType maxx, FloatType miny, FloatType maxy,
+        bool hud) {
+
+    Parameters par;
+
+    /* nothing streamed in yet */
+    if (0 == data.Size ()) {
+        plot->Clear ();
+        plot->Title ("Waiting for data");
+        plot->Update ();
+        return;
+    }
+
+    switch (type) {
+        case PLOT_SCATTER:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->Grid ();
+            plot->Plot (data);
+            plot->XTicks ();
+            plot->YTicks ();
+            plot->XLabel ("ScatterPlot X Data");
+            plot->YLabel ("Y Data");
+            plot->Box ();
+            break;
+        case PLOT_BOX_H:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->Title ("Boxplot H Title\nA second line");
+            plot->XGrid ();
+            par = plot->Par ();
+            par.side = HORIZONTAL;
+            plot->Plot (data, par);
+            plot->XTicks ();
+            plot->XLabel ("BoxPlot (H) X Data");
+            plot->YLabel ("Y Data");
+            plot->Box ();
+            break;
+        case PLOT_BOX_V:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->YGrid ();
+            par = plot->Par ();
+            par.side = VERTICAL;
+            plot->Plot (data, par);
+            plot->YTicks ();
+            plot->XLabel ("BoxPlot (V) X Data");
+            plot->YLabel ("Y Data");
+            plot->Box ();
+            break;
+        case PLOT_HIST_L:
+            plot->Xlim (0.0, 1.0);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->XGrid ();
+            par = plot->Par ();
+            par.side = SIDE_LEFT;
+            plot->Plot (data, par);
+            plot->XTicks ();
+            plot->XLabel ("Hist (L) X Data");
+            plot->YLabel ("Y Data");
+            plot->Box ();
+            break;
+        case PLOT_HIST_R:
+            plot->Xlim (1.0, 0.0);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->XGrid ();
+            par = plot->Par ();
+            par.side = SIDE_RIGHT;
+            plot->Plot (data, par);
+            plot->XTicks ();
+            plot->XLabel ("Hist (R) X Data");
+            plot->YTicks (par);
+            plot->Box ();
+            break;
+        case PLOT_HIST_T:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (1.0, 0.0);
+            plot->Clear ();
+            plot->YGrid ();
+            par = plot->Par ();
+            par.side = SIDE_TOP;
+            plot->Plot (data, par);
+            plot->YTicks ();
+            par.side = SIDE_TOP;
+            plot->XTicks (par);
+            plot->XLabel ("Hist (T) X Data");
+            plot->Box ();
+            break;
+        case PLOT_HIST_B:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (0, 1.0);
+            plot->Clear ();
+            plot->YGrid ();
+            par = plot->Par ();
+            par.side = SIDE_BOTTOM;
+            plot->Plot (data, par);
+            plot->YTicks ();
+            plot->XTicks ();
+            plot->XLabel ("Hist (B) X Data");
+            plot->Box ();
+            break;
+        case PLOT_HEXBIN:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->Plot (data);
+            plot->YTicks ();
+            plot->XTicks ();
+            plot->XLabel ("X Data");
+            plot->YLabel ("Y Data");
+            plot->Title ("Example Hexbin Data\nMultiple Modes");
+            plot->Box ();
+            break;
+        case PLOT_HEATMAP:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->Plot (data);
+            plot->YTicks ();
+            plot->XTicks ();
+            plot->XLabel ("X Data");
+            plot->YLabel ("Y Data");
+            plot->Box ();
+            break;
+        case PLOT_LINE:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->XGrid ();
+            plot->YGrid ();
+            plot->Plot (data);
+            plot->XTicks ();
+            plot->YTicks ();
+            plot->XLabel ("LinePlot X Data");
+            plot->Box ();
+            break;
+        case PLOT_ECDF_H:
+            plot->Xlim (miny, maxy);
+            plot->Clear ();
+            plot->Plot (data);
+            plot->YTicks ();
+            plot->XTicks ();
+            plot->XLabel ("ECDF Y Data");
+            plot->Box ();
+            break;
+        case PLOT_ECDF_V:
+            plot->Ylim (minx, maxx);
+            plot->Clear ();
+            par = plot->Par ();
+            par.side = VERTICAL;
+            plot->Plot (data, par);
+            plot->YTicks ();
+            plot->XTicks ();
+            plot->YLabel ("ECDF X Data");
+            plot->Box ();
+            break;
+        case PLOT_SPLOM:
+            plot->Clear ();
+            plot->Plot (data);
+            plot->Title ("Scatterplot Matrix");
+            break;
+        case PLOT_CORRELATION:
+            plot->Clear ();
+            plot->Plot (data);
+            plot->Title ("Correlation Matrix");
+            break;
+        case PLOT_FACETS:
+            plot->Xlim (minx, maxx);
+            plot->Ylim (miny, maxy);
+            plot->Clear ();
+            plot->Plot (data);
+            plot->XLabel ("X Data");
+            plot->YLabel ("Y Data");
+            break;
+        default:
+            throw GeneralException("Unknown plot type", __FILE__, __LINE__);
+    }
+
+    if (hud) {
+        plot->Overlay (hudLines (plot->Stats ()));
+    }
+    plot->Update ();
+}
@@ -0,0 +1,201 @@
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <zmq.h>
+#include <net/control.h>
+#include <net/ingest.h>
+#include <perf/stats.h>
+
+/* How often the receiver checks for Stop () */
+#define CONTROL_POLL_MS 100
+
+Control::Control () : ctx_(NULL), sock_(NULL), running_(false), 
+    signalled_(false) {
+    al_init_user_event_source (&source_);
+}
+
+Control::~Control () {
+    Stop ();
+    al_destroy_user_event_source (&source_);
+}
+
+bool Control::Start (const char *endpoint) {
+
+    if (running_) { return false; }
+
+    if (! localEndpoint (endpoint)) {
+        fprintf (stderr, "%s: only ipc, inproc or tcp on localhost "
+                "are accepted\n", endpoint);
+        return false;
+    }
+
+    ctx_ = zmq_ctx_new ();
+    sock_ = zmq_socket (ctx_, ZMQ_REP);
+    if (NULL == sock_) {
+        fprintf (stderr, "%s: %s\n", endpoint, zmq_strerror (zmq_errno ()));
+        Stop ();
+        return false;
+    }
+
+    int timeout = CONTROL_POLL_MS, linger = 0;
+    zmq_setsockopt (sock_, ZMQ_RCVTIMEO, &timeout, sizeof (timeout));
+    zmq_setsockopt (sock_, ZMQ_LINGER, &linger, sizeof (linger));
+
+    if (0 != zmq_bind (sock_, endpoint)) {
+        fprintf (stderr, "%s: %s\n", endpoint, zmq_strerror (zmq_errno ()));
+        Stop ();
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread (&Control::Receive, this);
+    return true;
+}
+
+void Control::Stop () {
+
+    {
+        std::lock_guard< std::mutex > guard (lock_);
+        running_ = false;
+    }
+    replied_.notify_all ();
+    if (thread_.joinable ()) {
+        thread_.join ();
+    }
+
+    /* requests belong to the (now finished) receiver */
+    pending_.clear ();
+
+    if (NULL != sock_) {
+        zmq_close (sock_);
+        sock_ = NULL;
+    }
+    if (NULL != ctx_) {
+        zmq_ctx_term (ctx_);
+        ctx_ = NULL;
+    }
+}
+
+void Control::Receive () {
+
+    traceThreadName ("control");
+
+    char buff[1024];
+    while (running_) {
+
+        int n = zmq_recv (sock_, buff, sizeof (buff) - 1, 0);
+        if (-1 == n) {
+            if (EAGAIN == zmq_errno () || EINTR == zmq_errno ()) {
+                continue;
+            }
+            fprintf (stderr, "control: %s\n", zmq_strerror (zmq_errno ()));
+            break;
+        }
+
+        /* over long requests are truncated by zmq_recv */
+        buff[std::min (n, static_cast< int >(sizeof (buff) - 1))] = '\0';
+
+        std::string command (buff), verb, reply;
+        std::istringstream words (command);
+        words >> verb;
+
+        if ("ping" == verb) {
+            reply = "ok";
+        } else if ("help" == verb) {
+            reply = "ok ping help stats view open close xlim ylim nbins "
+                "colormap sd kde contours fit corr columns count snapshot";
+        } else if ("stats" == verb) {
+            std::string key;
+            words >> key;
+            reply = Stats (key);
+        } else if (verb.empty ()) {
+            reply = "err empty request";
+        } else {
+            reply = Marshal (command);
+        }
+
+        zmq_send (sock_, reply.data (), reply.size (), 0);
+    }
+}
+
+std::string Control::Marshal (const std::string& command) {
+
+    Request req (command);
+    std::unique_lock< std::mutex > guard (lock_);
+    pending_.push_back (&req);
+
+    if (! signalled_.exchange (true)) {
+        ALLEGRO_EVENT event;
+        memset (&event, 0, sizeof (event));
+        event.user.type = CONTROL_EVENT;
+        al_emit_user_event (&source_, &event, NULL);
+    }
+
+    while (! req.done && running_) {
+        replied_.wait (guard);
+    }
+    return req.done ? req.reply : std::string ("err shutting down");
+}
+
+std::string Control::Stats (const std::string& key) {
+
+    std::ostringstream out;
+    out << "ok";
+
+    {
+        std::lock_guard< std::mutex > guard (lock_);
+        std::map< std::string, std::string >::const_iterator CIT = 
+            cache_.begin (), CEND = cache_.end ();
+        for (; CIT != CEND; ++CIT) {
+            if (key.empty () || key == CIT->first) {
+                out << "\n" << CIT->first << " " << CIT->second;
+            }
+        }
+    }
+
+    if (key.empty () || "perf" == key) {
+        std::vector< const PlotStats * > stats = allPlotStats ();
+        std::vector< const PlotStats * >::const_iterator SIT = stats.begin (),
+            SEND = stats.end ();
+        char line[256];
+        for (; SIT != SEND; ++SIT) {
+            snprintf (line, sizeof (line), 
+                    "\nperf %s points=%zu draw_p50=%0.1f draw_p99=%0.1f",
+                    (*SIT)->Name ().c_str (), (*SIT)->Points (),
+                    (*SIT)->Percentile (STAGE_DRAW, 0.5),
+                    (*SIT)->Percentile (STAGE_DRAW, 0.99));
+            out << line;
+        }
+    }
+
+    return out.str ();
+}
+
+void Control::Service (const Handler& handler) {
+
+    std::deque< Request * > batch;
+
+    signalled_ = false;
+    {
+        std::lock_guard< std::mutex > guard (lock_);
+        batch.swap (pending_);
+    }
+
+    /* handlers run unlocked so stats stay answerable meanwhile */
+    std::deque< Request * >::iterator RIT = batch.begin (), 
+        REND = batch.end ();
+    for (; RIT != REND; ++RIT) {
+        std::string reply = handler ((*RIT)->command);
+        std::lock_guard< std::mutex > guard (lock_);
+        (*RIT)->reply = reply;
+        (*RIT)->done = true;
+    }
+    replied_.notify_all ();
+}
+
+void Control::Cache (const std::string& key, const std::string& value) {
+    std::lock_guard< std::mutex > guard (lock_);
+    cache_[key] = value;
+}
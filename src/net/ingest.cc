@@ -0,0 +1,180 @@
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <net/ingest.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+/* How often the receiver checks for Stop () */
+#define INGEST_POLL_MS 100
+
+bool localEndpoint (const char *endpoint) {
+    static const char *local[] = {
+        "ipc://", "inproc://", "tcp://127.0.0.1:", "tcp://localhost:",
+        "tcp://[::1]:", "tcp://lo:", NULL
+    };
+    for (int i = 0; NULL != local[i]; ++i) {
+        if (0 == strncmp (endpoint, local[i], strlen (local[i]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Ingest::Ingest () : ctx_(NULL), sock_(NULL), running_(false), 
+    signalled_(false), batches_(0), points_(0), rejected_(0) {
+    al_init_user_event_source (&source_);
+}
+
+Ingest::~Ingest () {
+    Stop ();
+    al_destroy_user_event_source (&source_);
+}
+
+bool Ingest::Start (const char *endpoint, IngestMode mode) {
+
+    if (running_) { return false; }
+
+    if (! localEndpoint (endpoint)) {
+        fprintf (stderr, "%s: only ipc, inproc or tcp on localhost "
+                "are accepted\n", endpoint);
+        return false;
+    }
+
+    ctx_ = zmq_ctx_new ();
+    sock_ = zmq_socket (ctx_, INGEST_SUB == mode ? ZMQ_SUB : ZMQ_PULL);
+    if (NULL == sock_) {
+        fprintf (stderr, "%s: %s\n", endpoint, zmq_strerror (zmq_errno ()));
+        Stop ();
+        return false;
+    }
+
+    int timeout = INGEST_POLL_MS, linger = 0;
+    zmq_setsockopt (sock_, ZMQ_RCVTIMEO, &timeout, sizeof (timeout));
+    zmq_setsockopt (sock_, ZMQ_LINGER, &linger, sizeof (linger));
+
+    int rc = 0;
+    if (INGEST_SUB == mode) {
+        zmq_setsockopt (sock_, ZMQ_SUBSCRIBE, "", 0);
+        rc = zmq_connect (sock_, endpoint);
+    } else {
+        rc = zmq_bind (sock_, endpoint);
+    }
+    if (0 != rc) {
+        fprintf (stderr, "%s: %s\n", endpoint, zmq_strerror (zmq_errno ()));
+        Stop ();
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread (&Ingest::Receive, this);
+    return true;
+}
+
+void Ingest::Stop () {
+
+    running_ = false;
+    if (thread_.joinable ()) {
+        thread_.join ();
+    }
+
+    std::deque< zmq_msg_t * >::iterator MIT = pending_.begin (),
+        MEND = pending_.end ();
+    for (; MIT != MEND; ++MIT) {
+        zmq_msg_close (*MIT);
+        delete *MIT;
+    }
+    pending_.clear ();
+
+    if (NULL != sock_) {
+        zmq_close (sock_);
+        sock_ = NULL;
+    }
+    if (NULL != ctx_) {
+        zmq_ctx_term (ctx_);
+        ctx_ = NULL;
+    }
+}
+
+void Ingest::Receive () {
+
+    traceThreadName ("ingest");
+
+    while (running_) {
+
+        zmq_msg_t *msg = new zmq_msg_t;
+        zmq_msg_init (msg);
+        if (-1 == zmq_msg_recv (msg, sock_, 0)) {
+            zmq_msg_close (msg);
+            delete msg;
+            /* EAGAIN is the poll timeout; anything else is fatal */
+            if (EAGAIN == zmq_errno () || EINTR == zmq_errno ()) {
+                continue;
+            }
+            fprintf (stderr, "ingest: %s\n", zmq_strerror (zmq_errno ()));
+            break;
+        }
+
+        std::size_t size = zmq_msg_size (msg);
+        if (0 == size || 0 != size % (2 * sizeof (double))) {
+            ++rejected_;
+            zmq_msg_close (msg);
+            delete msg;
+            continue;
+        }
+
+        {
+            std::lock_guard< std::mutex > guard (lock_);
+            pending_.push_back (msg);
+        }
+        ++batches_;
+
+        /* wake the main thread unless it already has a drain pending */
+        if (! signalled_.exchange (true)) {
+            ALLEGRO_EVENT event;
+            memset (&event, 0, sizeof (event));
+            event.user.type = INGEST_EVENT;
+            al_emit_user_event (&source_, &event, NULL);
+        }
+    }
+}
+
+std::size_t Ingest::Drain (Dataset& data) {
+
+    ScopedTimer timer (plotStats ("ingest"), STAGE_LOAD);
+    TRACE_SCOPE ("Ingest::Drain");
+
+    std::deque< zmq_msg_t * > batch;
+
+    /* cleared first so batches arriving from here on signal again */
+    signalled_ = false;
+    {
+        std::lock_guard< std::mutex > guard (lock_);
+        batch.swap (pending_);
+    }
+
+    std::size_t added = 0;
+    std::deque< zmq_msg_t * >::iterator MIT = batch.begin (),
+        MEND = batch.end ();
+    for (; MIT != MEND; ++MIT) {
+        const unsigned char *p = 
+            static_cast< const unsigned char * >(zmq_msg_data (*MIT));
+        std::size_t n = zmq_msg_size (*MIT) / (2 * sizeof (double));
+        for (std::size_t i = 0; i < n; ++i, p += 2 * sizeof (double)) {
+            /* payloads carry no alignment guarantee */
+            double x = 0.0, y = 0.0;
+            memcpy (&x, p, sizeof (double));
+            memcpy (&y, p + sizeof (double), sizeof (double));
+            if (! std::isfinite (x) || ! std::isfinite (y)) { continue; }
+            data.Add (Point (x, y));
+            ++added;
+        }
+        zmq_msg_close (*MIT);
+        delete *MIT;
+    }
+
+    points_ += added;
+    plotStats ("ingest").Points (points_);
+    return added;
+}
@@ -0,0 +1,104 @@
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <net/shmingest.h>
+#include <perf/stats.h>
+#include <perf/trace.h>
+
+/* How long the watcher sleeps when the ring is empty */
+#define SHM_POLL_US 500
+
+ShmIngest::ShmIngest () : ring_(NULL), running_(false), signalled_(false),
+    points_(0) {
+    al_init_user_event_source (&source_);
+}
+
+ShmIngest::~ShmIngest () {
+    Stop ();
+    al_destroy_user_event_source (&source_);
+}
+
+bool ShmIngest::Start (const char *name, unsigned long capacity) {
+
+    if (running_) { return false; }
+
+    ring_ = tandem_shm_create (name, capacity);
+    if (NULL == ring_) {
+        fprintf (stderr, "%s: failed to create shared memory ring: %s\n", 
+                name, 0 != (capacity & (capacity - 1)) ? 
+                "capacity is not a power of two" : strerror (errno));
+        return false;
+    }
+    name_ = name;
+
+    running_ = true;
+    thread_ = std::thread (&ShmIngest::Watch, this);
+    return true;
+}
+
+void ShmIngest::Stop () {
+
+    running_ = false;
+    if (thread_.joinable ()) {
+        thread_.join ();
+    }
+
+    if (NULL != ring_) {
+        tandem_shm_detach (ring_);
+        shm_unlink (name_.c_str ());
+        ring_ = NULL;
+    }
+}
+
+void ShmIngest::Watch () {
+
+    traceThreadName ("shm");
+
+    while (running_) {
+        if (0 < tandem_shm_pending (ring_) && ! signalled_.exchange (true)) {
+            ALLEGRO_EVENT event;
+            memset (&event, 0, sizeof (event));
+            event.user.type = SHM_EVENT;
+            al_emit_user_event (&source_, &event, NULL);
+        }
+        std::this_thread::sleep_for (std::chrono::microseconds (SHM_POLL_US));
+    }
+}
+
+std::size_t ShmIngest::Drain (Dataset& data) {
+
+    ScopedTimer timer (plotStats ("shm"), STAGE_LOAD);
+    TRACE_SCOPE ("ShmIngest::Drain");
+
+    /* cleared first so records arriving from here on signal again */
+    signalled_ = false;
+
+    std::size_t added = 0;
+    uint64_t n = 0;
+    const struct tandem_shm_record *recs = NULL;
+
+    /* bounded by what was there on entry so a fast producer can't starve us */
+    uint64_t budget = tandem_shm_pending (ring_);
+    while (0 < budget) {
+        recs = tandem_shm_peek (ring_, &n);
+        if (0 == n) { break; }
+        n = std::min (n, budget);
+        for (uint64_t i = 0; i < n; ++i) {
+            if (! std::isfinite (recs[i].x) || ! std::isfinite (recs[i].y)) {
+                continue;
+            }
+            data.Add (Point (recs[i].x, recs[i].y));
+            ++added;
+        }
+        tandem_shm_release (ring_, n);
+        budget -= n;
+    }
+
+    points_ += added;
+    plotStats ("shm").Points (points_);
+    return added;
+}
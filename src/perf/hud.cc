@@ -0,0 +1,40 @@
+
+#include <cstdio>
+#include <perf/hud.h>
+
+std::vector< std::string > hudLines (const PlotStats& stats) {
+    std::vector< std::string > lines;
+    char buff[128] = {0};
+
+    snprintf (buff, 128, "%s  points:%zu", 
+            stats.Name ().c_str (), stats.Points ());
+    lines.push_back (buff);
+
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        Stage stage = static_cast< Stage >(s);
+        const PlotStats& src = (STAGE_LOAD == stage) ? 
+            sessionStats () : stats;
+        if (0 == src.Total (stage)) { continue; }
+        snprintf (buff, 128, "%-8s p50:%10.1fus p99:%10.1fus", 
+                stage2str (stage), 
+                src.Percentile (stage, 0.50), 
+                src.Percentile (stage, 0.99));
+        lines.push_back (buff);
+    }
+
+    std::vector< const CacheCounter * > caches = allCacheCounters ();
+    std::vector< const CacheCounter * >::const_iterator CIT = caches.begin (),
+        CEND = caches.end ();
+    for (; CIT != CEND; ++CIT) {
+        snprintf (buff, 128, "cache %-8s %5.1f%% of %lu", 
+                (*CIT)->Name ().c_str (), 100.0 * (*CIT)->HitRate (),
+                (*CIT)->Hits () + (*CIT)->Misses ());
+        lines.push_back (buff);
+    }
+
+    snprintf (buff, 128, "rss %0.1f MiB", 
+            static_cast< double >(residentBytes ()) / (1024.0 * 1024.0));
+    lines.push_back (buff);
+
+    return lines;
+}
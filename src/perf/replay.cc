@@ -0,0 +1,139 @@
+
+#include <cstring>
+#include <perf/replay.h>
+
+static bool keyEvent (unsigned type) {
+    return ALLEGRO_EVENT_KEY_DOWN == type || ALLEGRO_EVENT_KEY_UP == type ||
+        ALLEGRO_EVENT_KEY_CHAR == type;
+}
+
+static bool mouseEvent (unsigned type) {
+    return ALLEGRO_EVENT_MOUSE_AXES == type || 
+        ALLEGRO_EVENT_MOUSE_BUTTON_DOWN == type ||
+        ALLEGRO_EVENT_MOUSE_BUTTON_UP == type;
+}
+
+static bool displayEvent (unsigned type) {
+    return ALLEGRO_EVENT_DISPLAY_CLOSE == type || 
+        ALLEGRO_EVENT_DISPLAY_RESIZE == type ||
+        ALLEGRO_EVENT_DISPLAY_EXPOSE == type;
+}
+
+const char * eventtype2str (unsigned type) {
+    switch (type) {
+        case ALLEGRO_EVENT_KEY_DOWN: return "key_down";
+        case ALLEGRO_EVENT_KEY_UP: return "key_up";
+        case ALLEGRO_EVENT_KEY_CHAR: return "key_char";
+        case ALLEGRO_EVENT_MOUSE_AXES: return "mouse_axes";
+        case ALLEGRO_EVENT_MOUSE_BUTTON_DOWN: return "mouse_down";
+        case ALLEGRO_EVENT_MOUSE_BUTTON_UP: return "mouse_up";
+        case ALLEGRO_EVENT_DISPLAY_CLOSE: return "display_close";
+        case ALLEGRO_EVENT_DISPLAY_RESIZE: return "display_resize";
+        case ALLEGRO_EVENT_DISPLAY_EXPOSE: return "display_expose";
+        default: return "other";
+    }
+    return "EVENT SWITCH FAIL";
+}
+
+ALLEGRO_DISPLAY * eventDisplay (const ALLEGRO_EVENT& event) {
+    if (keyEvent (event.type)) { return event.keyboard.display; }
+    if (mouseEvent (event.type)) { return event.mouse.display; }
+    if (displayEvent (event.type)) { return event.display.source; }
+    return NULL;
+}
+
+bool EventRecorder::Open (const char *path, int width, int height) {
+    Close ();
+    out_ = fopen (path, "w");
+    if (NULL == out_) { 
+        perror (path);
+        return false; 
+    }
+    fprintf (out_, "# tandem-events 1 %d %d\n", width, height);
+    start_ = -1.0;
+    return true;
+}
+
+void EventRecorder::Close () {
+    if (NULL != out_) {
+        fclose (out_);
+        out_ = NULL;
+    }
+}
+
+void EventRecorder::Record (const ALLEGRO_EVENT& event, int screen) {
+    int a = 0, b = 0, c = 0, d = 0;
+
+    if (! Active ()) { return; }
+
+    if (keyEvent (event.type)) {
+        a = event.keyboard.keycode;
+        b = event.keyboard.unichar;
+        c = static_cast< int >(event.keyboard.modifiers);
+    } else if (mouseEvent (event.type)) {
+        a = event.mouse.x;
+        b = event.mouse.y;
+        c = event.mouse.z;
+        d = static_cast< int >(event.mouse.button);
+    } else if (displayEvent (event.type)) {
+        a = event.display.width;
+        b = event.display.height;
+    } else {
+        return;
+    }
+
+    if (start_ < 0.0) { start_ = event.any.timestamp; }
+
+    fprintf (out_, "%0.6f %u %d %d %d %d %d\n", 
+            event.any.timestamp - start_, event.type, screen, a, b, c, d);
+    /* keep the file usable if the session dies */
+    fflush (out_);
+}
+
+bool loadEvents (const char *path, int& width, int& height, 
+        std::vector< RecordedEvent >& events) {
+    FILE *fin = fopen (path, "r");
+    int version = 0;
+    if (NULL == fin) { 
+        perror (path);
+        return false; 
+    }
+    if (3 != fscanf (fin, "# tandem-events %d %d %d\n", 
+                &version, &width, &height) || 1 != version) {
+        fprintf (stderr, "%s: not a tandem event recording\n", path);
+        fclose (fin);
+        return false;
+    }
+    events.clear ();
+    while (true) {
+        RecordedEvent rec;
+        if (7 != fscanf (fin, "%lf %u %d %d %d %d %d", &rec.time, &rec.type,
+                    &rec.screen, &rec.a, &rec.b, &rec.c, &rec.d)) {
+            break;
+        }
+        events.push_back (rec);
+    }
+    fclose (fin);
+    return true;
+}
+
+ALLEGRO_EVENT toEvent (const RecordedEvent& rec) {
+    ALLEGRO_EVENT event;
+    memset (&event, 0, sizeof (ALLEGRO_EVENT));
+    event.type = rec.type;
+    event.any.timestamp = rec.time;
+    if (keyEvent (rec.type)) {
+        event.keyboard.keycode = rec.a;
+        event.keyboard.unichar = rec.b;
+        event.keyboard.modifiers = static_cast< unsigned >(rec.c);
+    } else if (mouseEvent (rec.type)) {
+        event.mouse.x = rec.a;
+        event.mouse.y = rec.b;
+        event.mouse.z = rec.c;
+        event.mouse.button = static_cast< unsigned >(rec.d);
+    } else if (displayEvent (rec.type)) {
+        event.display.width = rec.a;
+        event.display.height = rec.b;
+    }
+    return event;
+}
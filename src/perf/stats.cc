@@ -0,0 +1,173 @@
+
+#include <map>
+#include <memory>
+#include <algorithm>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <perf/stats.h>
+
+const char * stage2str (Stage s) {
+    switch (s) {
+        case STAGE_LOAD: return "load";
+        case STAGE_COMPUTE: return "compute";
+        case STAGE_DRAW: return "draw";
+        case STAGE_FLIP: return "flip";
+        default: return "MISSING STAGE CASE";
+    }
+    return "STAGE SWITCH FAIL";
+}
+
+void RollingHistogram::Add (double usec) {
+    samples_[next_] = usec;
+    next_ = (next_ + 1) % samples_.size ();
+    ++total_;
+}
+
+double RollingHistogram::Percentile (double p) const {
+    std::size_t n = Window ();
+    if (0 == n) { return 0.0; }
+    std::vector< double > xs (samples_.begin (), samples_.begin () + n);
+    std::size_t k = static_cast< std::size_t >(p * (n - 1) + 0.5);
+    std::nth_element (xs.begin (), xs.begin () + k, xs.end ());
+    return xs[k];
+}
+
+double RollingHistogram::Last () const {
+    if (0 == total_) { return 0.0; }
+    return samples_[(next_ + samples_.size () - 1) % samples_.size ()];
+}
+
+void PlotStats::Record (Stage stage, double usec) {
+    std::lock_guard< std::mutex > guard (lock_);
+    stages_[stage].Add (usec);
+}
+
+void PlotStats::Points (std::size_t n) {
+    std::lock_guard< std::mutex > guard (lock_);
+    points_ = n;
+}
+
+std::size_t PlotStats::Points () const {
+    std::lock_guard< std::mutex > guard (lock_);
+    return points_;
+}
+
+double PlotStats::Percentile (Stage stage, double p) const {
+    std::lock_guard< std::mutex > guard (lock_);
+    return stages_[stage].Percentile (p);
+}
+
+double PlotStats::Last (Stage stage) const {
+    std::lock_guard< std::mutex > guard (lock_);
+    return stages_[stage].Last ();
+}
+
+std::size_t PlotStats::Total (Stage stage) const {
+    std::lock_guard< std::mutex > guard (lock_);
+    return stages_[stage].Total ();
+}
+
+double CacheCounter::HitRate () const {
+    unsigned long h = Hits (), m = Misses ();
+    if (0 == h + m) { return 0.0; }
+    return static_cast< double >(h) / static_cast< double >(h + m);
+}
+
+/*
+ * Registries hand out references, so entries are heap allocated and
+ * never moved or freed
+ */
+static std::mutex registry_lock;
+static std::map< std::string, std::unique_ptr< PlotStats > > plot_registry;
+static std::map< std::string, std::unique_ptr< CacheCounter > > cache_registry;
+
+PlotStats& plotStats (const std::string& name) {
+    std::lock_guard< std::mutex > guard (registry_lock);
+    std::unique_ptr< PlotStats >& entry = plot_registry[name];
+    if (! entry) {
+        entry.reset (new PlotStats (name));
+    }
+    return *entry;
+}
+
+CacheCounter& cacheCounter (const std::string& name) {
+    std::lock_guard< std::mutex > guard (registry_lock);
+    std::unique_ptr< CacheCounter >& entry = cache_registry[name];
+    if (! entry) {
+        entry.reset (new CacheCounter (name));
+    }
+    return *entry;
+}
+
+PlotStats& sessionStats () {
+    return plotStats ("session");
+}
+
+std::vector< const PlotStats * > allPlotStats () {
+    std::lock_guard< std::mutex > guard (registry_lock);
+    std::vector< const PlotStats * > all;
+    std::map< std::string, std::unique_ptr< PlotStats > >::const_iterator 
+        RIT = plot_registry.begin (), REND = plot_registry.end ();
+    for (; RIT != REND; ++RIT) {
+        all.push_back (RIT->second.get ());
+    }
+    return all;
+}
+
+std::vector< const CacheCounter * > allCacheCounters () {
+    std::lock_guard< std::mutex > guard (registry_lock);
+    std::vector< const CacheCounter * > all;
+    std::map< std::string, std::unique_ptr< CacheCounter > >::const_iterator 
+        RIT = cache_registry.begin (), REND = cache_registry.end ();
+    for (; RIT != REND; ++RIT) {
+        all.push_back (RIT->second.get ());
+    }
+    return all;
+}
+
+std::size_t residentBytes () {
+    long pages = 0, resident = 0;
+    FILE *fin = fopen ("/proc/self/statm", "r");
+    if (NULL == fin) { return 0; }
+    if (2 != fscanf (fin, "%ld %ld", &pages, &resident)) {
+        resident = 0;
+    }
+    fclose (fin);
+    return static_cast< std::size_t >(resident) * 
+        static_cast< std::size_t >(sysconf (_SC_PAGESIZE));
+}
+
+void dumpStats (FILE *out) {
+    std::vector< const PlotStats * > plots = allPlotStats ();
+    std::vector< const CacheCounter * > caches = allCacheCounters ();
+
+    fprintf (out, "%-16s %-8s %8s %12s %12s\n", 
+            "plot", "stage", "samples", "p50(us)", "p99(us)");
+    std::vector< const PlotStats * >::const_iterator PIT = plots.begin (),
+        PEND = plots.end ();
+    for (; PIT != PEND; ++PIT) {
+        for (int s = 0; s < NUM_STAGES; ++s) {
+            Stage stage = static_cast< Stage >(s);
+            if (0 == (*PIT)->Total (stage)) { continue; }
+            fprintf (out, "%-16s %-8s %8zu %12.1f %12.1f\n", 
+                    (*PIT)->Name ().c_str (), stage2str (stage),
+                    (*PIT)->Total (stage),
+                    (*PIT)->Percentile (stage, 0.50),
+                    (*PIT)->Percentile (stage, 0.99));
+        }
+    }
+
+    std::vector< const CacheCounter * >::const_iterator CIT = caches.begin (),
+        CEND = caches.end ();
+    for (; CIT != CEND; ++CIT) {
+        fprintf (out, "cache %-10s hits:%lu misses:%lu rate:%0.3f\n", 
+                (*CIT)->Name ().c_str (), (*CIT)->Hits (), (*CIT)->Misses (),
+                (*CIT)->HitRate ());
+    }
+
+    fprintf (out, "rss %0.1f MiB\n", 
+            static_cast< double >(residentBytes ()) / (1024.0 * 1024.0));
+}
@@ -0,0 +1,179 @@
+
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+#include <perf/trace.h>
+
+std::atomic< bool > trace_enabled (false);
+
+struct TraceEvent {
+    const char *name;
+    long long ts;        /* ns since trace start */
+    char phase;          /* 'B'egin or 'E'nd */
+};
+
+/*
+ * Single producer (the owning thread) ring of events. [head_] only ever
+ * grows; the slot for an event is head_ % capacity.
+ */
+class TraceBuffer {
+
+    std::vector< TraceEvent > events_;
+    std::atomic< std::size_t > head_;
+    int tid_;
+    const char *name_;
+
+    TraceBuffer ();
+    TraceBuffer (const TraceBuffer&);
+
+public:
+
+    TraceBuffer (std::size_t capacity, int tid) : 
+        events_(capacity), head_(0), tid_(tid), name_(NULL) {}
+
+    void Push (const char *name, long long ts, char phase) {
+        std::size_t h = head_.load (std::memory_order_relaxed);
+        TraceEvent& ev = events_[h % events_.size ()];
+        ev.name = name;
+        ev.ts = ts;
+        ev.phase = phase;
+        head_.store (h + 1, std::memory_order_release);
+    }
+
+    int Tid () const { return tid_; }
+    const char * Name () const { return name_; }
+    void Name (const char *name) { name_ = name; }
+
+    /* 
+     * Oldest to newest copy of the events still in the ring; this is
+     * best effort if the owning thread is still recording
+     */
+    void Snapshot (std::vector< TraceEvent >& dest) const {
+        std::size_t h = head_.load (std::memory_order_acquire);
+        std::size_t n = std::min (h, events_.size ());
+        dest.clear ();
+        dest.reserve (n);
+        for (std::size_t i = h - n; i < h; ++i) {
+            dest.push_back (events_[i % events_.size ()]);
+        }
+    }
+
+};
+
+typedef std::chrono::steady_clock TraceClock;
+
+static std::mutex trace_lock;
+static std::vector< TraceBuffer * > trace_buffers;
+static std::string trace_path;
+static std::size_t trace_capacity = 0;
+static TraceClock::time_point trace_epoch;
+
+static thread_local TraceBuffer *local_buffer = NULL;
+
+static TraceBuffer * localBuffer () {
+    if (NULL == local_buffer) {
+        std::lock_guard< std::mutex > guard (trace_lock);
+        /* buffers are never freed so a dump can outlive the thread */
+        local_buffer = new TraceBuffer (trace_capacity, 
+                static_cast< int >(trace_buffers.size ()) + 1);
+        trace_buffers.push_back (local_buffer);
+    }
+    return local_buffer;
+}
+
+static long long traceNow () {
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+            TraceClock::now () - trace_epoch).count ();
+}
+
+void traceStart (const char *path, std::size_t events_per_thread) {
+    {
+        std::lock_guard< std::mutex > guard (trace_lock);
+        trace_path = path;
+        trace_capacity = std::max (events_per_thread, 
+                static_cast< std::size_t >(16));
+        trace_epoch = TraceClock::now ();
+    }
+    trace_enabled.store (true);
+    traceThreadName ("main");
+}
+
+void traceThreadName (const char *name) {
+    if (! traceEnabled ()) { return; }
+    localBuffer ()->Name (name);
+}
+
+void traceBegin (const char *name) {
+    localBuffer ()->Push (name, traceNow (), 'B');
+}
+
+void traceEnd (const char *name) {
+    localBuffer ()->Push (name, traceNow (), 'E');
+}
+
+/* Event names are literals from our own code but escape them anyway */
+static void writeString (FILE *out, const char *str) {
+    fputc ('"', out);
+    for (; '\0' != *str; ++str) {
+        if ('"' == *str || '\\' == *str) {
+            fputc ('\\', out);
+        }
+        fputc (*str, out);
+    }
+    fputc ('"', out);
+}
+
+bool traceWrite () {
+    if (! traceEnabled ()) { return false; }
+
+    std::vector< TraceBuffer * > buffers;
+    std::string path;
+    {
+        std::lock_guard< std::mutex > guard (trace_lock);
+        buffers = trace_buffers;
+        path = trace_path;
+    }
+
+    FILE *out = fopen (path.c_str (), "w");
+    if (NULL == out) { 
+        perror (path.c_str ());
+        return false; 
+    }
+
+    bool first = true;
+    std::vector< TraceEvent > events;
+    std::vector< TraceBuffer * >::const_iterator BIT = buffers.begin (),
+        BEND = buffers.end ();
+
+    fprintf (out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (; BIT != BEND; ++BIT) {
+        const TraceBuffer *buff = *BIT;
+        if (NULL != buff->Name ()) {
+            fprintf (out, "%s{\"name\":\"thread_name\",\"ph\":\"M\","
+                    "\"pid\":1,\"tid\":%d,\"args\":{\"name\":", 
+                    first ? "" : ",\n", buff->Tid ());
+            writeString (out, buff->Name ());
+            fprintf (out, "}}");
+            first = false;
+        }
+
+        buff->Snapshot (events);
+        std::vector< TraceEvent >::const_iterator EIT = events.begin (),
+            EEND = events.end ();
+        for (; EIT != EEND; ++EIT) {
+            fprintf (out, "%s{\"name\":", first ? "" : ",\n");
+            writeString (out, EIT->name);
+            fprintf (out, ",\"ph\":\"%c\",\"ts\":%lld.%03lld,"
+                    "\"pid\":1,\"tid\":%d}", 
+                    EIT->phase, EIT->ts / 1000, EIT->ts % 1000, buff->Tid ());
+            first = false;
+        }
+    }
+    fprintf (out, "\n]}\n");
+
+    return 0 == fclose (out);
+}
@@ -4,57 +4,570 @@
 #include <vector>
 #include <cmath>
 #include <ctime>
+#include <csignal>
 #include <string>
+#include <sstream>
 #include <algorithm>
+#include <chrono>
 #include <allegro5/allegro.h>
 #include <allegro5/allegro_primitives.h>
 #include <allegro5/allegro_ttf.h>
+#include <allegro5/allegro_image.h>
 #include <zmq.hpp>
 
 extern "C" {
 #include <unistd.h>
+#include <getopt.h>
 #include <libgen.h>
 #include <sys/stat.h>
 }
 
 #include <graph/plot.h>
 #include <graph/util.h>
+#include <graph/colormap.h>
 #include <graph/dataset.h>
+#include <graph/views.h>
+#include <graph/facets.h>
+#include <graph/screens.h>
+#include <dataset/csv.h>
+#include <dataset/follow.h>
+#include <dataset/table.h>
+#include <dataset/groups.h>
+#include <dataset/kde.h>
+#include <dataset/regression.h>
+#include <perf/stats.h>
+#include <perf/hud.h>
+#include <perf/trace.h>
+#include <perf/replay.h>
+#include <net/ingest.h>
+#include <net/control.h>
+#include <net/shmingest.h>
+
+/* Set from SIGUSR1 to request a trace dump from the event loop */
+static volatile sig_atomic_t trace_requested = 0;
+
+static void request_trace (int) {
+    trace_requested = 1;
+}
 
 enum button_state {
     BUTTON_DOWN = 0,
     BUTTON_UP
 };
 
-/* TODO: Make this better. simple struct with a 'Next' interface? something */
-#define PLOT_SCATTER   0
-#define PLOT_BOX_H     1
-#define PLOT_BOX_V     2
-#define PLOT_HIST_L    3
-#define PLOT_HIST_R    4
-#define PLOT_HIST_B    5
-#define PLOT_HIST_T    6
-#define PLOT_HEXBIN    7
-#define PLOT_LINE      8
-#define PLOT_ECDF_H    9
-#define PLOT_ECDF_V    10
-#define MAX_PLOT       11
-
-void change_plot (BasicPlot **plots, int *plot_type, 
-        ALLEGRO_DISPLAY **screens, ALLEGRO_DISPLAY *source, Dataset& data,
-        FloatType minx, FloatType maxx, FloatType miny, FloatType maxy,
-        int dir) {
-    int i = -1;
-    if (source == screens[0]) { i = 0; }
-    else if (source == screens[1]) { i = 1; }
-    else if (source == screens[2]) { i = 2; }
-
-    if (-1 == i) {
+/* Windows open at startup unless --screens says otherwise */
+#define DEFAULT_SCREENS 3
+
+/* Most categories --facet will lay out */
+#define MAX_FACETS 64
+
+/*
+ * Each notch of the mouse wheel zooms by ZOOM_STEP; notches less than
+ * ZOOM_GESTURE seconds apart make up one step of the zoom history,
+ * which keeps the last ZOOM_HISTORY limits
+ */
+#define ZOOM_STEP 1.25
+#define ZOOM_GESTURE 0.5
+#define ZOOM_HISTORY 64
+
+/* Fixed size of --render output so images compare across machines */
+#define RENDER_WIDTH 640
+#define RENDER_HEIGHT 480
+
+/* Plot limits as a zoom or pan leaves them, for the zoom history */
+struct Limits {
+    FloatType minx, maxx, miny, maxy;
+    bool fixed_x, fixed_y;
+};
+
+/*
+ * State shared by the event handlers. Every window in [screens] plots
+ * the one [data]; when running headless (event replay) the windows are
+ * offscreen bitmaps. Limits follow the data unless fixed by the
+ * controller or by zooming and panning.
+ */
+struct Session {
+    Screens             screens;    /* open windows, all plotting data */
+    Dataset             *data;      /* the points plotted */
+    Table               *table;     /* wide table; data then views it */
+    int                 xcol, ycol; /* table columns viewed by data */
+    std::vector< int >  splom;      /* matrix columns, x and y if empty */
+    Groups              *groups;    /* data split by the facet column */
+    int                 facet;      /* table column faceted on, -1 none */
+    int                 facet_type; /* plot type of each facet panel */
+    Ingest              *ingest;    /* points streamed in over 0MQ */
+    ShmIngest           *shm;       /* points from a shared memory ring */
+    Follow              *follow;    /* rows appended to the input file */
+    Control             *control;   /* remote control endpoint */
+    ALLEGRO_TIMER       *expiry;    /* ticks to age out a time window */
+    FloatType           minx, maxx, miny, maxy; /* axis limits */
+    bool                fixed_x, fixed_y; /* limits not following data */
+    std::vector< Limits > zoom_back;    /* limits replaced by zooming */
+    std::vector< Limits > zoom_forward; /* limits gone back over */
+    double              zoom_time;  /* when the last wheel zoom began */
+    int                 drag;       /* window being panned, -1 none */
+    int                 mouse_x, mouse_y, mouse_z; /* last mouse seen */
+    bool                panned;     /* drag is in the zoom history */
+    int                 nbins;      /* histogram bins, 0 plot default */
+    int                 cmap;       /* colormap of density plots, CMAP_* */
+    int                 cscale;     /* count normalization, SCALE_* */
+    FloatType           nsd;        /* std devs spanned by spread ellipses */
+    int                 kde;        /* density curve bandwidth rule, KDE_* */
+    std::vector< FloatType > contours; /* mass shares of density contours */
+    int                 fit;        /* degree of the regression drawn, 0 none */
+    int                 corr;       /* correlation coefficient, CORR_* */
+    bool                shifted;    /* a shift key is held */
+    bool                hud;        /* draw the performance overlay */
+
+    Session () : data(NULL), table(NULL), xcol(0), ycol(1), groups(NULL),
+        facet(-1), facet_type(PLOT_SCATTER), ingest(NULL), shm(NULL),
+        follow(NULL), control(NULL), expiry(NULL),
+        minx(0), maxx(0), miny(0), maxy(0), fixed_x(false), fixed_y(false),
+        zoom_time(-1.0), drag(-1), mouse_x(0), mouse_y(0), mouse_z(0),
+        panned(false), nbins(0), cmap(Parameters::Defaults ().cmap),
+        cscale(Parameters::Defaults ().cscale),
+        nsd(Parameters::Defaults ().nsd), kde(Parameters::Defaults ().kde),
+        contours(Parameters::Defaults ().contours),
+        fit(Parameters::Defaults ().fit), corr(Parameters::Defaults ().corr),
+        shifted(false), hud(false) {}
+
+    ~Session () {
+        if (NULL != table) { delete data; }
+    }
+};
+
+/* Add buffers outside data so points dont appear on the plot edge */
+void set_limits (Session& s) {
+    const Range& xd = s.data->XDomain ();
+    const Range& yd = s.data->YDomain ();
+    if (! s.fixed_x) {
+        s.minx = xd.Low () - xd.Distance () * 0.05;
+        s.maxx = xd.High () + xd.Distance () * 0.05;
+    }
+    if (! s.fixed_y) {
+        s.miny = yd.Low () - yd.Distance () * 0.05;
+        s.maxy = yd.High () + yd.Distance () * 0.05;
+    }
+}
+
+/* 
+ * Refresh what the controller answers "stats" with; the data summary
+ * is only rebuilt when [data_changed]
+ */
+void publish (Session& s, bool data_changed) {
+
+    if (NULL == s.control) { return; }
+
+    char buff[512];
+    if (data_changed) {
+        /* kept up to date point by point, so this is no pass over the data */
+        const PointMoments& m = s.screens.Spread ().Update (*s.data);
+        snprintf (buff, sizeof (buff), 
+                "n=%zu xmin=%g xmax=%g ymin=%g ymax=%g xmean=%g ymean=%g "
+                "xsd=%g ysd=%g cor=%g",
+                s.data->Size (), s.data->XDomain ().Low (), 
+                s.data->XDomain ().High (), s.data->YDomain ().Low (),
+                s.data->YDomain ().High (), m.X ().Mean (), m.Y ().Mean (),
+                m.X ().StdDev (), m.Y ().StdDev (), m.XY ().Correlation ());
+        s.control->Cache ("data", buff);
+        if (NULL != s.table) {
+            s.control->Cache ("columns", "x=" + s.table->Name (s.xcol) + 
+                    " y=" + s.table->Name (s.ycol));
+        }
+    }
+
+    std::string views;
+    for (int i = 0; i < s.screens.Slots (); ++i) {
+        if (! s.screens.Valid (i)) { continue; }
+        snprintf (buff, sizeof (buff), "%s%d=%s", views.empty () ? "" : " ",
+                i, plottype2str (s.screens[i].type));
+        views += buff;
+    }
+    s.control->Cache ("view", views);
+
+    std::string contours;
+    for (std::size_t i = 0; i < s.contours.size (); ++i) {
+        snprintf (buff, sizeof (buff), "%s%g", (0 == i) ? "" : ",",
+                s.contours[i]);
+        contours += buff;
+    }
+    snprintf (buff, sizeof (buff), 
+            "xlim=%g,%g%s ylim=%g,%g%s nbins=%d colormap=%s,%s sd=%g kde=%s "
+            "contours=%s fit=%d corr=%s hud=%d",
+            s.minx, s.maxx, s.fixed_x ? "" : "(auto)", 
+            s.miny, s.maxy, s.fixed_y ? "" : "(auto)", 
+            0 == s.nbins ? Parameters::Defaults ().nbins : s.nbins, 
+            colormap2str (s.cmap), colorscale2str (s.cscale), s.nsd, 
+            bandwidth2str (s.kde),
+            contours.empty () ? "none" : contours.c_str (), s.fit,
+            correlation2str (s.corr), s.hud);
+    s.control->Cache ("limits", buff);
+}
+
+/* Apply session wide parameter overrides to a fresh plot of [type] */
+void configure (Session& s, int type, BasicPlot *plot) {
+    if ((PLOT_SPLOM == type || PLOT_CORRELATION == type) &&
+            NULL != s.table) {
+        std::vector< int > cols (s.splom);
+        if (cols.empty ()) {
+            cols.push_back (s.xcol);
+            cols.push_back (s.ycol);
+        }
+        if (PLOT_SPLOM == type) {
+            static_cast< SplomPlot * >(plot)->Columns (s.table, cols);
+        } else {
+            static_cast< CorrelationPlot * >(plot)->Columns (s.table, cols);
+        }
+    }
+    if (PLOT_FACETS == type) {
+        /* without groups the one panel shows all the data */
+        std::vector< const Dataset * > data;
+        std::vector< std::string > labels;
+        for (Groups::size_type g = 0; NULL != s.groups && 
+                g < s.groups->Size (); ++g) {
+            data.push_back (&s.groups->Data (g));
+            labels.push_back (s.table->Name (s.facet) + " = " + 
+                    s.groups->Label (g));
+        }
+        static_cast< FacetPlot * >(plot)->Facets (s.facet_type, data, labels);
+    }
+    if (PLOT_HIST_L <= type && type <= PLOT_HIST_T) {
+        static_cast< HistogramPlot * >(plot)->Share (&s.screens.Bins ());
+        static_cast< HistogramPlot * >(plot)->Share (&s.screens.Sorted ());
+    }
+    if (PLOT_ECDF_H == type || PLOT_ECDF_V == type) {
+        static_cast< ECDFPlot * >(plot)->Share (&s.screens.Sorted ());
+    }
+    if (PLOT_BOX_H == type || PLOT_BOX_V == type) {
+        static_cast< BoxPlot * >(plot)->Share (&s.screens.Sorted ());
+        static_cast< BoxPlot * >(plot)->Share (&s.screens.Spread ());
+    }
+    if (PLOT_SCATTER == type) {
+        static_cast< ScatterPlot * >(plot)->Share (&s.screens.Spread ());
+        static_cast< ScatterPlot * >(plot)->Share (&s.screens.Areas ());
+        static_cast< ScatterPlot * >(plot)->Share (&s.screens.Regression ());
+    }
+    if (PLOT_LINE == type) {
+        static_cast< LinePlot * >(plot)->Share (&s.screens.Regression ());
+    }
+    if (PLOT_HEXBIN == type) {
+        static_cast< HexBinPlot * >(plot)->Share (&s.screens.Spread ());
+        static_cast< HexBinPlot * >(plot)->Share (&s.screens.Areas ());
+    }
+    if (PLOT_HEATMAP == type) {
+        static_cast< HeatmapPlot * >(plot)->Share (&s.screens.Areas ());
+    }
+    Parameters par = plot->Par ();
+    if (0 < s.nbins) { par.nbins = s.nbins; }
+    par.cmap = s.cmap;
+    par.cscale = s.cscale;
+    par.nsd = s.nsd;
+    par.kde = s.kde;
+    par.contours = s.contours;
+    par.fit = s.fit;
+    par.corr = s.corr;
+    plot->Par (par);
+}
+
+/* Reapply the session parameters to the plot on every window */
+void reconfigure (Session& s) {
+    for (int i = 0; i < s.screens.Slots (); ++i) {
+        if (! s.screens.Valid (i)) { continue; }
+        configure (s, s.screens[i].type, s.screens[i].plot);
+    }
+}
+
+/*
+ * Draw window [i]; a plot the data cannot make (e.g. a line of one
+ * point, streamed in or left by an expired window) shows why as its
+ * title, like a refused facet panel, and the other windows still draw
+ */
+void draw_screen (Session& s, int i) {
+    BasicPlot *plot = s.screens[i].plot;
+    s.screens[i].stale = false;
+    try {
+        draw_plot (plot, s.screens[i].type, *s.data, 
+                s.minx, s.maxx, s.miny, s.maxy, s.hud);
+    } catch (const std::exception& e) {
+        plot->Clear ();
+        plot->Title (e.what ());
+        plot->Update ();
+    }
+}
+
+/*
+ * Draw the windows resized since they were last drawn; run once the
+ * queue is empty, so dragging a window edge draws once per batch of
+ * resize events
+ */
+void refresh (Session& s) {
+    for (int i = 0; i < s.screens.Slots (); ++i) {
+        if (! s.screens.Valid (i) || ! s.screens[i].stale) { continue; }
+        draw_screen (s, i);
+    }
+}
+
+void redraw (Session& s) {
+    for (int i = 0; i < s.screens.Slots (); ++i) {
+        if (! s.screens.Valid (i)) { continue; }
+        draw_screen (s, i);
+    }
+}
+
+/* Points were appended to the data; cached bins only count the new ones */
+void data_changed (Session& s) {
+    sessionStats ().Points (s.data->Size ());
+    /* an expired window keeps showing the last points it had */
+    if (0 == s.data->Size ()) { return; }
+    set_limits (s);
+    redraw (s);
+    publish (s, true);
+}
+
+/*
+ * The session axes window [i] lays out [across] and [up] the screen,
+ * AXIS_X, AXIS_Y or -1 where it shows no data (shares, counts, the
+ * cells of a matrix); zooming and panning move only those limits
+ */
+void screen_axes (const Session& s, int i, int& across, int& up) {
+    across = up = -1;
+    if (! s.screens.Valid (i)) { return; }
+    int type = s.screens[i].type;
+    if (PLOT_FACETS == type) { type = s.facet_type; }
+    switch (type) {
+        case PLOT_SCATTER:
+        case PLOT_HEXBIN:
+        case PLOT_LINE:
+        case PLOT_HEATMAP:
+            across = AXIS_X;
+            up = AXIS_Y;
+            break;
+        case PLOT_BOX_H:
+        case PLOT_HIST_B:
+        case PLOT_HIST_T:
+            across = AXIS_X;
+            break;
+        case PLOT_BOX_V:
+        case PLOT_HIST_L:
+        case PLOT_HIST_R:
+            up = AXIS_Y;
+            break;
+        case PLOT_ECDF_H:
+            across = AXIS_Y;
+            break;
+        case PLOT_ECDF_V:
+            up = AXIS_X;
+            break;
+        default:
+            break;
+    }
+}
+
+/* Whether window [i] shows data it can be zoomed and panned over */
+bool navigable (const Session& s, int i) {
+    int across = -1, up = -1;
+    screen_axes (s, i, across, up);
+    return -1 != across || -1 != up;
+}
+
+/* Have refresh () draw every window */
+void invalidate (Session& s) {
+    for (int i = 0; i < s.screens.Slots (); ++i) {
+        if (s.screens.Valid (i)) { s.screens[i].stale = true; }
+    }
+}
+
+Limits limits (const Session& s) {
+    Limits now = { s.minx, s.maxx, s.miny, s.maxy, s.fixed_x, s.fixed_y };
+    return now;
+}
+
+/* Keep limits [was] in the zoom history as they are changed */
+void push_zoom (Session& s, const Limits& was) {
+    s.zoom_back.push_back (was);
+    if (s.zoom_back.size () > ZOOM_HISTORY) {
+        s.zoom_back.erase (s.zoom_back.begin ());
+    }
+    s.zoom_forward.clear ();
+}
+
+/* Go back ([dir] < 0) or forward through the zoom history */
+void zoom_history (Session& s, int dir) {
+    std::vector< Limits >& from = (dir < 0) ? s.zoom_back : s.zoom_forward;
+    std::vector< Limits >& to = (dir < 0) ? s.zoom_forward : s.zoom_back;
+    if (from.empty ()) { return; }
+
+    to.push_back (limits (s));
+    const Limits& next = from.back ();
+    s.minx = next.minx;
+    s.maxx = next.maxx;
+    s.miny = next.miny;
+    s.maxy = next.maxy;
+    s.fixed_x = next.fixed_x;
+    s.fixed_y = next.fixed_y;
+    from.pop_back ();
+
+    set_limits (s);
+    invalidate (s);
+    publish (s, false);
+}
+
+/*
+ * The data under pixel [x], [y] of window [i] at the session limits,
+ * as x and y; an axis the window does not show is left at its middle
+ */
+Point locate (Session& s, int i, int x, int y) {
+    int across = -1, up = -1;
+    screen_axes (s, i, across, up);
+    BasicPlot *plot = s.screens[i].plot;
+    if (AXIS_Y == across) {
+        plot->Xlim (s.miny, s.maxy);
+    } else {
+        plot->Xlim (s.minx, s.maxx);
+    }
+    if (AXIS_X == up) {
+        plot->Ylim (s.minx, s.maxx);
+    } else {
+        plot->Ylim (s.miny, s.maxy);
+    }
+    Point at = plot->Locate (x, y);
+    FloatType dx = (s.minx + s.maxx) / 2.0, dy = (s.miny + s.maxy) / 2.0;
+    if (AXIS_X == across) { dx = at.X (); }
+    if (AXIS_X == up) { dx = at.Y (); }
+    if (AXIS_Y == across) { dy = at.X (); }
+    if (AXIS_Y == up) { dy = at.Y (); }
+    return Point (dx, dy);
+}
+
+/*
+ * Zoom in [steps] wheel notches (out if negative) keeping the data
+ * under pixel [x], [y] of window [i] in place
+ */
+void zoom (Session& s, int i, int x, int y, int steps, double time) {
+
+    if (0 == steps || ! navigable (s, i)) { return; }
+
+    int across = -1, up = -1;
+    screen_axes (s, i, across, up);
+    bool zx = AXIS_X == across || AXIS_X == up,
+         zy = AXIS_Y == across || AXIS_Y == up;
+    Point c = locate (s, i, x, y);
+    FloatType fx = zx ? pow (ZOOM_STEP, -steps) : 1.0,
+              fy = zy ? pow (ZOOM_STEP, -steps) : 1.0;
+    FloatType minx = c.X () - (c.X () - s.minx) * fx,
+              maxx = c.X () + (s.maxx - c.X ()) * fx,
+              miny = c.Y () - (c.Y () - s.miny) * fy,
+              maxy = c.Y () + (s.maxy - c.Y ()) * fy;
+    /* stop where the limits can no longer be told apart */
+    if (! (minx < maxx && miny < maxy)) { return; }
+
+    if (s.zoom_time < 0.0 || time - s.zoom_time > ZOOM_GESTURE) {
+        push_zoom (s, limits (s));
+    }
+    s.zoom_time = time;
+
+    s.minx = minx;
+    s.maxx = maxx;
+    s.miny = miny;
+    s.maxy = maxy;
+    s.fixed_x = s.fixed_x || zx;
+    s.fixed_y = s.fixed_y || zy;
+    invalidate (s);
+    publish (s, false);
+}
+
+/* Drag the data under the mouse along to pixel [x], [y] */
+void pan (Session& s, int x, int y) {
+
+    Point from = locate (s, s.drag, s.mouse_x, s.mouse_y);
+    Point to = locate (s, s.drag, x, y);
+
+    /* a whole drag is one step of the zoom history */
+    if (! s.panned) {
+        push_zoom (s, limits (s));
+        s.panned = true;
+    }
+
+    /* an axis the window does not show locates to the same middle */
+    int across = -1, up = -1;
+    screen_axes (s, s.drag, across, up);
+    s.minx += from.X () - to.X ();
+    s.maxx += from.X () - to.X ();
+    s.miny += from.Y () - to.Y ();
+    s.maxy += from.Y () - to.Y ();
+    s.fixed_x = s.fixed_x || AXIS_X == across || AXIS_X == up;
+    s.fixed_y = s.fixed_y || AXIS_Y == across || AXIS_Y == up;
+    invalidate (s);
+    publish (s, false);
+}
+
+/*
+ * Plot columns [x] and [y] of the session table, parsing them first
+ * if they are not loaded yet. Neither column is copied; the new view
+ * simply replaces the old one.
+ */
+void set_columns (Session& s, int x, int y) {
+    std::vector< int > cols;
+    cols.push_back (x);
+    cols.push_back (y);
+    {
+        ScopedTimer timer (sessionStats (), STAGE_LOAD);
+        if (! s.table->Load (cols)) {
+            throw GeneralException ("Failed to load columns", 
+                    __FILE__, __LINE__);
+        }
+    }
+    Dataset *view = new Dataset (s.table->Column (x), s.table->Column (y),
+            s.table->Domain (x), s.table->Domain (y));
+    delete s.data;
+    s.data = view;
+    s.xcol = x;
+    s.ycol = y;
+}
+
+/* Regroup the plotted columns by the facet column */
+void set_facets (Session& s) {
+    if (NULL == s.groups) { return; }
+    std::vector< int > cols (1, s.facet);
+    if (! s.table->Load (cols) || ! s.groups->Split (*s.table, s.facet, 
+                s.xcol, s.ycol, MAX_FACETS)) {
+        throw GeneralException ("Too many facets", __FILE__, __LINE__);
+    }
+}
+
+void set_plot (Session& s, int i, int type) {
+    Screens::View& view = s.screens[i];
+    BasicPlot *plot = (NULL != view.display) ? new_plot (type, view.display) :
+        new_plot (type, view.target);
+    if (NULL == plot) {
+        throw GeneralException ("Memory error", __FILE__, __LINE__);
+    }
+    delete view.plot;
+    view.plot = plot;
+    view.type = type;
+    configure (s, type, plot);
+    draw_screen (s, i);
+}
+
+/* Open another window showing a plot of [type]; returns its number */
+int open_screen (Session& s, int type) {
+    int i = s.screens.Open ();
+    try {
+        set_plot (s, i, type);
+    } catch (...) {
+        s.screens.Close (i);
+        throw;
+    }
+    return i;
+}
+
+void change_plot (Session& s, int i, int dir) {
+
+    if (! s.screens.Valid (i)) {
         return;
     }
 
-    Parameters par;
-    int old_type = plot_type[i];
+    int old_type = s.screens[i].type;
     int new_type = old_type;
     if (0 == dir) { return; }
     if (dir < 0) {
@@ -68,188 +581,563 @@ void change_plot (BasicPlot **plots, int *plot_type,
     }
     if (old_type == new_type) { return; }
 
-    plot_type[i] = new_type;
+    set_plot (s, i, new_type);
+}
 
-    delete plots[i];
+/* Render the plot on screen [i] offscreen at its current size to [path] */
+bool snapshot (Session& s, int i, const char *path) {
 
-    switch (new_type) {
-        case PLOT_SCATTER:
-            plots[i] = new ScatterPlot (screens[i]);
-            plots[i]->Xlim (minx, maxx);
-            plots[i]->Ylim (miny, maxy);
-            plots[i]->Clear ();
-            plots[i]->Grid ();
-            plots[i]->Plot (data);
-            plots[i]->XTicks ();
-            plots[i]->YTicks ();
-            plots[i]->XLabel ("ScatterPlot X Data");
-            plots[i]->YLabel ("Y Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+    int width = s.screens.Width (i), height = s.screens.Height (i);
+
+    int flags = al_get_new_bitmap_flags ();
+    al_set_new_bitmap_flags (ALLEGRO_MEMORY_BITMAP);
+    ALLEGRO_BITMAP *bmp = al_create_bitmap (width, height);
+    al_set_new_bitmap_flags (flags);
+    if (NULL == bmp) { return false; }
+
+    int type = s.screens[i].type;
+    BasicPlot *plot = new_plot (type, bmp);
+    configure (s, type, plot);
+    draw_plot (plot, type, *s.data, 
+            s.minx, s.maxx, s.miny, s.maxy, s.hud);
+    bool saved = al_save_bitmap (path, bmp);
+
+    delete plot;
+    al_destroy_bitmap (bmp);
+    return saved;
+}
+
+/* Plot type by name or number, -1 if [name] is neither */
+static int parse_plottype (const std::string& name) {
+    int type = str2plottype (name.c_str ());
+    if (-1 == type) {
+        char *end = NULL;
+        type = strtol (name.c_str (), &end, 10);
+        if ('\0' != *end || type < 0 || type >= MAX_PLOT) {
+            return -1;
+        }
+    }
+    return type;
+}
+
+/* Parse "<low> <high>" or "auto" for xlim/ylim */
+static bool parse_limits (std::istringstream& words, bool& fixed,
+        FloatType& low, FloatType& high) {
+    std::string first;
+    double l = 0.0, h = 0.0;
+    if (! (words >> first)) { return false; }
+    if ("auto" == first) {
+        fixed = false;
+        return true;
+    }
+    std::istringstream num (first);
+    if (! (num >> l) || ! (words >> h) || ! (l < h)) { return false; }
+    low = l;
+    high = h;
+    fixed = true;
+    return true;
+}
+
+/* Close window [i]; returns false once there are none left */
+bool close_screen (Session& s, int i) {
+    if (i == s.drag) { s.drag = -1; }
+    s.screens.Close (i);
+    publish (s, false);
+    return 0 < s.screens.Count ();
+}
+
+/*
+ * Execute a controller request (see net/control.h for the protocol)
+ * and return the reply
+ */
+std::string run_command (Session& s, const std::string& command) {
+
+    std::istringstream words (command);
+    std::string verb;
+    words >> verb;
+
+    try {
+        if ("view" == verb) {
+            int screen = -1;
+            std::string name;
+            if (! (words >> screen >> name) || ! s.screens.Valid (screen)) {
+                return "err usage: view <screen> <type>";
+            }
+            int type = parse_plottype (name);
+            if (-1 == type) {
+                return "err unknown plot type " + name;
+            }
+            set_plot (s, screen, type);
+        } else if ("open" == verb) {
+            std::string name ("scatter");
+            words >> name;
+            int type = parse_plottype (name);
+            if (-1 == type) {
+                return "err unknown plot type " + name;
+            }
+            char buff[32];
+            snprintf (buff, sizeof (buff), "ok %d", open_screen (s, type));
+            publish (s, false);
+            return buff;
+        } else if ("close" == verb) {
+            int screen = -1;
+            if (! (words >> screen) || ! s.screens.Valid (screen)) {
+                return "err usage: close <screen>";
+            }
+            if (1 == s.screens.Count ()) {
+                return "err cannot close the last screen";
+            }
+            close_screen (s, screen);
+            return "ok";
+        } else if ("xlim" == verb) {
+            Limits was = limits (s);
+            if (! parse_limits (words, s.fixed_x, s.minx, s.maxx)) {
+                return "err usage: xlim <low> <high> | auto";
+            }
+            push_zoom (s, was);
+            set_limits (s);
+            redraw (s);
+        } else if ("ylim" == verb) {
+            Limits was = limits (s);
+            if (! parse_limits (words, s.fixed_y, s.miny, s.maxy)) {
+                return "err usage: ylim <low> <high> | auto";
+            }
+            push_zoom (s, was);
+            set_limits (s);
+            redraw (s);
+        } else if ("nbins" == verb) {
+            int n = 0;
+            if (! (words >> n) || n <= 0) {
+                return "err usage: nbins <n>";
+            }
+            s.nbins = n;
+            reconfigure (s);
+            redraw (s);
+        } else if ("colormap" == verb) {
+            std::string name, scale;
+            int cmap = -1, cscale = s.cscale;
+            if (words >> name) { cmap = str2colormap (name.c_str ()); }
+            if (words >> scale) { cscale = str2colorscale (scale.c_str ()); }
+            if (-1 == cmap || -1 == cscale) {
+                return "err usage: colormap <name> [linear|log|equalized]";
+            }
+            s.cmap = cmap;
+            s.cscale = cscale;
+            reconfigure (s);
+            redraw (s);
+        } else if ("sd" == verb) {
+            FloatType k = 0.0;
+            if (! (words >> k) || k < 0.0) {
+                return "err usage: sd <k>";
+            }
+            s.nsd = k;
+            reconfigure (s);
+            redraw (s);
+        } else if ("kde" == verb) {
+            std::string rule;
+            int kde = -1;
+            if (words >> rule) { kde = str2bandwidth (rule.c_str ()); }
+            if (-1 == kde) {
+                return "err usage: kde none|silverman|scott";
+            }
+            s.kde = kde;
+            reconfigure (s);
+            redraw (s);
+        } else if ("contours" == verb) {
+            std::vector< FloatType > shares;
+            std::string word;
+            bool none = false, ok = true;
+            while (words >> word) {
+                char *end = NULL;
+                FloatType share = strtod (word.c_str (), &end);
+                if ("none" == word) {
+                    none = true;
+                } else if ('\0' == *end && share > 0.0 && share < 1.0) {
+                    shares.push_back (share);
+                } else {
+                    ok = false;
+                }
+            }
+            if (! ok || none != shares.empty ()) {
+                return "err usage: contours <share>... | none";
+            }
+            s.contours = shares;
+            reconfigure (s);
+            redraw (s);
+        } else if ("fit" == verb) {
+            int degree = -1;
+            if (! (words >> degree) || degree < 0 ||
+                    degree > FIT_MAX_DEGREE) {
+                return "err usage: fit <degree 0-3>";
+            }
+            s.fit = degree;
+            reconfigure (s);
+            redraw (s);
+        } else if ("corr" == verb) {
+            std::string name;
+            int corr = -1;
+            if (words >> name) { corr = str2correlation (name.c_str ()); }
+            if (-1 == corr) {
+                return "err usage: corr pearson|spearman";
+            }
+            s.corr = corr;
+            reconfigure (s);
+            redraw (s);
+        } else if ("columns" == verb) {
+            std::string x, y;
+            if (NULL == s.table) {
+                return "err no table; start with --xcol/--ycol";
+            }
+            if (! (words >> x >> y)) {
+                return "err usage: columns <x> <y>";
+            }
+            int xcol = s.table->Find (x), ycol = s.table->Find (y);
+            if (-1 == xcol || -1 == ycol) {
+                return "err unknown column " + (-1 == xcol ? x : y);
+            }
+            set_columns (s, xcol, ycol);
+            set_facets (s);
+            reconfigure (s);
+            data_changed (s);
+        } else if ("count" == verb) {
+            FloatType xlow = 0.0, xhigh = 0.0, ylow = 0.0, yhigh = 0.0;
+            if (! (words >> xlow >> xhigh >> ylow >> yhigh)) {
+                return "err usage: count <xlow> <xhigh> <ylow> <yhigh>";
+            }
+            /* from the summed-area table: no pass over the points */
+            FloatType n = s.screens.Areas ().Update (*s.data).Count (
+                    Range (xlow, xhigh), Range (ylow, yhigh));
+            char buff[64];
+            snprintf (buff, sizeof (buff), "ok %.0f", n);
+            return buff;
+        } else if ("snapshot" == verb) {
+            int screen = -1;
+            std::string path;
+            if (! (words >> screen >> path) || ! s.screens.Valid (screen)) {
+                return "err usage: snapshot <screen> <png>";
+            }
+            if (! snapshot (s, screen, path.c_str ())) {
+                return "err failed to write " + path;
+            }
+        } else {
+            return "err unknown command " + verb;
+        }
+    } catch (const std::exception& e) {
+        return std::string ("err ") + e.what ();
+    }
+
+    publish (s, false);
+    return "ok";
+}
+
+/*
+ * Apply a single event to the session; [screen] is the index of the
+ * window it was generated for (-1 if none).
+ * Returns false once the session should end.
+ */
+bool handle_event (Session& s, const ALLEGRO_EVENT& event, int screen) {
+
+    /*
+    button_state bstate = BUTTON_UP;
+    Point cursor (0, 0), orig_cursor = cursor;
+    */
+
+    switch (event.type) {
+        case ALLEGRO_EVENT_MOUSE_BUTTON_DOWN:
+            /*
+            cursor.X (event.mouse.x);
+            cursor.Y (event.mouse.y);
+            */
+            /*
+            if (point_in_plot (scatterplot, cursor)) {
+                orig_cursor = cursor;
+                scatterplot.DrawSelection (orig_cursor, cursor);
+                plot_bottom.DrawSelection (orig_cursor, cursor);
+                plot_both.DrawSelection (orig_cursor, cursor);
+                plot_both.Histogram ();
+            }
+            */
+            /*
+            bstate = BUTTON_DOWN;
+            */
+            if (1 == event.mouse.button && navigable (s, screen)) {
+                s.drag = screen;
+                s.panned = false;
+            }
+            s.mouse_x = event.mouse.x;
+            s.mouse_y = event.mouse.y;
             break;
-        case PLOT_BOX_H:
-            plots[i] = new BoxPlot (screens[i]);
-            plots[i]->Xlim (minx, maxx);
-            plots[i]->Ylim (miny, maxy);
-            plots[i]->Clear ();
-            plots[i]->Title ("Boxplot H Title\nA second line");
-            plots[i]->XGrid ();
-            par = plots[i]->Par ();
-            par.side = HORIZONTAL;
-            plots[i]->Plot (data, par);
-            plots[i]->XTicks ();
-            plots[i]->XLabel ("BoxPlot (H) X Data");
-            plots[i]->YLabel ("Y Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case ALLEGRO_EVENT_MOUSE_BUTTON_UP:
+            /*
+            cursor.X (event.mouse.x);
+            cursor.Y (event.mouse.y);
+            */
+            /*
+            if (point_in_plot (scatterplot, cursor)) {
+                if (BUTTON_DOWN == bstate && !(cursor == orig_cursor)) {
+                    scatterplot.DrawSelection (orig_cursor, cursor);
+                    plot_bottom.DrawSelection (orig_cursor, cursor);
+                    plot_both.DrawSelection (orig_cursor, cursor);
+                    plot_both.Histogram ();
+                } else {
+                    scatterplot.ClearSelection ();
+                    plot_bottom.ClearSelection ();
+                    plot_both.ClearSelection ();
+                    plot_both.Histogram ();
+                }
+            }
+            */
+            /*
+            bstate = BUTTON_UP;
+            */
+            s.drag = -1;
             break;
-        case PLOT_BOX_V:
-            plots[i] = new BoxPlot (screens[i]);
-            plots[i]->Xlim (minx, maxx);
-            plots[i]->Ylim (miny, maxy);
-            plots[i]->Clear ();
-            plots[i]->YGrid ();
-            par = plots[i]->Par ();
-            par.side = VERTICAL;
-            plots[i]->Plot (data, par);
-            plots[i]->YTicks ();
-            plots[i]->XLabel ("BoxPlot (V) X Data");
-            plots[i]->YLabel ("Y Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case ALLEGRO_EVENT_MOUSE_AXES:
+            /*
+            cursor.X (event.mouse.x);
+            cursor.Y (event.mouse.y);
+            */
+            /*
+            if (point_in_plot (scatterplot, cursor)) {
+                if (BUTTON_DOWN == bstate) {
+                    scatterplot.DrawSelection (orig_cursor, cursor);
+                    plot_bottom.DrawSelection (orig_cursor, cursor);
+                    plot_both.DrawSelection (orig_cursor, cursor);
+                    plot_both.Histogram ();
+                }
+            }
+            */
+            /*
+             * steps taken against the last absolute position: replays
+             * record x, y and z but not Allegro's dz
+             */
+            zoom (s, screen, event.mouse.x, event.mouse.y, 
+                    event.mouse.z - s.mouse_z, event.any.timestamp);
+            if (0 <= s.drag && screen == s.drag && 
+                    (event.mouse.x != s.mouse_x || 
+                     event.mouse.y != s.mouse_y)) {
+                pan (s, event.mouse.x, event.mouse.y);
+            }
+            s.mouse_x = event.mouse.x;
+            s.mouse_y = event.mouse.y;
+            s.mouse_z = event.mouse.z;
             break;
-        case PLOT_HIST_L:
-            plots[i] = new HistogramPlot (screens[i]);
-            plots[i]->Xlim (0.0, 1.0);
-            plots[i]->Ylim (miny, maxy);
-            plots[i]->Clear ();
-            plots[i]->XGrid ();
-            par = plots[i]->Par ();
-            par.side = SIDE_LEFT;
-            plots[i]->Plot (data, par);
-            plots[i]->XTicks ();
-            plots[i]->XLabel ("Hist (L) X Data");
-            plots[i]->YLabel ("Y Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case ALLEGRO_EVENT_KEY_UP:
+            if (s.shifted && 
+                    (ALLEGRO_KEY_LSHIFT == event.keyboard.keycode || 
+                    ALLEGRO_KEY_RSHIFT == event.keyboard.keycode)) {
+                s.shifted = false;
+            }
             break;
-        case PLOT_HIST_R:
-            plots[i] = new HistogramPlot (screens[i]);
-            plots[i]->Xlim (1.0, 0.0);
-            plots[i]->Ylim (miny, maxy);
-            plots[i]->Clear ();
-            plots[i]->XGrid ();
-            par = plots[i]->Par ();
-            par.side = SIDE_RIGHT;
-            plots[i]->Plot (data, par);
-            plots[i]->XTicks ();
-            plots[i]->XLabel ("Hist (R) X Data");
-            plots[i]->YTicks (par);
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case ALLEGRO_EVENT_KEY_DOWN:
+            if (ALLEGRO_KEY_ESCAPE == event.keyboard.keycode) {
+                return false;
+            } else if (ALLEGRO_KEY_LSHIFT == event.keyboard.keycode) {
+                s.shifted = true;
+            } else if (ALLEGRO_KEY_RSHIFT == event.keyboard.keycode) {
+                s.shifted = true;
+            } else if (ALLEGRO_KEY_N == event.keyboard.keycode) {
+                change_plot (s, screen, s.shifted ? -1 : 1);
+            } else if (ALLEGRO_KEY_O == event.keyboard.keycode) {
+                /* a new window starts out as a copy of this one */
+                try {
+                    open_screen (s, s.screens.Valid (screen) ? 
+                            s.screens[screen].type : PLOT_SCATTER);
+                } catch (const std::exception& e) {
+                    fprintf (stderr, "Failed to open a window: %s\n", 
+                            e.what ());
+                }
+                publish (s, false);
+            } else if (ALLEGRO_KEY_W == event.keyboard.keycode) {
+                return close_screen (s, screen);
+            } else if (ALLEGRO_KEY_Z == event.keyboard.keycode) {
+                zoom_history (s, s.shifted ? 1 : -1);
+            } else if (ALLEGRO_KEY_A == event.keyboard.keycode) {
+                /* back to limits that follow the data */
+                push_zoom (s, limits (s));
+                s.fixed_x = s.fixed_y = false;
+                set_limits (s);
+                invalidate (s);
+                publish (s, false);
+            } else if (ALLEGRO_KEY_H == event.keyboard.keycode) {
+                s.hud = ! s.hud;
+                redraw (s);
+                publish (s, false);
+            }
             break;
-        case PLOT_HIST_T:
-            plots[i] = new HistogramPlot (screens[i]);
-            plots[i]->Xlim (minx, maxx);
-            plots[i]->Ylim (1.0, 0.0);
-            plots[i]->Clear ();
-            plots[i]->YGrid ();
-            par = plots[i]->Par ();
-            par.side = SIDE_TOP;
-            plots[i]->Plot (data, par);
-            plots[i]->YTicks ();
-            par.side = SIDE_TOP;
-            plots[i]->XTicks (par);
-            plots[i]->XLabel ("Hist (T) X Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case INGEST_EVENT:
+            if (NULL != s.ingest && 0 < s.ingest->Drain (*s.data)) {
+                data_changed (s);
+            }
             break;
-        case PLOT_HIST_B:
-            plots[i] = new HistogramPlot (screens[i]);
-            plots[i]->Xlim (minx, maxx);
-            plots[i]->Ylim (0, 1.0);
-            plots[i]->Clear ();
-            plots[i]->YGrid ();
-            par = plots[i]->Par ();
-            par.side = SIDE_BOTTOM;
-            plots[i]->Plot (data, par);
-            plots[i]->YTicks ();
-            plots[i]->XTicks ();
-            plots[i]->XLabel ("Hist (B) X Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case ALLEGRO_EVENT_TIMER:
+            if (event.timer.source == s.expiry && 0 < s.data->Expire ()) {
+                data_changed (s);
+            }
             break;
-        case PLOT_HEXBIN:
-            plots[i] = new HexBinPlot (screens[i]);
-            plots[i]->Xlim (minx, maxx);
-            plots[i]->Ylim (miny, maxy);
-            plots[i]->Clear ();
-            plots[i]->Plot (data);
-            plots[i]->YTicks ();
-            plots[i]->XTicks ();
-            plots[i]->XLabel ("X Data");
-            plots[i]->YLabel ("Y Data");
-            plots[i]->Title ("Example Hexbin Data\nMultiple Modes");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case SHM_EVENT:
+            if (NULL != s.shm && 0 < s.shm->Drain (*s.data)) {
+                data_changed (s);
+            }
             break;
-        case PLOT_LINE:
-            plots[i] = new LinePlot (screens[i]);
-            plots[i]->Xlim (minx, maxx);
-            plots[i]->Ylim (miny, maxy);
-            plots[i]->Clear ();
-            plots[i]->XGrid ();
-            plots[i]->YGrid ();
-            plots[i]->Plot (data);
-            plots[i]->XTicks ();
-            plots[i]->YTicks ();
-            plots[i]->XLabel ("LinePlot X Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case FOLLOW_EVENT:
+            if (NULL != s.follow && 0 < s.follow->Drain (*s.data)) {
+                data_changed (s);
+            }
             break;
-        case PLOT_ECDF_H:
-            plots[i] = new ECDFPlot (screens[i]);
-            plots[i]->Clear ();
-            plots[i]->Plot (data);
-            plots[i]->YTicks ();
-            plots[i]->XTicks ();
-            plots[i]->XLabel ("ECDF Y Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case CONTROL_EVENT:
+            if (NULL != s.control) {
+                s.control->Service ([&s](const std::string& command) {
+                        return run_command (s, command); 
+                    });
+            }
             break;
-        case PLOT_ECDF_V:
-            plots[i] = new ECDFPlot (screens[i]);
-            plots[i]->Clear ();
-            par.side = VERTICAL;
-            plots[i]->Plot (data, par);
-            plots[i]->YTicks ();
-            plots[i]->XTicks ();
-            plots[i]->YLabel ("ECDF X Data");
-            plots[i]->Box ();
-            plots[i]->Update ();
+        case ALLEGRO_EVENT_DISPLAY_CLOSE:
+            return close_screen (s, screen);
+        case ALLEGRO_EVENT_DISPLAY_RESIZE:
+            /* drawn by refresh () from the aggregates the plot has */
+            s.screens.Resize (screen);
             break;
         default:
-            throw GeneralException("Unknown plot type", __FILE__, __LINE__);
+            /* */
+            break;
+    }
+
+    return true;
+}
+
+/*
+ * Feed a recorded session through handle_event () against offscreen
+ * targets, printing the processing latency of each event to stdout.
+ * Returns non-zero if the p99 latency exceeds [budget] us (if > 0).
+ */
+int replay (Session& s, const std::vector< RecordedEvent >& events, 
+        double budget) {
+
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector< double > latency;
+    std::vector< RecordedEvent >::const_iterator EIT = events.begin (),
+        EEND = events.end ();
+
+    printf ("# event time type screen latency_us\n");
+    for (; EIT != EEND; ++EIT) {
+        ALLEGRO_EVENT event = toEvent (*EIT);
+        Clock::time_point start = Clock::now ();
+        bool more = handle_event (s, event, EIT->screen);
+        refresh (s);
+        std::chrono::duration< double, std::micro > d = Clock::now () - start;
+        latency.push_back (d.count ());
+        printf ("%zu %0.6f %s %d %0.1f\n", latency.size () - 1, EIT->time,
+                eventtype2str (EIT->type), EIT->screen, d.count ());
+        if (! more) { break; }
     }
+
+    if (latency.empty ()) { return 0; }
+
+    std::sort (latency.begin (), latency.end ());
+    double p50 = latency[(latency.size () - 1) / 2];
+    double p99 = latency[static_cast< std::size_t >(
+            0.99 * (latency.size () - 1) + 0.5)];
+    fprintf (stderr, "replayed %zu events: p50 %0.1fus p99 %0.1fus "
+            "max %0.1fus\n", latency.size (), p50, p99, latency.back ());
+
+    if (budget > 0.0 && p99 > budget) {
+        fprintf (stderr, "p99 latency over budget of %0.1fus\n", budget);
+        return 1;
+    }
+    return 0;
 }
 
-void load (const char *csv, std::vector< Point > &pts) {
-    FILE *fin = fopen (csv, "rb");
-    if (NULL == fin) { return; }
-    while (! ferror (fin) && ! feof (fin)) {
-        FloatType x = 0, y = 0;
-        if (2 != fscanf (fin, "%lf,%lf", &x, &y)) {
-            return;
+/*
+ * Draw every plot type offscreen onto the first target and save each
+ * as <dir>/<type>.png. Plots that refuse the data (e.g. too few
+ * points) are reported and skipped. Returns the number of failures.
+ */
+int render (Session& s, const char *dir) {
+
+    int failed = 0;
+    if (-1 == mkdir (dir, 0755) && EEXIST != errno) {
+        fprintf (stderr, "Failed to create %s: %s\n", dir, strerror (errno));
+        return MAX_PLOT;
+    }
+
+    for (int type = 0; type < MAX_PLOT; ++type) {
+        try {
+            set_plot (s, 0, type);
+        } catch (const std::exception& e) {
+            fprintf (stderr, "%s: %s\n", plottype2str (type), e.what ());
+            continue;
+        }
+        std::string path = std::string (dir) + "/" + plottype2str (type) + ".png";
+        if (! al_save_bitmap (path.c_str (), s.screens[0].target)) {
+            fprintf (stderr, "Failed to write %s\n", path.c_str ());
+            ++failed;
         }
-        pts.push_back (Point (x,y));
-        if (feof (fin)) { break; }
     }
+    return failed;
 }
 
 void usage (const char *prog) {
-    fprintf (stderr, "USAGE: %s <csv>\n", prog);
+    fprintf (stderr, "USAGE: %s [options] <csv>\n", prog);
     fprintf (stderr, "-------------------\n");
-    fprintf (stderr, " csv  CSV file with pairs of points\n");
+    fprintf (stderr, " csv          CSV file with pairs of points\n");
+    fprintf (stderr, " -x, --xcol <col>\n");
+    fprintf (stderr, " -y, --ycol <col>\n");
+    fprintf (stderr, "              Plot the column named (or numbered from 1)\n");
+    fprintf (stderr, "              <col> of a CSV with any number of columns;\n");
+    fprintf (stderr, "              only the plotted columns are parsed\n");
+    fprintf (stderr, " -k, --splom <col,col,...>\n");
+    fprintf (stderr, "              Columns of the scatterplot and correlation\n");
+    fprintf (stderr, "              matrix views\n");
+    fprintf (stderr, " -g, --facet <col>\n");
+    fprintf (stderr, "              Split the facets view by the values of <col>\n");
+    fprintf (stderr, " -G, --facet-plot <type>\n");
+    fprintf (stderr, "              Plot type of each facet (default scatter)\n");
+    fprintf (stderr, " -s, --stats  Dump timing/cache counters to stderr on exit\n");
+    fprintf (stderr, " -t, --trace <json>\n");
+    fprintf (stderr, "              Record a Chrome trace to <json>, written\n");
+    fprintf (stderr, "              on exit or when sent SIGUSR1\n");
+    fprintf (stderr, " -r, --record <events>\n");
+    fprintf (stderr, "              Record keyboard/mouse/window events\n");
+    fprintf (stderr, " -p, --replay <events>\n");
+    fprintf (stderr, "              Replay recorded events headless and report\n");
+    fprintf (stderr, "              per-event latency on stdout\n");
+    fprintf (stderr, " -b, --budget <us>\n");
+    fprintf (stderr, "              With --replay, fail if p99 latency exceeds <us>\n");
+    fprintf (stderr, " -R, --render <dir>\n");
+    fprintf (stderr, "              Render every plot type offscreen to <dir>/*.png\n");
+    fprintf (stderr, " -l, --listen <endpoint>\n");
+    fprintf (stderr, "              Bind a 0MQ PULL socket accepting batches of\n");
+    fprintf (stderr, "              x/y doubles to append to the data\n");
+    fprintf (stderr, " -S, --subscribe <endpoint>\n");
+    fprintf (stderr, "              As --listen but connect a SUB socket\n");
+    fprintf (stderr, " -f, --follow Keep reading rows appended to <csv>\n");
+    fprintf (stderr, " -w, --window <n>\n");
+    fprintf (stderr, "              Only keep the latest <n> points\n");
+    fprintf (stderr, " -W, --window-secs <s>\n");
+    fprintf (stderr, "              Only keep points added in the last <s> seconds\n");
+    fprintf (stderr, " -m, --shm <name>\n");
+    fprintf (stderr, "              Create shared memory ring /<name> for a local\n");
+    fprintf (stderr, "              producer (see include/net/shmring.h)\n");
+    fprintf (stderr, " -c, --control <endpoint>\n");
+    fprintf (stderr, "              Bind a 0MQ REP socket for remote commands\n");
+    fprintf (stderr, "\n");
+    fprintf (stderr, " -n, --screens <n>\n");
+    fprintf (stderr, "              Open <n> windows at startup (default %d)\n",
+            DEFAULT_SCREENS);
+    fprintf (stderr, " -C, --colormap <name>\n");
+    fprintf (stderr, "              Color density plots white (default), viridis,\n");
+    fprintf (stderr, "              magma, gray or diverging\n");
+    fprintf (stderr, " -L, --color-scale <scale>\n");
+    fprintf (stderr, "              Scale counts to colors linear (default), log\n");
+    fprintf (stderr, "              or equalized\n");
+    fprintf (stderr, "\n");
+    fprintf (stderr, "Keys: N/Shift-N cycle plot, O open a window, W close\n");
+    fprintf (stderr, "      this one, H toggle HUD, Esc quit\n");
+    fprintf (stderr, "Mouse: wheel zooms, drag pans the data axes of any\n");
+    fprintf (stderr, "      plot but the matrices; Z/Shift-Z back/forward\n");
+    fprintf (stderr, "      through zooms, A auto limits\n");
     fprintf (stderr, "\n");
     exit(42);
 }
@@ -266,27 +1154,163 @@ bool valid_file (const char *path) {
 int main (int argc, char **argv) {
 
     ALLEGRO_EVENT_QUEUE *events = NULL;
-    ALLEGRO_DISPLAY *screens[3] = { NULL };
+    Session session;
+    EventRecorder recorder;
+    std::vector< RecordedEvent > recorded;
 
-    bool shifted = false;
-    int adapter_count = 0;
+    bool dump_stats = false, follow_csv = false;
+    int adapter_count = 0, num_screens = DEFAULT_SCREENS;
     int monitor_x = 0, monitor_y = 0, screen_x = 0, screen_y = 0;
-    FloatType minx = 0, miny = 0, maxx = 0, maxy = 0;
-    const char *csv = NULL;
-    int plot_type[3] = {0};
-    BasicPlot *plots[3] = {0};
+    double budget = 0.0, window_secs = 0.0;
+    long window = 0;
+    const char *csv = NULL, *record_path = NULL, *replay_path = NULL;
+    const char *render_dir = NULL, *ingest_endpoint = NULL;
+    const char *control_endpoint = NULL, *shm_name = NULL;
+    const char *xcol = NULL, *ycol = NULL, *splom = NULL, *facet = NULL;
+    const char *facet_plot = NULL, *cmap = NULL, *cscale = NULL;
+    IngestMode ingest_mode = INGEST_PULL;
 
-    /*
-    button_state bstate = BUTTON_UP;
-    */
+    static struct option long_opts[] = {
+        { "stats", no_argument, NULL, 's' },
+        { "trace", required_argument, NULL, 't' },
+        { "record", required_argument, NULL, 'r' },
+        { "replay", required_argument, NULL, 'p' },
+        { "budget", required_argument, NULL, 'b' },
+        { "render", required_argument, NULL, 'R' },
+        { "listen", required_argument, NULL, 'l' },
+        { "subscribe", required_argument, NULL, 'S' },
+        { "control", required_argument, NULL, 'c' },
+        { "follow", no_argument, NULL, 'f' },
+        { "shm", required_argument, NULL, 'm' },
+        { "window", required_argument, NULL, 'w' },
+        { "window-secs", required_argument, NULL, 'W' },
+        { "xcol", required_argument, NULL, 'x' },
+        { "ycol", required_argument, NULL, 'y' },
+        { "splom", required_argument, NULL, 'k' },
+        { "facet", required_argument, NULL, 'g' },
+        { "facet-plot", required_argument, NULL, 'G' },
+        { "screens", required_argument, NULL, 'n' },
+        { "colormap", required_argument, NULL, 'C' },
+        { "color-scale", required_argument, NULL, 'L' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
 
-    if (2 != argc) {
-        char prog[1024] = {0};
-        strncpy (prog, argv[0], 1024);
+    char prog[1024] = {0};
+    strncpy (prog, argv[0], 1023);
+
+    int opt = 0;
+    while (-1 != (opt = getopt_long (argc, argv, "st:r:p:b:R:l:S:c:fw:W:m:x:y:k:g:G:n:C:L:h", 
+                    long_opts, NULL))) {
+        switch (opt) {
+            case 's':
+                dump_stats = true;
+                break;
+            case 't':
+                traceStart (optarg);
+                signal (SIGUSR1, request_trace);
+                break;
+            case 'r':
+                record_path = optarg;
+                break;
+            case 'p':
+                replay_path = optarg;
+                break;
+            case 'b':
+                budget = atof (optarg);
+                break;
+            case 'R':
+                render_dir = optarg;
+                break;
+            case 'l':
+                ingest_endpoint = optarg;
+                ingest_mode = INGEST_PULL;
+                break;
+            case 'S':
+                ingest_endpoint = optarg;
+                ingest_mode = INGEST_SUB;
+                break;
+            case 'c':
+                control_endpoint = optarg;
+                break;
+            case 'f':
+                follow_csv = true;
+                break;
+            case 'm':
+                shm_name = optarg;
+                break;
+            case 'w':
+                window = static_cast< long >(atof (optarg));
+                break;
+            case 'W':
+                window_secs = atof (optarg);
+                break;
+            case 'x':
+                xcol = optarg;
+                break;
+            case 'y':
+                ycol = optarg;
+                break;
+            case 'k':
+                splom = optarg;
+                break;
+            case 'g':
+                facet = optarg;
+                break;
+            case 'G':
+                facet_plot = optarg;
+                break;
+            case 'n':
+                num_screens = atoi (optarg);
+                break;
+            case 'C':
+                cmap = optarg;
+                break;
+            case 'L':
+                cscale = optarg;
+                break;
+            default:
+                usage (basename (prog));
+        }
+    }
+
+    bool columnar = NULL != xcol || NULL != ycol || NULL != splom ||
+        NULL != facet;
+
+    if (optind + 1 != argc || (NULL != record_path && NULL != replay_path) ||
+            window < 0 || window_secs < 0.0 || num_screens < 1 ||
+            ((NULL != render_dir || NULL != ingest_endpoint ||
+              NULL != control_endpoint || NULL != shm_name || follow_csv) && 
+             (NULL != record_path || NULL != replay_path)) ||
+            (NULL != render_dir && (NULL != ingest_endpoint || 
+                NULL != control_endpoint || NULL != shm_name || follow_csv)) ||
+            /* a table view is read-only */
+            (columnar && (NULL != ingest_endpoint ||
+                NULL != shm_name || follow_csv || 0 < window || 
+                0.0 < window_secs))) {
+        usage (basename (prog));
+    }
+
+    if (NULL != facet_plot) {
+        session.facet_type = str2plottype (facet_plot);
+        if (-1 == session.facet_type || PLOT_SPLOM == session.facet_type ||
+                PLOT_FACETS == session.facet_type ||
+                PLOT_CORRELATION == session.facet_type) {
+            fprintf (stderr, "Cannot facet plot type %s\n", facet_plot);
+            usage (basename (prog));
+        }
+    }
+
+    if (NULL != cmap && -1 == (session.cmap = str2colormap (cmap))) {
+        fprintf (stderr, "Unknown colormap %s\n", cmap);
+        usage (basename (prog));
+    }
+    if (NULL != cscale && -1 == (session.cscale = str2colorscale (cscale))) {
+        fprintf (stderr, "Unknown color scale %s\n", cscale);
         usage (basename (prog));
     }
 
-    csv = argv[1];
+    csv = argv[optind];
 
     if (! valid_file (csv)) {
         return 1;
@@ -299,82 +1323,159 @@ int main (int argc, char **argv) {
         return 1;
     }
 
-    /* TODO: get aspect ratio to force/enable square graphs */
-    adapter_count = al_get_num_video_adapters ();
-    for (int i = 0; i < adapter_count; ++i) {
-        ALLEGRO_MONITOR_INFO minfo;
-        al_get_monitor_info (i, &minfo);
-        /* grab main display dims */
-        if (0 == minfo.x1 && 0 == minfo.y1) {
-            monitor_x = minfo.x2;
-            monitor_y = minfo.y2;
-            screen_x = (monitor_x / 2) * 0.95;
-            screen_y = (monitor_y / 2) * 0.95;
+    if (NULL != render_dir) {
+        screen_x = RENDER_WIDTH;
+        screen_y = RENDER_HEIGHT;
+    } else if (NULL != replay_path) {
+        /* replay at the window size of the recording */
+        if (! loadEvents (replay_path, screen_x, screen_y, recorded)) {
+            return 1;
+        }
+    } else {
+        /* TODO: get aspect ratio to force/enable square graphs */
+        adapter_count = al_get_num_video_adapters ();
+        for (int i = 0; i < adapter_count; ++i) {
+            ALLEGRO_MONITOR_INFO minfo;
+            al_get_monitor_info (i, &minfo);
+            /* grab main display dims */
+            if (0 == minfo.x1 && 0 == minfo.y1) {
+                monitor_x = minfo.x2;
+                monitor_y = minfo.y2;
+                screen_x = (monitor_x / 2) * 0.95;
+                screen_y = (monitor_y / 2) * 0.95;
+            }
         }
     }
 
-    /*
-    Point cursor (0, 0), orig_cursor = cursor;
-    */
-
-    al_set_new_display_flags (ALLEGRO_NOFRAME);
-
     al_init_primitives_addon ();
-    al_install_keyboard ();
-    al_install_mouse ();
     al_init_font_addon ();
     al_init_ttf_addon ();
+    al_init_image_addon ();
 
-    screens[0] = al_create_display (screen_x, screen_y);
-    screens[1] = al_create_display (screen_x, screen_y);
-    screens[2] = al_create_display (screen_x, screen_y);
+    if (NULL != replay_path || NULL != render_dir) {
+        al_set_new_bitmap_flags (ALLEGRO_MEMORY_BITMAP);
+        session.screens.Offscreen (screen_x, screen_y);
+    } else {
+        al_set_new_display_flags (ALLEGRO_RESIZABLE);
 
-    if (! screens[0] || ! screens[1] || ! screens[2]) {
-        fprintf (stderr, "Failed to create displays\n");
-        return 1;
+        al_install_keyboard ();
+        al_install_mouse ();
+
+        session.screens.Displays (screen_x, screen_y, monitor_x, monitor_y);
     }
 
-    al_set_window_position (screens[0], monitor_x - screen_x, 
-            monitor_y - 2 * screen_y);
-    al_set_window_position (screens[1], monitor_x - screen_x, 
-            monitor_y - screen_y);
-    al_set_window_position (screens[2], monitor_x - 2 * screen_x, 
-            monitor_y - screen_y);
+    /* --render draws every type in turn on the one target */
+    if (NULL != render_dir) {
+        num_screens = 1;
+    }
+    for (int i = 0; i < num_screens; ++i) {
+        try {
+            session.screens.Open ();
+        } catch (const std::exception&) {
+            fprintf (stderr, "Failed to create %s\n", 
+                    (NULL == render_dir && NULL == replay_path) ? 
+                    "displays" : "offscreen targets");
+            return 1;
+        }
+    }
 
     std::vector< Point > xs;
-    load (csv, xs);
+    Follow follow (csv);
+    Table table (csv);
+    Groups groups;
+    if (! columnar) {
+        ScopedTimer timer (sessionStats (), STAGE_LOAD);
+        TRACE_SCOPE ("load");
+        if (follow_csv) {
+            follow.Read (xs);
+        } else {
+            load (csv, xs);
+        }
+    }
     Dataset data(xs);
+    if (0 < window || 0.0 < window_secs) {
+        data.Window (window, window_secs);
+    }
+    session.data = &data;
+
+    if (columnar) {
+        if (! table.Open ()) {
+            fprintf (stderr, "Failed to read %s\n", csv);
+            return 1;
+        }
+        int x = (NULL == xcol) ? 0 : table.Find (xcol);
+        int y = (NULL == ycol) ? 1 : table.Find (ycol);
+        if (-1 == x || -1 == y || y >= static_cast< int >(table.Columns ())) {
+            fprintf (stderr, "No column %s in %s\n", 
+                    (-1 == x) ? xcol : (NULL == ycol ? "2" : ycol), csv);
+            return 1;
+        }
+        std::string names (NULL == splom ? "" : splom), name;
+        std::istringstream list (names);
+        while (std::getline (list, name, ',')) {
+            int c = table.Find (name);
+            if (-1 == c) {
+                fprintf (stderr, "No column %s in %s\n", name.c_str (), csv);
+                return 1;
+            }
+            session.splom.push_back (c);
+        }
+        session.data = NULL;
+        session.table = &table;
+        set_columns (session, x, y);
+        {
+            ScopedTimer timer (sessionStats (), STAGE_LOAD);
+            table.Load (session.splom);
+        }
+
+        if (NULL != facet) {
+            session.facet = table.Find (facet);
+            if (-1 == session.facet) {
+                fprintf (stderr, "No column %s in %s\n", facet, csv);
+                return 1;
+            }
+            session.groups = &groups;
+            try {
+                set_facets (session);
+            } catch (const std::exception&) {
+                fprintf (stderr, "More than %d values in %s\n", 
+                        MAX_FACETS, facet);
+                return 1;
+            }
+        }
+    }
+    sessionStats ().Points (session.data->Size ());
+
+    /* a stream may start from an empty file and fill it in later */
+    bool streaming = NULL != ingest_endpoint || NULL != shm_name ||
+        follow_csv;
+    if (0 == session.data->Size () && ! streaming) {
+        fprintf (stderr, "No points in %s\n", csv);
+        return 1;
+    }
+
+    set_limits (session);
 
-    std::vector< Point >::const_iterator PIT = xs.begin (), PEND = xs.end ();
-    minx = maxx = PIT->X ();
-    miny = maxy = PIT->Y ();
-    for (; PIT != PEND; ++PIT) {
-        minx = std::min (minx, PIT->X ());
-        maxx = std::max (maxx, PIT->X ());
-        miny = std::min (miny, PIT->Y ());
-        maxy = std::max (maxy, PIT->Y ());
-    }
-
-    /* Add buffers outside data so points dont appear on the plot edge */
-    minx -= data.XDomain ().Distance () * 0.05;
-    maxx += data.XDomain ().Distance () * 0.05;
-    miny -= data.YDomain ().Distance () * 0.05;
-    maxy += data.YDomain ().Distance () * 0.05;
-
-    for (int j = 0; j < 3; ++j) {
-        plots[j] = new ScatterPlot (screens[j]);
-        if (NULL == plots[j]) {
-            throw GeneralException ("Memory error", __FILE__, __LINE__);
+    if (NULL != render_dir) {
+        return render (session, render_dir) ? 1 : 0;
+    }
+
+    for (int i = 0; i < num_screens; ++i) {
+        set_plot (session, i, PLOT_SCATTER);
+    }
+
+    if (NULL != replay_path) {
+        int rc = replay (session, recorded, budget);
+        if (dump_stats) {
+            dumpStats (stderr);
         }
-        plots[j]->Xlim (minx, maxx);
-        plots[j]->Ylim (miny, maxy);
-        plots[j]->Clear ();
-        plots[j]->Grid ();
-        plots[j]->Plot (data);
-        plots[j]->YTicks ();
-        plots[j]->XTicks ();
-        plots[j]->Box ();
-        plots[j]->Update ();
+        traceWrite ();
+        return rc;
+    }
+
+    if (NULL != record_path && 
+            ! recorder.Open (record_path, screen_x, screen_y)) {
+        return 1;
     }
 
     events = al_create_event_queue ();
@@ -383,13 +1484,56 @@ int main (int argc, char **argv) {
         return 1;
     }
 
-    al_register_event_source (events, al_get_display_event_source (screens[0]));
-    al_register_event_source (events, al_get_display_event_source (screens[1]));
-    al_register_event_source (events, al_get_display_event_source (screens[2]));
+    session.screens.Listen (events);
 
     al_register_event_source (events, al_get_keyboard_event_source ());
     al_register_event_source (events, al_get_mouse_event_source ());
 
+    Ingest ingest;
+    if (NULL != ingest_endpoint) {
+        if (! ingest.Start (ingest_endpoint, ingest_mode)) {
+            return 1;
+        }
+        session.ingest = &ingest;
+        al_register_event_source (events, ingest.EventSource ());
+    }
+
+    ShmIngest shm;
+    if (NULL != shm_name) {
+        if (! shm.Start (shm_name)) {
+            return 1;
+        }
+        session.shm = &shm;
+        al_register_event_source (events, shm.EventSource ());
+    }
+
+    ALLEGRO_TIMER *expiry = NULL;
+    if (0.0 < window_secs) {
+        /* age out points even when nothing new arrives */
+        expiry = al_create_timer (std::min (1.0, window_secs / 4.0));
+        al_register_event_source (events, al_get_timer_event_source (expiry));
+        al_start_timer (expiry);
+        session.expiry = expiry;
+    }
+
+    if (follow_csv) {
+        if (! follow.Start ()) {
+            return 1;
+        }
+        session.follow = &follow;
+        al_register_event_source (events, follow.EventSource ());
+    }
+
+    Control control;
+    if (NULL != control_endpoint) {
+        if (! control.Start (control_endpoint)) {
+            return 1;
+        }
+        session.control = &control;
+        al_register_event_source (events, control.EventSource ());
+        publish (session, true);
+    }
+
 
     /*
      * FIXME: This should happen on every event in the system
@@ -399,123 +1543,54 @@ int main (int argc, char **argv) {
     while (true) {
 
         ALLEGRO_EVENT event;
-        al_wait_for_event (events, &event);
+        if (traceEnabled ()) {
+            /* wake up periodically so SIGUSR1 dumps are serviced */
+            if (trace_requested) {
+                trace_requested = 0;
+                traceWrite ();
+            }
+            if (! al_wait_for_event_timed (events, &event, 0.25)) {
+                continue;
+            }
+        } else {
+            al_wait_for_event (events, &event);
+        }
 
-        /* Not the best place to have this */
-        /*
-        scatterplot.Clear ();
-        */
-        /*
-        plot_bottom.Clear ();
-        plot_both.Clear ();
-        */
+        TRACE_SCOPE ("event loop");
 
 next_event:
-        switch (event.type) {
-            case ALLEGRO_EVENT_MOUSE_BUTTON_DOWN:
-                /*
-                cursor.X (event.mouse.x);
-                cursor.Y (event.mouse.y);
-                */
-                /*
-                if (point_in_plot (scatterplot, cursor)) {
-                    orig_cursor = cursor;
-                    scatterplot.DrawSelection (orig_cursor, cursor);
-                    plot_bottom.DrawSelection (orig_cursor, cursor);
-                    plot_both.DrawSelection (orig_cursor, cursor);
-                    plot_both.Histogram ();
-                }
-                */
-                /*
-                bstate = BUTTON_DOWN;
-                */
-                break;
-            case ALLEGRO_EVENT_MOUSE_BUTTON_UP:
-                /*
-                cursor.X (event.mouse.x);
-                cursor.Y (event.mouse.y);
-                */
-                /*
-                if (point_in_plot (scatterplot, cursor)) {
-                    if (BUTTON_DOWN == bstate && !(cursor == orig_cursor)) {
-                        scatterplot.DrawSelection (orig_cursor, cursor);
-                        plot_bottom.DrawSelection (orig_cursor, cursor);
-                        plot_both.DrawSelection (orig_cursor, cursor);
-                        plot_both.Histogram ();
-                    } else {
-                        scatterplot.ClearSelection ();
-                        plot_bottom.ClearSelection ();
-                        plot_both.ClearSelection ();
-                        plot_both.Histogram ();
-                    }
-                }
-                */
-                /*
-                bstate = BUTTON_UP;
-                */
-                break;
-            case ALLEGRO_EVENT_MOUSE_AXES:
-                /*
-                cursor.X (event.mouse.x);
-                cursor.Y (event.mouse.y);
-                */
-                /*
-                if (point_in_plot (scatterplot, cursor)) {
-                    if (BUTTON_DOWN == bstate) {
-                        scatterplot.DrawSelection (orig_cursor, cursor);
-                        plot_bottom.DrawSelection (orig_cursor, cursor);
-                        plot_both.DrawSelection (orig_cursor, cursor);
-                        plot_both.Histogram ();
-                    }
-                }
-                */
-                break;
-            case ALLEGRO_EVENT_KEY_UP:
-                if (shifted && 
-                        (ALLEGRO_KEY_LSHIFT == event.keyboard.keycode || 
-                        ALLEGRO_KEY_LSHIFT == event.keyboard.keycode)) {
-                    shifted = false;
-                }
-                break;
-            case ALLEGRO_EVENT_KEY_DOWN:
-                if (ALLEGRO_KEY_ESCAPE == event.keyboard.keycode) {
-                    goto outly;
-                } else if (ALLEGRO_KEY_LSHIFT == event.keyboard.keycode) {
-                    shifted = true;
-                } else if (ALLEGRO_KEY_RSHIFT == event.keyboard.keycode) {
-                    shifted = true;
-                } else if (ALLEGRO_KEY_N == event.keyboard.keycode) {
-                    change_plot (plots, plot_type, screens, 
-                            event.keyboard.display, 
-                            data, minx, maxx, miny, maxy, shifted ? -1 : 1);
-                }
-                break;
-            case ALLEGRO_EVENT_DISPLAY_CLOSE:
-                goto outly;
-                break;
-            default:
-                /* */
-                break;
+        int screen = session.screens.Find (eventDisplay (event));
+        recorder.Record (event, screen);
+        if (! handle_event (session, event, screen)) {
+            goto outly;
         }
 
         if (! al_is_event_queue_empty (events)) {
             al_get_next_event (events, &event);
             goto next_event;
         }
-
-
-        /*
-        scatterplot.Update ();
-        plot_bottom.Update ();
-        plot_both.Update ();
-         */
+        refresh (session);
     }
 
 outly:
 
-    /* TODO: Display cleanup etrc. */
-    return 0;
-}
+    if (NULL != expiry) {
+        al_destroy_timer (expiry);
+    }
 
+    control.Stop ();
+    follow.Stop ();
+    shm.Stop ();
+    ingest.Stop ();
 
+    if (dump_stats) {
+        dumpStats (stderr);
+    }
+
+    traceWrite ();
 
+    /* the windows outlive the queue; their sources must not */
+    session.screens.Listen (NULL);
+    al_destroy_event_queue (events);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#!/bin/sh
+#
+# Golden image check of the plot rendering.
+#
+# Renders every plot type for each data/*.csv offscreen with
+# 'tandem --render' and compares them against the reference images in
+# golden/<dataset>/ using tools/imgdiff. Mismatches leave a diff image
+# next to the new render in $OUT.
+#
+#   tools/golden.sh record   # (re)generate the references
+#   tools/golden.sh [check]  # compare against them
+#
+# 'make golden' and 'make check' build tandem and tools/imgdiff and run
+# these. Tolerances can be overridden with IMGDIFF_ARGS (see
+# tools/imgdiff -h).
+
+MODE=${1:-check}
+OUT=${OUT:-golden.out}
+IMGDIFF_ARGS=${IMGDIFF_ARGS:-"-t 0.1 -m 0.001"}
+
+case "$MODE" in
+    record|check) ;;
+    *) echo "USAGE: $0 [record|check]" >&2; exit 2 ;;
+esac
+
+if [ check = "$MODE" ] && [ ! -d golden ]; then
+    echo "FAIL: no references in golden/, record them with 'make golden'" >&2
+    exit 1
+fi
+
+fail=0
+for csv in data/*.csv; do
+    name=$(basename "$csv" .csv)
+    mkdir -p "$OUT"
+    if ! ./tandem --render "$OUT/$name" "$csv"; then
+        echo "FAIL $name: render failed" >&2
+        fail=1
+        continue
+    fi
+    for png in "$OUT/$name"/*.png; do
+        case "$png" in *.diff.png) continue ;; esac
+        ref="golden/$name/$(basename "$png")"
+        if [ record = "$MODE" ]; then
+            mkdir -p "golden/$name"
+            cp "$png" "$ref"
+        elif [ ! -f "$ref" ]; then
+            echo "FAIL $name: no reference $ref" >&2
+            fail=1
+        elif ! tools/imgdiff $IMGDIFF_ARGS -d "${png%.png}.diff.png" "$ref" "$png"; then
+            echo "FAIL $name: see ${png%.png}.diff.png" >&2
+            fail=1
+        fi
+    done
+done
+
+if [ record = "$MODE" ]; then
+    echo "references written to golden/"
+elif [ 0 = "$fail" ]; then
+    echo "all renders match"
+fi
+exit $fail
@@ -0,0 +1,167 @@
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <allegro5/allegro.h>
+#include <allegro5/allegro_image.h>
+
+extern "C" {
+#include <getopt.h>
+}
+
+/*
+ * Perceptual image comparison for the rendered plots.
+ *
+ * Pixels are compared in YIQ space (weighted towards luma, as the eye
+ * is) and a pixel only counts as different if its distance exceeds
+ * [threshold] of the largest possible distance. The images match if
+ * the fraction of different pixels is no more than [max_fraction].
+ *
+ * Exit status: 0 match, 1 mismatch, 2 error
+ */
+
+static void usage (const char *prog) {
+    fprintf (stderr, "USAGE: %s [options] <expected.png> <actual.png>\n", prog);
+    fprintf (stderr, "-------------------\n");
+    fprintf (stderr, " -t, --threshold <f>  Per pixel color tolerance 0..1 (default 0.1)\n");
+    fprintf (stderr, " -m, --max <f>        Fraction of pixels allowed to differ (default 0)\n");
+    fprintf (stderr, " -d, --diff <png>     Write a diff image highlighting mismatches\n");
+    fprintf (stderr, "\n");
+    exit (2);
+}
+
+static void yiq (ALLEGRO_COLOR c, float& y, float& i, float& q) {
+    /* blend onto black so transparency is compared as it is displayed */
+    float r = c.r * c.a, g = c.g * c.a, b = c.b * c.a;
+    y = r * 0.29889531f + g * 0.58662247f + b * 0.11448223f;
+    i = r * 0.59597799f - g * 0.27417610f - b * 0.32180189f;
+    q = r * 0.21147017f - g * 0.52261711f + b * 0.31114694f;
+}
+
+static float distance (ALLEGRO_COLOR a, ALLEGRO_COLOR b) {
+    float y1 = 0, i1 = 0, q1 = 0, y2 = 0, i2 = 0, q2 = 0;
+    yiq (a, y1, i1, q1);
+    yiq (b, y2, i2, q2);
+    float dy = y1 - y2, di = i1 - i2, dq = q1 - q2;
+    return 0.5053f * dy * dy + 0.299f * di * di + 0.1957f * dq * dq;
+}
+
+int main (int argc, char **argv) {
+
+    static struct option long_opts[] = {
+        { "threshold", required_argument, NULL, 't' },
+        { "max", required_argument, NULL, 'm' },
+        { "diff", required_argument, NULL, 'd' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    /* largest value distance () can take (black vs. white) */
+    const float max_delta = 0.5053f;
+    float threshold = 0.1f;
+    double max_fraction = 0.0;
+    const char *diff_path = NULL;
+    int opt = 0;
+
+    while (-1 != (opt = getopt_long (argc, argv, "t:m:d:h", long_opts, NULL))) {
+        switch (opt) {
+            case 't':
+                threshold = atof (optarg);
+                break;
+            case 'm':
+                max_fraction = atof (optarg);
+                break;
+            case 'd':
+                diff_path = optarg;
+                break;
+            default:
+                usage (argv[0]);
+        }
+    }
+
+    if (optind + 2 != argc) {
+        usage (argv[0]);
+    }
+
+    if (! al_init () || ! al_init_image_addon ()) {
+        fprintf (stderr, "Failed to init allegro\n");
+        return 2;
+    }
+
+    al_set_new_bitmap_flags (ALLEGRO_MEMORY_BITMAP);
+
+    ALLEGRO_BITMAP *expected = al_load_bitmap (argv[optind]);
+    ALLEGRO_BITMAP *actual = al_load_bitmap (argv[optind + 1]);
+    if (NULL == expected || NULL == actual) {
+        fprintf (stderr, "Failed to load %s\n", 
+                NULL == expected ? argv[optind] : argv[optind + 1]);
+        return 2;
+    }
+
+    int w = al_get_bitmap_width (expected), h = al_get_bitmap_height (expected);
+    if (w != al_get_bitmap_width (actual) || 
+            h != al_get_bitmap_height (actual)) {
+        fprintf (stderr, "%s: size %dx%d differs from %dx%d\n", argv[optind + 1],
+                al_get_bitmap_width (actual), al_get_bitmap_height (actual), 
+                w, h);
+        return 1;
+    }
+
+    ALLEGRO_BITMAP *diff = NULL;
+    if (NULL != diff_path) {
+        diff = al_create_bitmap (w, h);
+        al_set_target_bitmap (diff);
+        al_lock_bitmap (diff, ALLEGRO_PIXEL_FORMAT_ANY, ALLEGRO_LOCK_WRITEONLY);
+    }
+
+    al_lock_bitmap (expected, ALLEGRO_PIXEL_FORMAT_ANY, ALLEGRO_LOCK_READONLY);
+    al_lock_bitmap (actual, ALLEGRO_PIXEL_FORMAT_ANY, ALLEGRO_LOCK_READONLY);
+
+    long ndiff = 0;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            ALLEGRO_COLOR a = al_get_pixel (expected, x, y);
+            ALLEGRO_COLOR b = al_get_pixel (actual, x, y);
+            bool differs = distance (a, b) > threshold * threshold * max_delta;
+            if (differs) { ++ndiff; }
+            if (NULL != diff) {
+                if (differs) {
+                    al_put_pixel (x, y, al_map_rgb (255, 0, 0));
+                } else {
+                    /* faded copy of the expected image for context */
+                    float l = 0, i = 0, q = 0;
+                    yiq (a, l, i, q);
+                    unsigned char v = static_cast< unsigned char >(
+                            64 + 64 * std::min (1.0f, std::max (0.0f, l)));
+                    al_put_pixel (x, y, al_map_rgb (v, v, v));
+                }
+            }
+        }
+    }
+
+    al_unlock_bitmap (expected);
+    al_unlock_bitmap (actual);
+
+    if (NULL != diff) {
+        al_unlock_bitmap (diff);
+        if (! al_save_bitmap (diff_path, diff)) {
+            fprintf (stderr, "Failed to write %s\n", diff_path);
+        }
+        al_destroy_bitmap (diff);
+    }
+
+    double fraction = static_cast< double >(ndiff) / 
+        static_cast< double >(w) / static_cast< double >(h);
+    bool match = fraction <= max_fraction;
+
+    if (! match) {
+        fprintf (stderr, "%s: %ld pixels (%0.4f%%) differ from %s\n", 
+                argv[optind + 1], ndiff, 100.0 * fraction, argv[optind]);
+    }
+
+    al_destroy_bitmap (expected);
+    al_destroy_bitmap (actual);
+
+    return match ? 0 : 1;
+}
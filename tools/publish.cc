@@ -0,0 +1,141 @@
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <zmq.h>
+
+extern "C" {
+#include <getopt.h>
+}
+
+/*
+ * Test/benchmark source for 'tandem --listen' / '--subscribe'.
+ *
+ * Sends [points] random points in batches of [batch] using the ingest
+ * wire format (pairs of native endian doubles) and reports the rate.
+ * Buffers are handed to 0MQ without copying. With PUSH the close waits
+ * for every batch to reach tandem, so the reported rate includes the
+ * receiving side; PUB does not wait for slow subscribers.
+ */
+
+static void usage (const char *prog) {
+    fprintf (stderr, "USAGE: %s [options] <endpoint>\n", prog);
+    fprintf (stderr, "-------------------\n");
+    fprintf (stderr, " -n, --points <n>  Total number of points (default 1e6)\n");
+    fprintf (stderr, " -b, --batch <n>   Points per message (default 4096)\n");
+    fprintf (stderr, " -r, --rate <n>    Limit to <n> points/sec (default unlimited)\n");
+    fprintf (stderr, " -u, --uniform     Uniform points instead of normal\n");
+    fprintf (stderr, " -p, --pub         Bind a PUB socket (for --subscribe) instead\n");
+    fprintf (stderr, "                   of connecting PUSH (for --listen)\n");
+    fprintf (stderr, "\n");
+    exit (42);
+}
+
+static void release (void *data, void *) {
+    delete [] static_cast< double * >(data);
+}
+
+int main (int argc, char **argv) {
+
+    static struct option long_opts[] = {
+        { "points", required_argument, NULL, 'n' },
+        { "batch", required_argument, NULL, 'b' },
+        { "rate", required_argument, NULL, 'r' },
+        { "uniform", no_argument, NULL, 'u' },
+        { "pub", no_argument, NULL, 'p' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    long total = 1000000, batch = 4096;
+    double rate = 0.0;
+    bool uniform = false, pub = false;
+    int opt = 0;
+
+    while (-1 != (opt = getopt_long (argc, argv, "n:b:r:uph", 
+                    long_opts, NULL))) {
+        switch (opt) {
+            case 'n':
+                total = static_cast< long >(atof (optarg));
+                break;
+            case 'b':
+                batch = static_cast< long >(atof (optarg));
+                break;
+            case 'r':
+                rate = atof (optarg);
+                break;
+            case 'u':
+                uniform = true;
+                break;
+            case 'p':
+                pub = true;
+                break;
+            default:
+                usage (argv[0]);
+        }
+    }
+
+    if (optind + 1 != argc || total <= 0 || batch <= 0) {
+        usage (argv[0]);
+    }
+
+    const char *endpoint = argv[optind];
+    void *ctx = zmq_ctx_new ();
+    void *sock = zmq_socket (ctx, pub ? ZMQ_PUB : ZMQ_PUSH);
+    int rc = pub ? zmq_bind (sock, endpoint) : zmq_connect (sock, endpoint);
+    if (0 != rc) {
+        fprintf (stderr, "%s: %s\n", endpoint, zmq_strerror (zmq_errno ()));
+        return 1;
+    }
+
+    if (pub) {
+        /* give subscribers a chance to connect before anything is lost */
+        std::this_thread::sleep_for (std::chrono::seconds (1));
+    }
+
+    std::mt19937_64 rng (42);
+    std::normal_distribution< double > normal (0.0, 1.0);
+    std::uniform_real_distribution< double > flat (0.0, 1.0);
+
+    Clock::time_point start = Clock::now ();
+    long sent = 0;
+    while (sent < total) {
+        long n = std::min (batch, total - sent);
+        double *buf = new double[2 * n];
+        for (long i = 0; i < 2 * n; ++i) {
+            buf[i] = uniform ? flat (rng) : normal (rng);
+        }
+
+        zmq_msg_t msg;
+        zmq_msg_init_data (&msg, buf, 2 * n * sizeof (double), release, NULL);
+        if (-1 == zmq_msg_send (&msg, sock, 0)) {
+            fprintf (stderr, "send: %s\n", zmq_strerror (zmq_errno ()));
+            zmq_msg_close (&msg);
+            break;
+        }
+        sent += n;
+
+        if (rate > 0.0) {
+            std::this_thread::sleep_until (start + 
+                    std::chrono::duration< double >(sent / rate));
+        }
+    }
+
+    /* PUSH blocks here until everything has been delivered */
+    zmq_close (sock);
+    zmq_ctx_term (ctx);
+
+    std::chrono::duration< double > d = Clock::now () - start;
+    printf ("sent %ld points in %ld byte batches over %0.3fs: "
+            "%0.0f points/sec\n", sent, 
+            static_cast< long >(batch * 2 * sizeof (double)), d.count (), 
+            sent / d.count ());
+
+    return sent == total ? 0 : 1;
+}
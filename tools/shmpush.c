@@ -0,0 +1,136 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <net/shmring.h>
+
+/*
+ * Test/benchmark producer for 'tandem --shm <name>'. Written in C
+ * against include/net/shmring.h alone, as an acquisition process would
+ * be.
+ *
+ * Writes [points] random points in batches of [batch], spinning while
+ * the ring is full (or dropping with --drop), and reports the rate.
+ */
+
+static void usage (const char *prog) {
+    fprintf (stderr, "USAGE: %s [options] <name>\n", prog);
+    fprintf (stderr, "-------------------\n");
+    fprintf (stderr, " -n, --points <n>  Total number of points (default 1e7)\n");
+    fprintf (stderr, " -b, --batch <n>   Points per write (default 4096)\n");
+    fprintf (stderr, " -d, --drop        Drop what does not fit instead of waiting\n");
+    fprintf (stderr, "\n");
+    exit (42);
+}
+
+static double now (void) {
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Box-Muller from a xorshift generator; cheap enough not to dominate */
+static uint64_t rng_state = 88172645463325252ull;
+
+static double uniform (void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double normal (void) {
+    double u = uniform (), v = uniform ();
+    return sqrt (-2.0 * log (u + 1e-300)) * cos (2.0 * M_PI * v);
+}
+
+int main (int argc, char **argv) {
+
+    static struct option long_opts[] = {
+        { "points", required_argument, NULL, 'n' },
+        { "batch", required_argument, NULL, 'b' },
+        { "drop", no_argument, NULL, 'd' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    long total = 10000000, batch = 4096, sent = 0, dropped = 0, full = 0;
+    int drop = 0, opt = 0;
+    struct tandem_shm_header *ring = NULL;
+    struct tandem_shm_record *recs = NULL;
+    double start = 0.0, elapsed = 0.0;
+
+    while (-1 != (opt = getopt_long (argc, argv, "n:b:dh", long_opts, NULL))) {
+        switch (opt) {
+            case 'n':
+                total = (long) atof (optarg);
+                break;
+            case 'b':
+                batch = (long) atof (optarg);
+                break;
+            case 'd':
+                drop = 1;
+                break;
+            default:
+                usage (argv[0]);
+        }
+    }
+
+    if (optind + 1 != argc || total <= 0 || batch <= 0) {
+        usage (argv[0]);
+    }
+
+    /* tandem creates the ring; wait up to 10s for it */
+    for (int i = 0; i < 1000 && NULL == (ring = tandem_shm_attach (argv[optind])); ++i) {
+        usleep (10000);
+    }
+    if (NULL == ring) {
+        fprintf (stderr, "%s: no ring (is 'tandem --shm %s' running?)\n",
+                argv[optind], argv[optind]);
+        return 1;
+    }
+
+    recs = malloc (batch * sizeof (*recs));
+    if (NULL == recs) {
+        fprintf (stderr, "Memory error\n");
+        return 1;
+    }
+
+    start = now ();
+    while (sent + dropped < total) {
+        long n = batch < total - sent - dropped ? batch : total - sent - dropped;
+        long done = 0;
+        for (long i = 0; i < n; ++i) {
+            recs[i].x = normal ();
+            recs[i].y = normal ();
+        }
+        while (done < n) {
+            uint64_t w = tandem_shm_write (ring, recs + done, n - done);
+            done += (long) w;
+            if (done < n) {
+                ++full;
+                if (drop) {
+                    dropped += n - done;
+                    break;
+                }
+                usleep (50);
+            }
+        }
+        sent += done;
+    }
+
+    /* wait for tandem to take the rest so the rate covers both sides */
+    while (0 < tandem_shm_pending (ring)) {
+        usleep (100);
+    }
+    elapsed = now () - start;
+
+    printf ("sent %ld points (%ld dropped, ring full %ld times) in %0.3fs: "
+            "%0.0f points/sec\n", sent, dropped, full, elapsed, sent / elapsed);
+
+    free (recs);
+    tandem_shm_detach (ring);
+    return 0;
+}